@@ -0,0 +1,363 @@
+//===-- jcut/CSVReader.cpp - Streaming CSV reader ---------------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "CSVReader.h"
+#include "TestParser.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace llvm;
+
+namespace {
+
+// Bytes that end a field or change the meaning of the commas that follow.
+inline bool isSpecial(char c)
+{
+	switch(c) {
+	case ',': case '\n':
+	case '"': case '\'':
+	case '{': case '}':
+	case '[': case ']':
+		return true;
+	}
+	return false;
+}
+
+// Returns the position of the first special byte in [p, end), or end.
+const char* findSpecial(const char* p, const char* end)
+{
+#ifdef __SSE2__
+	// Looks at 16 bytes at once, most of the bytes of a data file are digits.
+	const __m128i comma = _mm_set1_epi8(',');
+	const __m128i newline = _mm_set1_epi8('\n');
+	const __m128i dquote = _mm_set1_epi8('"');
+	const __m128i squote = _mm_set1_epi8('\'');
+	// '[' is 0x5B and '{' is 0x7B, ']' is 0x5D and '}' is 0x7D. Setting
+	// the bit 0x20 lets us look for both brackets with a single compare.
+	const __m128i lower = _mm_set1_epi8(0x20);
+	const __m128i open = _mm_set1_epi8('{');
+	const __m128i close = _mm_set1_epi8('}');
+	while(end - p >= 16) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i folded = _mm_or_si128(chunk, lower);
+		__m128i found = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, comma), _mm_cmpeq_epi8(chunk, newline)),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, dquote), _mm_cmpeq_epi8(chunk, squote)));
+		found = _mm_or_si128(found,
+				_mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)));
+		int mask = _mm_movemask_epi8(found);
+		if(mask)
+			return p + __builtin_ctz(mask);
+		p += 16;
+	}
+#endif
+	while(p < end && !isSpecial(*p))
+		++p;
+	return p;
+}
+
+// p points to the opening quote. Returns the position of the closing quote
+// or nullptr when the constant is not terminated. Escaped characters are
+// skipped the same way the tokenizer does: "say \"hi\"".
+const char* skipQuoted(const char* p, const char* end, unsigned& line)
+{
+	char quote = *p++;
+	while(p < end) {
+		if(*p == '\\') {
+			if(p + 1 < end && p[1] == '\n')
+				++line;
+			p += 2;
+			continue;
+		}
+		if(*p == quote)
+			return p;
+		if(*p == '\n') {
+			if(quote == '\'')
+				return nullptr; // Char constants can not span lines
+			++line;
+		}
+		++p;
+	}
+	return nullptr;
+}
+
+// Whether the quote at p begins a string or a char constant: the first
+// thing of a field or of an initializer, optionally after an L prefix. In
+// a field like don't the quote is just another byte.
+bool opensQuoted(const char* row, const char* p)
+{
+	if(p > row && p[-1] == 'L')
+		--p;
+	while(p > row && (p[-1] == ' ' || p[-1] == '\t' || p[-1] == '\r'))
+		--p;
+	return p == row || p[-1] == ',' || p[-1] == '{' || p[-1] == '[';
+}
+
+StringRef trim(const char* begin, const char* end)
+{
+	while(begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+		++begin;
+	while(end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+		--end;
+	return StringRef(begin, end - begin);
+}
+
+} // anonymous namespace
+
+namespace tp {
+
+CSVReader::CSVReader(const string& path) : mPath(path), mData(nullptr),
+	mSize(0), mPos(nullptr), mLine(1), mRowLine(0), mColumns(0), mRows(0)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd == -1)
+		throw JCUTException("CSV File: "+path+" not found!");
+	struct stat st;
+	if(fstat(fd, &st) == -1) {
+		close(fd);
+		throw JCUTException("CSV File: "+path+" could not be read!");
+	}
+	mSize = st.st_size;
+	if(mSize) {
+		void* addr = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(addr == MAP_FAILED) {
+			close(fd);
+			throw JCUTException("CSV File: "+path+" could not be mapped in memory!");
+		}
+		madvise(addr, mSize, MADV_SEQUENTIAL);
+		mData = static_cast<const char*>(addr);
+	}
+	// The mapping stays valid after closing the file
+	close(fd);
+	mPos = mData;
+}
+
+CSVReader::~CSVReader()
+{
+	if(mData)
+		munmap(const_cast<char*>(mData), mSize);
+}
+
+void CSVReader::parseError(const string& msg, unsigned line) const
+{
+	stringstream ss;
+	ss << "CSV File: " << mPath << ":" << line << ": " << msg;
+	throw JCUTException(ss.str());
+}
+
+bool CSVReader::nextRow(vector<StringRef>& fields)
+{
+	const char* end = mData + mSize;
+	while(mPos < end) {
+		fields.clear();
+		mRowLine = mLine;
+		const char* begin = mPos;
+		const char* p = mPos;
+		unsigned depth = 0;
+		for(;;) {
+			p = findSpecial(p, end);
+			if(p == end) {
+				if(depth)
+					parseError("Missing closing bracket", mRowLine);
+				fields.push_back(trim(begin, p));
+				break;
+			}
+			char c = *p;
+			if(c == '\n') {
+				if(depth)
+					parseError("Missing closing bracket", mRowLine);
+				fields.push_back(trim(begin, p++));
+				++mLine;
+				break;
+			}
+			if(c == ',') {
+				if(depth == 0) {
+					fields.push_back(trim(begin, p));
+					begin = p + 1;
+				}
+			} else if(c == '"' || c == '\'') {
+				if(opensQuoted(mPos, p) == false) {
+					++p;
+					continue;
+				}
+				unsigned line = mLine;
+				p = skipQuoted(p, end, mLine);
+				if(p == nullptr)
+					parseError(string("Missing closing ") + c, line);
+			} else if(c == '{' || c == '[') {
+				++depth;
+			} else { // '}' or ']'
+				if(depth == 0)
+					parseError(string("Unexpected ") + c, mLine);
+				--depth;
+			}
+			++p;
+		}
+		mPos = p;
+
+		if(fields.size() == 1 && fields[0].empty())
+			continue; // Blank line
+		// A trailing comma does not add a new column
+		if(fields.size() > 1 && fields.back().empty())
+			fields.pop_back();
+		for(StringRef field : fields)
+			if(field.empty())
+				parseError("Empty field", mRowLine);
+
+		if(mRows == 0)
+			mColumns = fields.size();
+		else if(fields.size() != mColumns) {
+			stringstream ss;
+			ss << "Column mismatch, expected " << mColumns << " columns but found "
+			   << fields.size();
+			parseError(ss.str(), mRowLine);
+		}
+		++mRows;
+		return true;
+	}
+	return false;
+}
+
+void CSVReader::rewind()
+{
+	mPos = mData;
+	mLine = 1;
+	mRowLine = 0;
+	mColumns = 0;
+	mRows = 0;
+}
+
+bool CSVReader::parseInt(StringRef field, int64_t& value)
+{
+	if(field.startswith("'")) {
+		char c = 0;
+		if(!parseChar(field, c))
+			return false;
+		value = c;
+		return true;
+	}
+	bool negative = false;
+	if(field.startswith("-") || field.startswith("+")) {
+		negative = field.front() == '-';
+		field = field.substr(1);
+	}
+	// Drop the integer suffixes: 10u, 10L, 10ULL
+	field = field.substr(0, field.find_last_not_of("uUlL") + 1);
+	unsigned long long magnitude = 0;
+	// Radix 0 detects hexadecimal (0x) and octal (0) constants
+	if(field.empty() || field.getAsInteger(0, magnitude))
+		return false;
+	// Unsigned values use all the 64 bits, negative ones only 63
+	if(negative && magnitude > (1ULL << 63))
+		return false;
+	value = negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+	return true;
+}
+
+bool CSVReader::isInteger(StringRef field)
+{
+	if(field.startswith("-") || field.startswith("+"))
+		field = field.substr(1);
+	field = field.substr(0, field.find_last_not_of("uUlL") + 1);
+	bool hex = field.startswith("0x") || field.startswith("0X");
+	if(hex)
+		field = field.substr(2);
+	if(field.empty())
+		return false;
+	for(char c : field)
+		if(!(hex ? isxdigit(c) : isdigit(c)))
+			return false;
+	return true;
+}
+
+bool CSVReader::parseFloat(StringRef field, double& value)
+{
+	if(field.endswith("f") || field.endswith("F") ||
+	   field.endswith("l") || field.endswith("L"))
+		field = field.substr(0, field.size() - 1);
+	// strtod needs a null terminated string, the fields are not.
+	char buffer[64];
+	if(field.empty() || field.size() >= sizeof(buffer))
+		return false;
+	memcpy(buffer, field.data(), field.size());
+	buffer[field.size()] = '\0';
+	char* parsed = nullptr;
+	value = strtod(buffer, &parsed);
+	return parsed == buffer + field.size();
+}
+
+bool CSVReader::parseChar(StringRef field, char& value)
+{
+	if(field.size() < 3 || field.front() != '\'' || field.back() != '\'')
+		return false;
+	StringRef body = field.substr(1, field.size() - 2);
+	if(body[0] != '\\') {
+		value = body[0];
+		return body.size() == 1;
+	}
+	if(body.size() < 2)
+		return false;
+	unsigned number = 0;
+	switch(body[1]) {
+	case 'n': value = '\n'; break;
+	case 't': value = '\t'; break;
+	case 'r': value = '\r'; break;
+	case 'a': value = '\a'; break;
+	case 'b': value = '\b'; break;
+	case 'f': value = '\f'; break;
+	case 'v': value = '\v'; break;
+	case '\\': value = '\\'; break;
+	case '\'': value = '\''; break;
+	case '"': value = '"'; break;
+	case '?': value = '?'; break;
+	case 'x':
+		if(body.substr(2).getAsInteger(16, number) || number > 0xFF)
+			return false;
+		value = static_cast<char>(number);
+		return true;
+	default: // Octal: '\0', '\101'
+		if(body.substr(1).getAsInteger(8, number) || number > 0xFF)
+			return false;
+		value = static_cast<char>(number);
+		return true;
+	}
+	return body.size() == 2;
+}
+
+} // namespace tp
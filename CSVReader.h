@@ -0,0 +1,100 @@
+//===-- jcut/CSVReader.h - Streaming CSV reader -----------------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Reads the data files used by the DataPlaceholders one row at a time.
+///
+/// The file is mapped in memory and every field is returned as a StringRef
+/// pointing inside the mapping, no row or field is ever copied.
+///
+/// A field is split on the commas that are not part of a string constant
+/// ("a, b"), a char constant (',') or a buffer or struct initializer
+/// ([4:{1,2}] or {1,2}). Double quoted fields may span several lines.
+/// Spaces around a field are ignored and blank lines are skipped.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef CSVREADER_H_
+#define CSVREADER_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "llvm/ADT/StringRef.h"
+
+using namespace std;
+
+namespace tp {
+
+class CSVReader {
+private:
+	string mPath;
+	const char* mData;
+	size_t mSize;
+	// Current position inside the mapping
+	const char* mPos;
+	// Line of the file where the next row starts, used for error messages
+	unsigned mLine;
+	// Line of the file where the last row read starts
+	unsigned mRowLine;
+	// Number of fields of the first row, every row must have the same count
+	unsigned mColumns;
+	unsigned mRows;
+
+	void parseError(const string& msg, unsigned line) const;
+public:
+	explicit CSVReader(const string& path);
+	CSVReader(const CSVReader&) = delete;
+	CSVReader& operator=(const CSVReader&) = delete;
+	~CSVReader();
+
+	/// Reads the next row into fields. Returns false at the end of the file.
+	bool nextRow(vector<llvm::StringRef>& fields);
+	/// Starts reading again from the first row.
+	void rewind();
+
+	const string& getPath() const { return mPath; }
+	/// Number of columns of the first row, 0 until a row has been read.
+	unsigned columnCount() const { return mColumns; }
+	/// Number of rows read so far.
+	unsigned rowCount() const { return mRows; }
+	/// Line of the file where the last row read starts.
+	unsigned lineNumber() const { return mRowLine; }
+
+	/// Parses an integer constant: decimal, octal or hexadecimal with an
+	/// optional sign and suffix (10, -0x1F, 7u) or a char constant ('a', '\n').
+	static bool parseInt(llvm::StringRef field, int64_t& value);
+	/// Whether the field is written as an integer constant, even one too
+	/// big for parseInt().
+	static bool isInteger(llvm::StringRef field);
+	/// Parses a floating point constant (2.5, 1e3, 0.5f). Integers are
+	/// accepted too.
+	static bool parseFloat(llvm::StringRef field, double& value);
+	/// Parses a char constant ('a', '\n', '\x41').
+	static bool parseChar(llvm::StringRef field, char& value);
+};
+
+} // namespace tp
+
+#endif /* CSVREADER_H_ */
@@ -0,0 +1,316 @@
+//===-- jcut/Daemon.cpp - jcut --server and --client ------------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "Daemon.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "TestParser.h"
+
+namespace jcut {
+
+namespace {
+
+const char RecordSeparator = '\x1E';
+
+/// Absolute path of an existing file, a glob is left as is
+string makeAbsolute(const string& path)
+{
+	char buf[PATH_MAX];
+	if(realpath(path.c_str(), buf) == nullptr)
+		return path;
+	return buf;
+}
+
+bool writeAll(int fd, const string& data)
+{
+	size_t written = 0;
+	while(written < data.size()) {
+		ssize_t rc = write(fd, data.data() + written, data.size() - written);
+		if(rc == -1 && errno == EINTR)
+			continue;
+		if(rc <= 0)
+			return false;
+		written += rc;
+	}
+	return true;
+}
+
+string getDirectory(const string& path)
+{
+	string::size_type slash = path.rfind('/');
+	if(slash == string::npos)
+		return ".";
+	return path.substr(0, slash ? slash : 1);
+}
+
+/// Throws a JCUTException when another user could replace the socket: its
+/// directory must belong to the user, or to root, and be writable only by
+/// its owner unless it has the sticky bit, as /tmp does.
+void checkSocketDirectory(const string& path)
+{
+	string dir = getDirectory(path);
+	struct stat st;
+	if(lstat(dir.c_str(), &st) == -1)
+		throw JCUTException("The directory of the socket "+path+" does not exist");
+	if(!S_ISDIR(st.st_mode) || (st.st_uid != getuid() && st.st_uid != 0) ||
+	   ((st.st_mode & (S_IWGRP | S_IWOTH)) && !(st.st_mode & S_ISVTX)))
+		throw JCUTException("The directory of the socket "+path+" is not safe, "
+				"it must belong to you and only you can write to it");
+}
+
+sockaddr_un getAddress(const string& path)
+{
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if(path.size() >= sizeof(address.sun_path))
+		throw JCUTException("The socket path "+path+" is too long");
+	strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+	return address;
+}
+
+} // anonymous namespace
+
+DaemonRequest DaemonRequest::fromCommandLine(int argc, const char** argv)
+{
+	DaemonRequest request;
+	char cwd[PATH_MAX];
+	if(getcwd(cwd, sizeof(cwd)) == nullptr)
+		throw JCUTException("Could not get the working directory");
+	request.mDirectory = cwd;
+	// The client does not parse its options with the clang tools, it is only
+	// given the source files, the test files and the socket. Any other
+	// option is an error.
+	for(int i = 1; i < argc; ++i) {
+		string arg(argv[i]);
+		if(arg == "--")
+			break;
+		// -t and --socket take their value as -option=value or as the next
+		// argument, like the options parsed by jcut.
+		string option = arg.substr(0, arg.find('='));
+		bool test_file = option == "-t" || option == "--t";
+		if(test_file || option == "-socket" || option == "--socket") {
+			string value;
+			if(option.size() < arg.size())
+				value = arg.substr(option.size() + 1);
+			else if(i + 1 < argc)
+				value = argv[++i];
+			else
+				throw JCUTException("The option "+arg+" of jcut --client needs a value");
+			if(test_file)
+				request.mTestFiles.push_back(makeAbsolute(value));
+		} else if(option == "-client" || option == "--client")
+			continue;
+		else if(arg[0] == '-')
+			// The server runs the tests with its own options
+			throw JCUTException("The option "+arg+" is not sent to the server, "
+					"give it to jcut --server instead");
+		else
+			request.mSources.push_back(makeAbsolute(arg));
+	}
+	return request;
+}
+
+string DaemonRequest::serialize() const
+{
+	stringstream ss;
+	ss << "dir " << mDirectory << "\n";
+	for(const string& source : mSources)
+		ss << "source " << source << "\n";
+	for(const string& test : mTestFiles)
+		ss << "test " << test << "\n";
+	ss << "end\n";
+	return ss.str();
+}
+
+DaemonRequest DaemonRequest::read(int fd)
+{
+	DaemonRequest request;
+	string data;
+	char buf[4096];
+	// A request is small, it is read whole before anything runs
+	while(data.size() < 4 || data.compare(data.size() - 4, 4, "end\n") != 0) {
+		ssize_t rc = ::read(fd, buf, sizeof(buf));
+		if(rc == -1 && errno == EINTR)
+			continue;
+		if(rc <= 0)
+			throw JCUTException("The client closed the connection before its request ended");
+		data.append(buf, rc);
+		if(data.size() > 1024*1024)
+			throw JCUTException("The request of the client is too long");
+	}
+
+	stringstream ss(data);
+	string line;
+	while(getline(ss, line)) {
+		string::size_type space = line.find(' ');
+		string key = line.substr(0, space);
+		string value = (space == string::npos) ? "" : line.substr(space + 1);
+		if(key == "dir")
+			request.mDirectory = value;
+		else if(key == "source")
+			request.mSources.push_back(value);
+		else if(key == "test")
+			request.mTestFiles.push_back(value);
+		else if(key != "end")
+			throw JCUTException("Invalid request line: "+line);
+	}
+	if(request.mSources.empty() || request.mTestFiles.empty())
+		throw JCUTException("A request needs at least one source file and one test file");
+	return request;
+}
+
+string getDefaultSocketPath()
+{
+	const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+	if(runtime_dir && runtime_dir[0] == '/')
+		return string(runtime_dir)+"/jcut.sock";
+	stringstream ss;
+	ss << "/tmp/jcut-" << getuid() << "/jcut.sock";
+	return ss.str();
+}
+
+bool isSameUser(int fd)
+{
+#ifdef SO_PEERCRED
+	ucred credentials;
+	socklen_t size = sizeof(credentials);
+	if(getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size) == -1)
+		return false;
+	return credentials.uid == getuid();
+#else
+	uid_t uid;
+	gid_t gid;
+	if(getpeereid(fd, &uid, &gid) == -1)
+		return false;
+	return uid == getuid();
+#endif
+}
+
+int listenOnSocket(const string& path)
+{
+	// The directory of the default socket in /tmp is made the first time
+	if(path == getDefaultSocketPath())
+		mkdir(getDirectory(path).c_str(), 0700);
+	checkSocketDirectory(path);
+	sockaddr_un address = getAddress(path);
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(fd == -1)
+		throw JCUTException("Could not create the socket "+path);
+	// The socket of a server that is running accepts the connection
+	if(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+		close(fd);
+		throw JCUTException("Another jcut server is listening on "+path);
+	}
+	unlink(path.c_str());
+	// Only the user running the server can connect to it
+	mode_t mask = umask(0077);
+	int rc = bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+	umask(mask);
+	if(rc == -1 || listen(fd, 16) == -1) {
+		close(fd);
+		throw JCUTException("Could not listen on the socket "+path+": "+strerror(errno));
+	}
+	return fd;
+}
+
+void writeExitStatus(int fd, unsigned tests_failed)
+{
+	stringstream ss;
+	ss << RecordSeparator << "jcut-exit " << tests_failed << "\n";
+	writeAll(fd, ss.str());
+}
+
+int runClient(const string& path, const DaemonRequest& request)
+{
+	int fd = -1;
+	try {
+		checkSocketDirectory(path);
+		sockaddr_un address = getAddress(path);
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if(fd == -1 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
+			throw JCUTException("Could not connect to the jcut server on "+path+
+					", start it with jcut --server");
+		// The sources and test files are only sent to a server of the user
+		if(!isSameUser(fd))
+			throw JCUTException("The server on "+path+" is run by another user");
+		if(!writeAll(fd, request.serialize()))
+			throw JCUTException("Could not send the request to the jcut server");
+	} catch(const JCUTException& e) {
+		if(fd != -1)
+			close(fd);
+		cerr << e.what() << endl;
+		return 255;
+	}
+
+	// Everything before the record separator is printed as it arrives
+	bool trailer = false;
+	string status;
+	char buf[4096];
+	for(;;) {
+		ssize_t rc = ::read(fd, buf, sizeof(buf));
+		if(rc == -1 && errno == EINTR)
+			continue;
+		if(rc <= 0)
+			break;
+		const char* begin = buf;
+		const char* end = buf + rc;
+		const char* separator = trailer ? begin : find(begin, end, RecordSeparator);
+		if(!trailer) {
+			cout.write(begin, separator - begin);
+			cout.flush();
+			if(separator == end)
+				continue;
+			trailer = true;
+			++separator;
+		}
+		status.append(separator, end);
+	}
+	close(fd);
+
+	unsigned failed = 0;
+	if(!trailer || sscanf(status.c_str(), "jcut-exit %u", &failed) != 1) {
+		cerr << "The jcut server closed the connection before the tests ended" << endl;
+		return 255;
+	}
+	return failed > 255 ? 255 : failed;
+}
+
+} /* namespace jcut */
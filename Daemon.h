@@ -0,0 +1,97 @@
+//===-- jcut/Daemon.h - jcut --server and --client --------------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief The requests jcut --client sends to jcut --server.
+///
+/// The server listens on a Unix domain socket and keeps the modules of the
+/// source files it compiled, a request only compiles the source files that
+/// are new to it or changed. A request is a few lines of text:
+///
+///   dir <working directory of the client>
+///   source <absolute path of a C source file>
+///   test <test file, directory or glob given with -t>
+///   end
+///
+/// The server writes back what jcut writes to standard output and error
+/// while the tests run, as they run. Then the record separator character,
+/// 0x1E, followed by "jcut-exit <tests failed>".
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef DAEMON_H_
+#define DAEMON_H_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace jcut {
+
+struct DaemonRequest {
+	string mDirectory;
+	vector<string> mSources;
+	vector<string> mTestFiles;
+
+	DaemonRequest() : mDirectory(), mSources(), mTestFiles() {}
+
+	/// The request of the command line of jcut --client: the source files
+	/// and the -t test files, made absolute. The compiler flags after -- are
+	/// the ones of the server, the client ones are ignored. Any option other
+	/// than -t and --socket throws a JCUTException, the server runs the
+	/// tests with the options it was started with.
+	static DaemonRequest fromCommandLine(int argc, const char** argv);
+
+	string serialize() const;
+	/// Reads a request from a client, throws a JCUTException when it is
+	/// invalid or the client went away.
+	static DaemonRequest read(int fd);
+};
+
+/// $XDG_RUNTIME_DIR/jcut.sock, or /tmp/jcut-<user id>/jcut.sock when
+/// XDG_RUNTIME_DIR is not set.
+string getDefaultSocketPath();
+
+/// Whether the process at the other end of the Unix domain socket runs as
+/// the user running jcut.
+bool isSameUser(int fd);
+
+/// Creates the socket of the server, a socket left by another server that
+/// is not running is replaced. The directory of the default socket is
+/// created, only the user can use it. Throws a JCUTException on errors, and
+/// when the directory of the socket belongs to another user or others can
+/// write to it.
+int listenOnSocket(const string& path);
+
+/// The last line the server writes for a request
+void writeExitStatus(int fd, unsigned tests_failed);
+
+/// Sends the request to the server and prints what it writes back. Returns
+/// the number of tests failed, up to 255, or 255 when the server could not
+/// be reached or is run by another user.
+int runClient(const string& path, const DaemonRequest& request);
+
+} /* namespace jcut */
+
+#endif /* DAEMON_H_ */
@@ -0,0 +1,146 @@
+//===-- jcut/FileWatcher.cpp - Changes of the watched files -----*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "FileWatcher.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <poll.h>
+#include <unistd.h>
+#ifndef __MINGW32__
+#include <sys/inotify.h>
+#endif
+
+#include "TestParser.h"
+
+namespace jcut {
+
+FileWatcher::FileWatcher() : mFd(-1), mDirs(), mFiles()
+{
+#ifdef __MINGW32__
+	throw JCUTException("--watch is not supported in this platform");
+#else
+	mFd = inotify_init1(IN_CLOEXEC);
+	if(mFd == -1)
+		throw JCUTException("Could not initialize inotify to watch the files");
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+	if(mFd != -1)
+		close(mFd);
+}
+
+string FileWatcher::getRealPath(const string& path)
+{
+	char buf[PATH_MAX];
+	if(realpath(path.c_str(), buf) == nullptr)
+		return path;
+	return buf;
+}
+
+void FileWatcher::addFile(const string& file)
+{
+#ifndef __MINGW32__
+	string path = getRealPath(file);
+	string::size_type slash = path.find_last_of('/');
+	string dir = (slash == string::npos) ? "." : path.substr(0, slash);
+	string name = (slash == string::npos) ? path : path.substr(slash + 1);
+	if(dir.empty())
+		dir = "/";
+	if(mFiles.count(dir) == 0) {
+		int wd = inotify_add_watch(mFd, dir.c_str(),
+				IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+		if(wd == -1)
+			throw JCUTException("Could not watch the directory "+dir);
+		mDirs[wd] = dir;
+	}
+	mFiles[dir].insert(name);
+#endif
+}
+
+void FileWatcher::clear()
+{
+#ifndef __MINGW32__
+	for(auto& it : mDirs)
+		inotify_rm_watch(mFd, it.first);
+#endif
+	mDirs.clear();
+	mFiles.clear();
+}
+
+void FileWatcher::readEvents(set<string>& changed)
+{
+#ifndef __MINGW32__
+	// Aligned as the events it holds
+	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	ssize_t size = read(mFd, buf, sizeof(buf));
+	if(size == -1) {
+		if(errno == EINTR || errno == EAGAIN)
+			return;
+		throw JCUTException("Could not read the changes of the watched files");
+	}
+	for(char* p = buf; p < buf + size; ) {
+		const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+		p += sizeof(struct inotify_event) + event->len;
+		auto dir = mDirs.find(event->wd);
+		if(dir == mDirs.end() || event->len == 0)
+			continue;
+		// The editors write other files in the same directory
+		if(mFiles[dir->second].count(event->name))
+			changed.insert(dir->second + "/" + event->name);
+	}
+#endif
+}
+
+vector<string> FileWatcher::wait(unsigned delay_ms)
+{
+	set<string> changed;
+	struct pollfd pfd;
+	pfd.fd = mFd;
+	pfd.events = POLLIN;
+	// Waits as long as needed for the first change
+	int timeout = -1;
+	for(;;) {
+		pfd.revents = 0;
+		int rc = poll(&pfd, 1, timeout);
+		if(rc == -1 && errno != EINTR)
+			throw JCUTException("Could not wait for the changes of the watched files");
+		if(rc > 0)
+			readEvents(changed);
+		else if(rc == 0 && changed.size())
+			break;
+		if(changed.size())
+			timeout = delay_ms;
+	}
+	return vector<string>(changed.begin(), changed.end());
+}
+
+} /* namespace jcut */
@@ -0,0 +1,78 @@
+//===-- jcut/FileWatcher.h - Changes of the watched files -------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Waits for changes of the files used by --watch.
+///
+/// The directories of the files are watched with inotify, not the files
+/// themselves: most editors save a file by writing a new one and renaming it
+/// over the old one, the inotify watch of a file would stay on the old one.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef FILEWATCHER_H_
+#define FILEWATCHER_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace jcut {
+
+class FileWatcher {
+private:
+	int mFd;
+	// Watch descriptor of every directory and the files watched in it
+	map<int, string> mDirs;
+	map<string, set<string>> mFiles;
+
+	/// Reads the pending events, adds the watched files that changed
+	void readEvents(set<string>& changed);
+public:
+	/// Throws a JCUTException when inotify is not available
+	FileWatcher();
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+	~FileWatcher();
+
+	/// Starts watching path, a file watched already is ignored
+	void addFile(const string& path);
+	/// Stops watching all the files
+	void clear();
+
+	/// Blocks until at least one of the files changed. The changes that
+	/// follow within delay_ms are returned with it, saving a file often
+	/// takes more than one write.
+	vector<string> wait(unsigned delay_ms = 100);
+
+	/// The absolute path of a file without symbolic links, as returned by
+	/// wait(). The path itself when it can not be resolved.
+	static string getRealPath(const string& path);
+};
+
+} /* namespace jcut */
+
+#endif /* FILEWATCHER_H_ */
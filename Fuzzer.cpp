@@ -0,0 +1,672 @@
+//===-- jcut/Fuzzer.cpp - Coverage guided fuzzing ---------------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "Fuzzer.h"
+#include "TestParser.h"
+
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <limits>
+#include <set>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace llvm;
+
+namespace {
+
+// Hit counts are grouped the same way AFL does: an input is interesting when
+// it takes an edge a number of times in a bucket not seen before.
+uint8_t countBucket(uint8_t count)
+{
+	if(count <= 2) return count;
+	if(count == 3) return 4;
+	if(count < 8) return 8;
+	if(count < 16) return 16;
+	if(count < 32) return 32;
+	if(count < 128) return 64;
+	return 128;
+}
+
+// FNV-1a, names the files of the corpus after their content
+uint64_t hashInput(const vector<uint8_t>& input)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for(uint8_t byte : input) {
+		hash ^= byte;
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+double now()
+{
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+const uint64_t InterestingValues[] = {
+	0, 1, 0x7F, 0x80, 0xFF, 0x7FFF, 0x8000, 0xFFFF,
+	0x7FFFFFFF, 0x80000000, 0xFFFFFFFF,
+	0x7FFFFFFFFFFFFFFFULL, 0x8000000000000000ULL, 0xFFFFFFFFFFFFFFFFULL
+};
+
+const int CrashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+const unsigned CrashSignalCount = sizeof(CrashSignals)/sizeof(CrashSignals[0]);
+
+} // anonymous namespace
+
+namespace jcut {
+
+Fuzzer* Fuzzer::sActive = nullptr;
+
+Fuzzer::Fuzzer(llvm::Module* module, const string& function) : mModule(module),
+	mTarget(module->getFunction(function)), mHarness(nullptr),
+	mCountersGlobal(nullptr), mHeaderSize(0), mEdges(0), mCoveredEdges(0),
+	mSeed(0), mRandomCount(0), mStatusFd(-1), mCrashFd(-1)
+{
+	if(mTarget == nullptr || mTarget->isDeclaration())
+		throw JCUTException("Function "+function+" not found in the loaded source files");
+	if(mTarget->isVarArg())
+		throw JCUTException("Variadic function "+function+" can not be fuzzed");
+
+	for(Function::arg_iterator a = mTarget->arg_begin(); a != mTarget->arg_end(); ++a) {
+		FuzzArgument arg = {FuzzArgument::VALUE, a->getType(), 0, 0};
+		llvm::Type* type = a->getType();
+		if(type->isPointerTy() && !a->hasByValAttr()) {
+			llvm::Type* element = cast<PointerType>(type)->getElementType();
+			for(const FuzzArgument& other : mArguments)
+				if(other.mKind == FuzzArgument::BUFFER)
+					throw JCUTException("Only one pointer argument of "+function+" can be fuzzed");
+			if(!element->isIntegerTy() && !element->isFloatTy() && !element->isDoubleTy())
+				throw JCUTException("Only pointers to integers or floating point values "
+						"can be fuzzed: "+function);
+			arg.mKind = FuzzArgument::BUFFER;
+		} else if(type->isIntegerTy() && mArguments.size() &&
+				mArguments.back().mKind == FuzzArgument::BUFFER) {
+			arg.mKind = FuzzArgument::LENGTH;
+		} else if(type->isIntegerTy() || type->isFloatTy() || type->isDoubleTy()) {
+			arg.mOffset = mHeaderSize;
+			arg.mSize = (type->getPrimitiveSizeInBits() + 7) / 8;
+			mHeaderSize += arg.mSize;
+		} else {
+			stringstream ss;
+			ss << "Argument " << mArguments.size()+1 << " of " << function
+			   << " can not be fuzzed, only integers, floating point values and "
+			      "buffers are supported";
+			throw JCUTException(ss.str());
+		}
+		mArguments.push_back(arg);
+	}
+
+	// The function and every function it calls with a body in the module
+	vector<Function*> functions(1, mTarget);
+	set<Function*> visited(functions.begin(), functions.end());
+	for(unsigned i = 0; i < functions.size(); ++i)
+		for(Function::iterator BB = functions[i]->begin(); BB != functions[i]->end(); ++BB)
+			for(BasicBlock::iterator I = BB->begin(); I != BB->end(); ++I)
+				if(CallInst* call = dyn_cast<CallInst>(I)) {
+					Function* callee = call->getCalledFunction();
+					if(callee && !callee->isDeclaration() && visited.insert(callee).second)
+						functions.push_back(callee);
+				}
+
+	// With the critical edges split every edge has a block of its own,
+	// counting the blocks counts the edges.
+	for(Function* F : functions) {
+		splitCriticalEdges(F);
+		mEdges += F->size();
+	}
+	mCountersGlobal = new GlobalVariable(/*Module=*/*mModule,
+								 /*Type=*/ArrayType::get(Type::getInt8Ty(mModule->getContext()), mEdges),
+								 /*isConstant=*/false,
+								 /*Linkage=*/GlobalValue::ExternalLinkage,
+								 /*Initializer=*/nullptr,
+								 /*Name=*/"fuzz_counters_"+function);
+	unsigned edge = 0;
+	for(Function* F : functions)
+		addEdgeCounters(F, edge);
+	assert(edge == mEdges && "Not every edge has a counter");
+	mCounters.assign((mEdges + 7) / 8 * 8, 0);
+	mSeen.assign(mCounters.size(), 0);
+
+	createHarness();
+}
+
+void Fuzzer::splitCriticalEdges(llvm::Function* F)
+{
+	vector<TerminatorInst*> terminators;
+	for(Function::iterator BB = F->begin(); BB != F->end(); ++BB)
+		terminators.push_back(BB->getTerminator());
+	for(TerminatorInst* TI : terminators) {
+		// The edges of an indirect branch can not be split
+		if(TI->getNumSuccessors() < 2 || isa<IndirectBrInst>(TI))
+			continue;
+		for(unsigned i = 0; i < TI->getNumSuccessors(); ++i)
+			SplitCriticalEdge(TI, i); // Does nothing when the edge is not critical
+	}
+}
+
+void Fuzzer::addEdgeCounters(llvm::Function* F, unsigned& edge)
+{
+	for(Function::iterator BB = F->begin(); BB != F->end(); ++BB) {
+		// ++fuzz_counters[edge]
+		IRBuilder<> builder(&*BB, BB->getFirstInsertionPt());
+		Value* counter = builder.CreateConstInBoundsGEP2_64(mCountersGlobal, 0, edge++);
+		LoadInst* count = builder.CreateLoad(counter);
+		builder.CreateStore(builder.CreateAdd(count, builder.getInt8(1)), counter);
+	}
+}
+
+void Fuzzer::createHarness()
+{
+	LLVMContext& ctx = mModule->getContext();
+	IRBuilder<> builder(ctx);
+	llvm::Type* params[] = {builder.getInt8PtrTy(), builder.getInt64Ty()};
+	FunctionType* type = FunctionType::get(builder.getVoidTy(), params, false);
+	mHarness = Function::Create(type, GlobalValue::ExternalLinkage,
+			"jcut_fuzz_"+mTarget->getName(), mModule);
+	Function::arg_iterator it = mHarness->arg_begin();
+	Value* data = it++;
+	Value* size = it;
+
+	builder.SetInsertPoint(BasicBlock::Create(ctx, "entry", mHarness));
+	vector<Value*> args;
+	for(const FuzzArgument& arg : mArguments) {
+		Value* value = nullptr;
+		switch(arg.mKind) {
+		case FuzzArgument::VALUE: {
+			// A bool is read as a char, only its lowest bit is used
+			llvm::Type* load_type = arg.mType->isIntegerTy(1) ? builder.getInt8Ty() : arg.mType;
+			Value* ptr = builder.CreateConstInBoundsGEP1_64(data, arg.mOffset);
+			ptr = builder.CreateBitCast(ptr, load_type->getPointerTo());
+			value = builder.CreateAlignedLoad(ptr, 1); // The header is packed
+			if(arg.mType->isIntegerTy(1))
+				value = builder.CreateTrunc(value, arg.mType);
+			break;
+		}
+		case FuzzArgument::BUFFER:
+			value = builder.CreateConstInBoundsGEP1_64(data, mHeaderSize);
+			value = builder.CreateBitCast(value, arg.mType);
+			break;
+		case FuzzArgument::LENGTH:
+			value = builder.CreateSub(size, builder.getInt64(mHeaderSize));
+			value = builder.CreateIntCast(value, arg.mType, false);
+			break;
+		}
+		args.push_back(value);
+	}
+	builder.CreateCall(mTarget, args);
+	builder.CreateRetVoid();
+}
+
+uint64_t Fuzzer::nextRandom()
+{
+	return tp::DataGenerator::hash(mSeed, mRandomCount++);
+}
+
+void Fuzzer::mutate(vector<uint8_t>& input, unsigned max_len)
+{
+	unsigned mutations = 1 + nextRandom() % 4;
+	for(unsigned m = 0; m < mutations; ++m) {
+		uint64_t r = nextRandom();
+		size_t pos = input.size() ? r % input.size() : 0;
+		r = nextRandom();
+		switch(r % 8) {
+		case 0: // Flip a bit
+			if(input.size())
+				input[pos] ^= 1 << (r >> 8 & 7);
+			break;
+		case 1: // Random byte
+			if(input.size())
+				input[pos] = r >> 8;
+			break;
+		case 2: // Insert a random byte
+			if(input.size() < max_len)
+				input.insert(input.begin() + pos, r >> 8);
+			break;
+		case 3: // Erase bytes, the header is always kept
+			if(input.size() > mHeaderSize) {
+				size_t count = 1 + (r >> 8) % min<size_t>(8, input.size() - mHeaderSize);
+				pos = mHeaderSize + (r >> 16) % (input.size() - mHeaderSize - count + 1);
+				input.erase(input.begin() + pos, input.begin() + pos + count);
+			}
+			break;
+		case 4: { // Add or subtract a small number to a byte
+			if(input.size())
+				input[pos] += (r >> 8 & 1) ? 1 + (r >> 16) % 16 : -(1 + (r >> 16) % 16);
+			break;
+		}
+		case 5: { // An interesting value, over an argument when there is one
+			uint64_t value = InterestingValues[(r >> 8) % (sizeof(InterestingValues)/sizeof(uint64_t))];
+			unsigned width = 1 << ((r >> 16) % 4);
+			vector<const FuzzArgument*> values;
+			for(const FuzzArgument& arg : mArguments)
+				if(arg.mKind == FuzzArgument::VALUE)
+					values.push_back(&arg);
+			if(values.size() && (r >> 24 & 1)) {
+				const FuzzArgument* arg = values[(r >> 32) % values.size()];
+				pos = arg->mOffset;
+				width = arg->mSize;
+			}
+			if(pos + width <= input.size())
+				memcpy(&input[pos], &value, width); // Little endian
+			break;
+		}
+		case 6: { // Copy a piece of another input of the corpus
+			const vector<uint8_t>& other = mCorpus[(r >> 8) % mCorpus.size()];
+			if(other.empty() || input.empty())
+				break;
+			size_t from = (r >> 24) % other.size();
+			size_t count = min(other.size() - from, input.size() - pos);
+			memcpy(&input[pos], &other[from], count);
+			break;
+		}
+		case 7: { // Repeat a byte
+			if(input.empty())
+				break;
+			size_t count = 1 + (r >> 8) % 16;
+			count = min<size_t>(count, max_len - min<size_t>(max_len, input.size()));
+			input.insert(input.begin() + pos, count, input[pos]);
+			break;
+		}
+		}
+	}
+}
+
+bool Fuzzer::collectCoverage()
+{
+	bool new_coverage = false;
+	for(size_t i = 0; i < mCounters.size(); i += 8) {
+		// Most of the counters are zero, look at 8 of them at once
+		uint64_t word;
+		memcpy(&word, &mCounters[i], sizeof(word));
+		if(word == 0)
+			continue;
+		for(size_t e = i; e < i + 8; ++e) {
+			if(mCounters[e] == 0)
+				continue;
+			uint8_t bucket = countBucket(mCounters[e]);
+			if((mSeen[e] & bucket) == 0) {
+				if(mSeen[e] == 0)
+					++mCoveredEdges;
+				mSeen[e] |= bucket;
+				new_coverage = true;
+			}
+		}
+		memset(&mCounters[i], 0, sizeof(word));
+	}
+	return new_coverage;
+}
+
+void Fuzzer::loadCorpus()
+{
+	DIR* dir = opendir(mCorpusDir.c_str());
+	if(dir == nullptr)
+		return;
+	while(struct dirent* entry = readdir(dir)) {
+		string name = entry->d_name;
+		// The crashes and their tests are not part of the corpus
+		if(name[0] == '.' || name.compare(0, 6, "crash-") == 0)
+			continue;
+		FILE* file = fopen((mCorpusDir+"/"+name).c_str(), "rb");
+		if(file == nullptr)
+			continue;
+		vector<uint8_t> input;
+		uint8_t buffer[4096];
+		size_t read = 0;
+		while((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			input.insert(input.end(), buffer, buffer + read);
+		fclose(file);
+		if(input.size() < mHeaderSize)
+			input.resize(mHeaderSize, 0);
+		mCorpus.push_back(input);
+	}
+	closedir(dir);
+}
+
+void Fuzzer::saveInput(const vector<uint8_t>& input, const string& prefix) const
+{
+	stringstream ss;
+	ss << mCorpusDir << "/" << prefix << hex << setw(16) << setfill('0') << hashInput(input);
+	FILE* file = fopen(ss.str().c_str(), "wb");
+	if(file == nullptr)
+		return;
+	fwrite(input.data(), 1, input.size(), file);
+	fclose(file);
+}
+
+string Fuzzer::getValueString(const FuzzArgument& arg, const uint8_t* data) const
+{
+	stringstream ss;
+	if(arg.mType->isFloatTy() || arg.mType->isDoubleTy()) {
+		double value = 0;
+		if(arg.mType->isFloatTy()) {
+			float f = 0;
+			memcpy(&f, data, sizeof(f));
+			value = f;
+		} else
+			memcpy(&value, data, sizeof(value));
+		// The test language has no constants for infinity and NaN
+		if(std::isinf(value))
+			return value < 0 ? "-1e999" : "1e999";
+		if(std::isnan(value))
+			return "0";
+		ss << setprecision(numeric_limits<double>::max_digits10) << value;
+		if(ss.str().find_first_of(".e") == string::npos)
+			ss << ".0";
+		return ss.str();
+	}
+	unsigned bits = arg.mType->getIntegerBitWidth();
+	if(bits == 1)
+		return (data[0] & 1) ? "1" : "0";
+	// Sign extend the little endian value
+	int64_t value = 0;
+	memcpy(&value, data, arg.mSize);
+	if(bits < 64 && (value >> (bits - 1) & 1))
+		value |= ~((1ULL << bits) - 1);
+	ss << value;
+	return ss.str();
+}
+
+string Fuzzer::getBufferString(const uint8_t* data, size_t size) const
+{
+	const FuzzArgument* buffer = nullptr;
+	for(const FuzzArgument& arg : mArguments)
+		if(arg.mKind == FuzzArgument::BUFFER)
+			buffer = &arg;
+	FuzzArgument element = {FuzzArgument::VALUE,
+			cast<PointerType>(buffer->mType)->getElementType(), 0, 0};
+	element.mSize = (element.mType->getPrimitiveSizeInBits() + 7) / 8;
+	size_t count = size / element.mSize;
+	if(count == 0)
+		return "[1]";
+	stringstream ss;
+	ss << "[" << count << ":{";
+	for(size_t i = 0; i < count; ++i)
+		ss << (i ? "," : "") << getValueString(element, data + i * element.mSize);
+	ss << "}]";
+	return ss.str();
+}
+
+string Fuzzer::getTestString(const vector<uint8_t>& input) const
+{
+	const uint8_t* tail = input.data() + mHeaderSize;
+	size_t tail_size = input.size() - mHeaderSize;
+	stringstream ss;
+	ss << mTarget->getName().str() << "(";
+	for(unsigned i = 0; i < mArguments.size(); ++i) {
+		const FuzzArgument& arg = mArguments[i];
+		ss << (i ? ", " : "");
+		switch(arg.mKind) {
+		case FuzzArgument::VALUE: ss << getValueString(arg, input.data() + arg.mOffset); break;
+		case FuzzArgument::BUFFER: ss << getBufferString(tail, tail_size); break;
+		case FuzzArgument::LENGTH: ss << tail_size; break;
+		}
+	}
+	ss << ");";
+	return ss.str();
+}
+
+void Fuzzer::printStatus(const char* event, uint64_t runs, double seconds) const
+{
+	stringstream ss;
+	ss << "#" << runs << "\t" << event << " cov: " << mCoveredEdges << "/" << mEdges
+	   << " corp: " << mCorpus.size()
+	   << " exec/s: " << (seconds > 0 ? uint64_t(runs / seconds) : 0) << endl;
+	string status = ss.str();
+	if(write(mStatusFd, status.data(), status.size()) == -1)
+		return;
+}
+
+void Fuzzer::writeCrash(int sig, const vector<uint8_t>& input) const
+{
+	saveInput(input, "crash-");
+	stringstream name;
+	name << mCorpusDir << "/crash-" << hex << setw(16) << setfill('0')
+	     << hashInput(input);
+
+	stringstream test;
+	test << "# jcut --fuzz=" << mTarget->getName().str() << ": "
+	     << strsignal(sig) << ", input " << name.str() << endl
+	     << getTestString(input) << endl;
+	FILE* file = fopen((name.str()+".txt").c_str(), "w");
+	if(file) {
+		fputs(test.str().c_str(), file);
+		fclose(file);
+	}
+	string msg = "==" + to_string(getpid()) + "== " + strsignal(sig) +
+			" in " + mTarget->getName().str() + ", the test is in " +
+			name.str() + ".txt\n" + test.str();
+	fputs(msg.c_str(), stderr);
+}
+
+void Fuzzer::sendCrash(int sig) const
+{
+	// The signal number followed by the input, jcut reads them until the
+	// pipe is closed.
+	const char* data = (const char*) &sig;
+	size_t size = sizeof(sig);
+	for(int part = 0; part < 2; ++part) {
+		while(size) {
+			ssize_t written = write(mCrashFd, data, size);
+			if(written == -1) {
+				if(errno == EINTR)
+					continue;
+				return;
+			}
+			data += written;
+			size -= written;
+		}
+		data = (const char*) mInput.data();
+		size = mInput.size() - 1;
+	}
+}
+
+void Fuzzer::crashHandler(int sig)
+{
+	if(sActive)
+		sActive->sendCrash(sig);
+	_exit(EXIT_FAILURE);
+}
+
+void Fuzzer::run(llvm::ExecutionEngine* EE, const string& corpus_dir,
+		uint64_t runs, unsigned max_len, uint64_t seed)
+{
+	mCorpusDir = corpus_dir;
+	mSeed = seed ? seed : time(nullptr);
+	max_len = max(max_len, mHeaderSize);
+	mkdir(mCorpusDir.c_str(), 0755);
+
+	// The function runs in a child process, so that the signal handler only
+	// has to send the input that crashed it to jcut.
+	int fds[2];
+	if(pipe(fds) == -1)
+		throw JCUTException("Could not create the pipe of the fuzzer: "+string(strerror(errno)));
+	fflush(stdout);
+	fflush(stderr);
+	pid_t pid = fork();
+	if(pid == -1) {
+		close(fds[0]);
+		close(fds[1]);
+		throw JCUTException("Could not fork the fuzzer: "+string(strerror(errno)));
+	}
+	if(pid == 0) {
+		close(fds[0]);
+		mCrashFd = fds[1];
+		int status = EXIT_SUCCESS;
+		try {
+			fuzz(EE, runs, max_len);
+		} catch(const JCUTException& e) {
+			fprintf(stderr, "%s\n", e.what());
+			status = EXIT_FAILURE;
+		}
+		fflush(stdout);
+		fflush(stderr);
+		_exit(status);
+	}
+	close(fds[1]);
+
+	vector<uint8_t> crash;
+	uint8_t buffer[4096];
+	ssize_t read_size = 0;
+	while((read_size = read(fds[0], buffer, sizeof(buffer))) != 0) {
+		if(read_size == -1) {
+			if(errno == EINTR)
+				continue;
+			break;
+		}
+		crash.insert(crash.end(), buffer, buffer + read_size);
+	}
+	close(fds[0]);
+	int status = 0;
+	while(waitpid(pid, &status, 0) == -1 && errno == EINTR)
+		;
+
+	if(crash.size() >= sizeof(int)) {
+		int sig = 0;
+		memcpy(&sig, crash.data(), sizeof(sig));
+		writeCrash(sig, vector<uint8_t>(crash.begin() + sizeof(sig), crash.end()));
+		fflush(stdout);
+		fflush(stderr);
+		_exit(EXIT_FAILURE);
+	}
+	if(WIFSIGNALED(status))
+		throw JCUTException("The fuzzer of "+mTarget->getName().str()+
+				" was killed by signal "+to_string(WTERMSIG(status)));
+	if(!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+		throw JCUTException("The fuzzer of "+mTarget->getName().str()+
+				" exited with status "+to_string(WEXITSTATUS(status)));
+}
+
+void Fuzzer::fuzz(llvm::ExecutionEngine* EE, uint64_t runs, unsigned max_len)
+{
+	EE->addGlobalMapping(mCountersGlobal, mCounters.data());
+	typedef void (*HarnessFunction)(const uint8_t*, uint64_t);
+	HarnessFunction harness = (HarnessFunction) EE->getPointerToFunction(mHarness);
+
+	// The output of the function is discarded, it would slow everything down
+	fflush(stdout);
+	fflush(stderr);
+	int old_stdout = dup(fileno(stdout));
+	int old_stderr = dup(fileno(stderr));
+	mStatusFd = old_stdout;
+	int dev_null = open("/dev/null", O_WRONLY);
+	if(dev_null != -1) {
+		dup2(dev_null, fileno(stdout));
+		dup2(dev_null, fileno(stderr));
+	}
+
+	// The crashes are caught in process, on an alternate stack in case the
+	// function overflowed its own.
+	vector<char> signal_stack(SIGSTKSZ * 4);
+	stack_t ss = {};
+	ss.ss_sp = signal_stack.data();
+	ss.ss_size = signal_stack.size();
+	stack_t old_ss;
+	sigaltstack(&ss, &old_ss);
+	struct sigaction sa = {};
+	sa.sa_handler = crashHandler;
+	sa.sa_flags = SA_ONSTACK;
+	sigemptyset(&sa.sa_mask);
+	struct sigaction old_sa[CrashSignalCount];
+	for(unsigned i = 0; i < CrashSignalCount; ++i)
+		sigaction(CrashSignals[i], &sa, &old_sa[i]);
+	sActive = this;
+
+	uint64_t executed = 0;
+	double start = now();
+	auto execute = [&](const vector<uint8_t>& input) -> bool {
+		mInput.assign(input.begin(), input.end());
+		mInput.push_back(0);
+		harness(mInput.data(), input.size());
+		++executed;
+		return collectCoverage();
+	};
+
+	// Run the inputs of a previous session first, only the ones that still
+	// add coverage are kept.
+	loadCorpus();
+	vector<vector<uint8_t>> initial;
+	initial.swap(mCorpus);
+	if(initial.empty())
+		initial.push_back(vector<uint8_t>(mHeaderSize, 0));
+	for(const vector<uint8_t>& input : initial)
+		if(execute(input))
+			mCorpus.push_back(input);
+	if(mCorpus.empty())
+		mCorpus.push_back(initial.front());
+	printStatus("INITED", executed, now() - start);
+
+	vector<uint8_t> input;
+	while(runs == 0 || executed < runs) {
+		input = mCorpus[nextRandom() % mCorpus.size()];
+		mutate(input, max_len);
+		if(execute(input)) {
+			mCorpus.push_back(input);
+			saveInput(input, "");
+			printStatus("NEW", executed, now() - start);
+		} else if((executed & (executed - 1)) == 0)
+			printStatus("pulse", executed, now() - start);
+	}
+	printStatus("DONE", executed, now() - start);
+
+	sActive = nullptr;
+	for(unsigned i = 0; i < CrashSignalCount; ++i)
+		sigaction(CrashSignals[i], &old_sa[i], nullptr);
+	sigaltstack(&old_ss, nullptr);
+	fflush(stdout);
+	fflush(stderr);
+	if(dev_null != -1) {
+		dup2(old_stdout, fileno(stdout));
+		dup2(old_stderr, fileno(stderr));
+		close(dev_null);
+	}
+	close(old_stdout);
+	close(old_stderr);
+	mStatusFd = -1;
+}
+
+} /* namespace jcut */
@@ -0,0 +1,145 @@
+//===-- jcut/Fuzzer.h - Coverage guided fuzzing -----------------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Coverage guided fuzzing of a function of the loaded C source files.
+///
+/// Every edge of the control flow graph of the function and of the functions
+/// it calls gets an 8 bit counter incremented each time the edge is taken.
+/// The function is run in a child process of jcut through a harness which
+/// builds its arguments from the bytes of the input:
+///
+///   - Integer and floating point arguments are read one after the other
+///     from the first bytes of the input (the header).
+///   - A pointer argument points to the bytes after the header, an integer
+///     argument right after it receives their count.
+///
+/// The inputs that take an edge a number of times never seen before are kept
+/// in the corpus directory and mutated to produce new inputs. An input that
+/// crashes the function is sent to jcut by the signal handler of the child,
+/// jcut writes it to the corpus directory together with a test file with the
+/// jcut test that reproduces the crash.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef FUZZER_H_
+#define FUZZER_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace llvm {
+	class Module;
+	class Function;
+	class GlobalVariable;
+	class ExecutionEngine;
+	class Type;
+}
+
+using namespace std;
+
+namespace jcut {
+
+class Fuzzer {
+private:
+	struct FuzzArgument {
+		enum Kind {
+			VALUE, // Read from the header
+			BUFFER, // Points to the bytes after the header
+			LENGTH // Number of bytes after the header
+		};
+		Kind mKind;
+		llvm::Type* mType;
+		unsigned mOffset;
+		unsigned mSize;
+	};
+
+	llvm::Module* mModule;
+	llvm::Function* mTarget;
+	// void jcut_fuzz_<function>(i8* data, i64 size)
+	llvm::Function* mHarness;
+	llvm::GlobalVariable* mCountersGlobal;
+	vector<FuzzArgument> mArguments;
+	unsigned mHeaderSize;
+	// One counter per instrumented edge, padded to a multiple of 8
+	vector<uint8_t> mCounters;
+	// One bit per hit count bucket seen for every edge
+	vector<uint8_t> mSeen;
+	unsigned mEdges;
+	unsigned mCoveredEdges;
+	vector<vector<uint8_t>> mCorpus;
+	string mCorpusDir;
+	uint64_t mSeed;
+	uint64_t mRandomCount;
+	// The input being run followed by a 0 byte, so that a buffer used as a
+	// string is always terminated. Written out by the signal handler.
+	vector<uint8_t> mInput;
+	// The status of jcut goes to its stdout, the output of the function is
+	// discarded
+	int mStatusFd;
+	// The pipe to jcut the signal handler writes the crashing input to
+	int mCrashFd;
+
+	static Fuzzer* sActive;
+	static void crashHandler(int sig);
+
+	static void splitCriticalEdges(llvm::Function* F);
+	void addEdgeCounters(llvm::Function* F, unsigned& edge);
+	void createHarness();
+	uint64_t nextRandom();
+	void mutate(vector<uint8_t>& input, unsigned max_len);
+	bool collectCoverage();
+	void loadCorpus();
+	void saveInput(const vector<uint8_t>& input, const string& prefix) const;
+	/// Runs in the child process, until the given number of runs
+	void fuzz(llvm::ExecutionEngine* EE, uint64_t runs, unsigned max_len);
+	/// Only async signal safe calls, the process is about to die
+	void sendCrash(int sig) const;
+	void writeCrash(int sig, const vector<uint8_t>& input) const;
+	void printStatus(const char* event, uint64_t runs, double seconds) const;
+	string getBufferString(const uint8_t* data, size_t size) const;
+	string getValueString(const FuzzArgument& arg, const uint8_t* data) const;
+public:
+	/// Instruments the function named function and every function it calls
+	/// in module. Must be done before the module is given to the JIT.
+	Fuzzer(llvm::Module* module, const string& function);
+	Fuzzer(const Fuzzer&) = delete;
+	Fuzzer& operator=(const Fuzzer&) = delete;
+
+	/// Fuzzes the function until it crashes or runs inputs were tried, 0
+	/// means no limit. A crash ends jcut with EXIT_FAILURE once the input
+	/// and its test are written.
+	void run(llvm::ExecutionEngine* EE, const string& corpus_dir,
+			uint64_t runs, unsigned max_len, uint64_t seed);
+
+	/// The jcut test that calls the function with the given input
+	string getTestString(const vector<uint8_t>& input) const;
+
+	unsigned edgeCount() const { return mEdges; }
+	unsigned headerSize() const { return mHeaderSize; }
+};
+
+} /* namespace jcut */
+
+#endif /* FUZZER_H_ */
@@ -27,10 +27,17 @@
 //===----------------------------------------------------------------------===//
 
 #include <iostream>
+#include <cerrno>
+#include <csignal>
 #include <cstring>
 #include <set>
+#include <type_traits>
+#include <sys/socket.h>
+#include <unistd.h>
 
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Tooling/CommonOptionsParser.h"
@@ -38,6 +45,10 @@
 
 #include "Interpreter.h"
 #include "JCUTAction.h"
+#include "FileWatcher.h"
+#include "SymbolIndex.h"
+#include "Daemon.h"
+#include "TimeReport.h"
 // used for accesing the exceptions, @todo move Exception classes to their own sourc file
 #include "TestParser.h"
 
@@ -45,6 +56,8 @@ using namespace std;
 using namespace clang;
 using namespace clang::tooling;
 
+extern llvm::cl::list<string> TestFileOpt;
+
 namespace jcut {
 
 Interpreter::Interpreter(const int argc, const char **argv)
@@ -90,7 +103,29 @@ Interpreter::Interpreter(const int argc, const char **argv)
 	}
 
 
-	if((compilation_db && mArgc > 3) || (double_dash && mArgc > 2)) {
+	// The options alone, i.e. jcut --server, do not load any file. The value
+	// of an option that requires one, as in --socket path, is not a source
+	// file either.
+	llvm::StringMap<llvm::cl::Option*> options;
+	llvm::cl::getRegisteredOptions(options);
+	bool has_sources = false;
+	for(int i = 1; i < mArgc && string(mArgv[i]) != "--"; ++i) {
+		string tmp(mArgv[i]);
+		if(tmp[0] != '-') {
+			has_sources = true;
+			continue;
+		}
+		string::size_type name = tmp.find_first_not_of('-');
+		if(name == string::npos || tmp.find('=') != string::npos)
+			continue;
+		llvm::StringMap<llvm::cl::Option*>::iterator option =
+				options.find(tmp.substr(name));
+		if(option != options.end() &&
+		   option->second->getValueExpectedFlag() == llvm::cl::ValueRequired)
+			++i;
+	}
+
+	if(has_sources) {
 		// This needed to get the list of loaded files.
 		int new_c = 0;
 		const char** v = cloneArgv(new_c);
@@ -144,6 +179,10 @@ int Interpreter::mainLoop() {
 			reinterpret_cast<linenoiseCompletionCallback*>(
 					Interpreter::completionCallBack));
 	jcut::JCUTAction::mUseInterpreterInput = true;
+	jcut::JCUTAction::mKeepSession = true;
+	// The completion of the names starts with the files loaded already
+	if(hasLoadedFiles())
+		updateSymbolIndex();
 	string executed = "";
 	bool attempted = false;
 
@@ -179,14 +218,173 @@ int Interpreter::mainLoop() {
 				continue;
 			}
 
-			if(runAction<SyntaxOnlyAction>() == 0)
-				runAction<JCUTAction>();
+			// The source files are compiled again only when they changed or
+			// were loaded or unloaded since the last line.
+			if(JCUTAction::hasSession(mLoadedFiles))
+				JCUTAction::runInterpreterInput();
+			else {
+				JCUTAction::closeSession();
+				if(runAction<SyntaxOnlyAction>() == 0)
+					runAction<JCUTAction>();
+			}
 			jcut::JCUTAction::mInterpreterInput.clear();
 		}
 	}
 	return 0;
 }
 
+bool Interpreter::updateSymbolIndex() {
+	vector<string> outdated = SymbolIndex::instance().getOutdatedFiles(mLoadedFiles);
+	if(outdated.empty())
+		return true;
+	mOnlySources = outdated;
+	int failed = runAction<IndexSymbolsAction>();
+	mOnlySources.clear();
+	return failed == 0;
+}
+
+int Interpreter::watchLoop() {
+	JCUTAction::mKeepSession = true;
+	// The first run compiles all the source files and runs all the tests
+	if(runAction<SyntaxOnlyAction>() == 0)
+		runAction<JCUTAction>();
+
+	try {
+		FileWatcher watcher;
+		for(;;) {
+			// New headers may be included, new test files may be found
+			vector<string> test_files = JCUTAction::getTestFileNames();
+			watcher.clear();
+			for(const string& file : mLoadedFiles)
+				watcher.addFile(file);
+			for(const string& file : JCUTAction::getSessionFiles())
+				watcher.addFile(file);
+			for(const string& file : test_files)
+				watcher.addFile(file);
+			cout << endl << "Watching for changes, press Ctrl-C to exit." << endl;
+			vector<string> changed = watcher.wait();
+			for(const string& file : changed)
+				cout << "Changed: " << file << endl;
+
+			vector<string> outdated = JCUTAction::getOutdatedSources(mLoadedFiles);
+			if(outdated.size()) {
+				mOnlySources = outdated;
+				JCUTAction::mCompileOnly = true;
+				if(runAction<SyntaxOnlyAction>() == 0)
+					runAction<JCUTAction>();
+				JCUTAction::mCompileOnly = false;
+				mOnlySources.clear();
+			}
+
+			vector<string> changed_tests;
+			for(const string& file : test_files)
+				if(find(changed.begin(), changed.end(),
+						FileWatcher::getRealPath(file)) != changed.end())
+					changed_tests.push_back(file);
+			if(JCUTAction::runChangedTests(changed_tests) == 0)
+				cout << "No tests are affected by the changes." << endl;
+		}
+	} catch(const JCUTException& e) {
+		cerr << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+	return 0;
+}
+
+int Interpreter::serverLoop(const string& socket_path) {
+	JCUTAction::mKeepSession = true;
+	// A client that goes away does not stop the server
+	signal(SIGPIPE, SIG_IGN);
+	int server = -1;
+	try {
+		server = listenOnSocket(socket_path);
+	} catch(const JCUTException& e) {
+		cerr << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+	cout << "jcut server listening on " << socket_path << endl;
+
+	for(;;) {
+		int client = accept(server, nullptr, nullptr);
+		if(client == -1) {
+			if(errno == EINTR || errno == ECONNABORTED)
+				continue;
+			cerr << "jcut server stopped: " << strerror(errno) << endl;
+			break;
+		}
+		// The tests run the code of the request as the user of the server
+		if(!isSameUser(client)) {
+			cerr << "jcut server: a client of another user was refused" << endl;
+			close(client);
+			continue;
+		}
+		serveRequest(client);
+		close(client);
+	}
+	close(server);
+	return EXIT_FAILURE;
+}
+
+void Interpreter::serveRequest(int client) {
+	DaemonRequest request;
+	try {
+		request = DaemonRequest::read(client);
+	} catch(const JCUTException& e) {
+		string error = string(e.what()) + "\n";
+		if(write(client, error.c_str(), error.size()) == -1)
+			cerr << e.what() << endl;
+		return;
+	}
+
+	// Everything written while the request runs goes to the client
+	cout.flush();
+	fflush(stdout);
+	fflush(stderr);
+	int old_out = dup(STDOUT_FILENO);
+	int old_err = dup(STDERR_FILENO);
+	dup2(client, STDOUT_FILENO);
+	dup2(client, STDERR_FILENO);
+	int failed_before = TotalTestsFailed;
+
+	try {
+		if(chdir(request.mDirectory.c_str()) != 0)
+			throw JCUTException("Invalid working directory "+request.mDirectory);
+		for(const string& source : request.mSources)
+			if(find(mLoadedFiles.begin(), mLoadedFiles.end(), source) == mLoadedFiles.end())
+				addFileToArgv(source);
+		TestFileOpt.clear();
+		for(const string& test : request.mTestFiles)
+			TestFileOpt.push_back(test);
+
+		// Only the source files new to the server, or changed since it
+		// compiled them, are compiled.
+		vector<string> outdated = JCUTAction::getOutdatedSources(request.mSources);
+		if(outdated.size()) {
+			mOnlySources = outdated;
+			JCUTAction::mCompileOnly = true;
+			if(runAction<SyntaxOnlyAction>() == 0)
+				runAction<JCUTAction>();
+			JCUTAction::mCompileOnly = false;
+			mOnlySources.clear();
+		}
+		JCUTAction::runTests(request.mSources);
+	} catch(const JCUTException& e) {
+		JCUTAction::mCompileOnly = false;
+		mOnlySources.clear();
+		cerr << e.what() << endl;
+	}
+
+	cout.flush();
+	llvm::outs().flush();
+	fflush(stdout);
+	fflush(stderr);
+	dup2(old_out, STDOUT_FILENO);
+	dup2(old_err, STDERR_FILENO);
+	close(old_out);
+	close(old_err);
+	writeExitStatus(client, TotalTestsFailed - failed_before);
+}
+
 void printArgv(int argc, const char** argv) {
 	cout << "ARGUMENTS: ";
 	for(int i=0; i<argc; ++i) {
@@ -196,6 +394,21 @@ void printArgv(int argc, const char** argv) {
 	cout << endl;
 }
 
+/// Adds the time clang takes on every source file to --time-report and
+/// --trace. The front end of JCUTAction also generates the LLVM IR, clang
+/// generates the code of a function as soon as it is parsed.
+template <class T>
+class TimedAction : public T {
+protected:
+	void ExecuteAction() {
+		bool compile = is_same<T, JCUTAction>::value;
+		TimeReport::Timer timer(compile ? TimeReport::COMPILE :
+				TimeReport::SYNTAX_CHECK, this->getCurrentFile().str());
+		Trace::Span span(compile ? "compile" : "syntax check",
+				this->getCurrentFile().str());
+		T::ExecuteAction();
+	}
+};
 
 template <class T>
 int Interpreter::runAction(int argc, const char **argv) {
@@ -234,13 +447,19 @@ int Interpreter::runAction(int argc, const char **argv) {
 			Sources.erase(it);
 	}
 	mLoadedFiles = Sources;
+	// --watch compiles again only the source files that changed
+	if(!mOnlySources.empty())
+		Sources = mOnlySources;
 
 	// We hand the CompilationDatabase we created and the sources to run over into
 	// the tool constructor.
 	ClangTool Tool(CD, Sources);
+	// The tests are parsed once for all the sources
+	jcut::JCUTAction::setSourceFiles(Sources);
 
-	FrontendActionFactory* generic_action = newFrontendActionFactory<T>();
+	FrontendActionFactory* generic_action = newFrontendActionFactory<TimedAction<T>>();
 	int failed = Tool.run(generic_action);
+	jcut::JCUTAction::endRun();
 	return failed;
 }
 
@@ -302,8 +521,9 @@ bool Interpreter::addFileToArgv(const string& str)
 	vector<string> backup;
 	for(int i=0; i<mArgc; ++i)
 		backup.push_back(mArgv[i]);
-	auto it = backup.end();
-	backup.insert(--it, str);
+	// Before the compiler flags
+	auto it = find(backup.begin(), backup.end(), "--");
+	backup.insert(it, str);
 
 	auto found = find(unloadedFiles.begin(), unloadedFiles.end(), str);
 	if(found != unloadedFiles.end())
@@ -337,6 +557,7 @@ bool Interpreter::removeFileFromArgv(const string& str)
 			if(it != mLoadedFiles.end())
 				mLoadedFiles.erase(it);
 			unloadedFiles.push_back(mArgv[i]);
+			SymbolIndex::instance().removeFile(mArgv[i]);
 		}
 	}
 	if(static_cast<unsigned>(mArgc) == backup.size())
@@ -383,6 +604,10 @@ void Interpreter::completionCallBack(const char * line, linenoiseCompletions *lc
 	if (line[0] == 'g')
 		linenoiseAddCompletion(lc,"group");
 
+	// The functions, global variables and types of the loaded files
+	for(const string& completion : SymbolIndex::instance().complete(line))
+		linenoiseAddCompletion(lc, completion.c_str());
+
 }
 
 /**
@@ -454,6 +679,9 @@ bool Load::execute() {
 		else
 			cout << "File " << absolute << " loaded succesfully." << endl;
 	}
+	// Indexed now, /ls and the completion do not parse them again
+	if(!mInt.updateSymbolIndex())
+		cerr << "Some of the loaded files have errors, their symbols may be incomplete." << endl;
 	return true;
 }
 
@@ -484,10 +712,10 @@ bool Ls::execute() {
 		return true;
 	}
 
-	int failed = mInt.runAction<LsFunctionsAction>();
-	if(failed)
-		return false;
-	return true;
+	// Only the files changed since they were indexed are parsed again
+	bool indexed = mInt.updateSymbolIndex();
+	SymbolIndex::instance().printFunctions(mInt.getLoadedFiles(), cout);
+	return indexed;
 }
 
 unique_ptr<CommandFactory> CommandFactory::factory(nullptr);
@@ -53,12 +53,16 @@ private:
 	vector<const char*> toBeFreed;
 	vector<string> unloadedFiles;
 	vector<string> mLoadedFiles;
+	// When not empty runAction() only compiles these source files
+	vector<string> mOnlySources;
 	bool mOptionsParsed;
 
 	void convertToAbsolutePaths(int argc, const char **argv);
 	bool executeCommand(const std::string& cmd,
 			Interpreter& i, std::string& final_cmd);
 	static void completionCallBack(const char * line, linenoiseCompletions *lc);
+	/// Runs the request of a jcut --client connected to the server
+	void serveRequest(int client);
 
 public:
 	Interpreter(const int argc, const char **argv);
@@ -77,6 +81,14 @@ public:
 	template<class T>
 	int runAction(int argc, const char **argv);
 	int mainLoop();
+	/// Runs the tests, then runs them again every time the source files,
+	/// their headers or the test files change. Only the source files that
+	/// changed are compiled again and only the tests of the functions they
+	/// affect run.
+	int watchLoop();
+	/// Listens for the requests of jcut --client on a Unix domain socket.
+	/// The source files stay compiled between the requests.
+	int serverLoop(const string& socket_path);
 
 	// For every call to the cloneArgv() methods there has to be 1 call to freeArgv
 	const char** cloneArgv(int& new_argc) const;
@@ -87,6 +99,10 @@ public:
 
 	// 2 means the binary name and the mythical --
 	bool hasLoadedFiles() { return mLoadedFiles.size() > 0; }
+	const vector<string>& getLoadedFiles() const { return mLoadedFiles; }
+	/// Indexes the symbols of the loaded files not indexed yet or changed
+	/// since they were indexed. Returns false when one could not be parsed.
+	bool updateSymbolIndex();
 };
 
 class Command {
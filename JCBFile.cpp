@@ -0,0 +1,326 @@
+//===-- jcut/JCBFile.cpp - Binary columnar data files -----------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "JCBFile.h"
+#include "CSVReader.h"
+#include "TestParser.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// The columns are used as they are by the generated code, the file and the
+// host must agree on the byte order.
+bool isLittleEndian()
+{
+	uint16_t one = 1;
+	return *reinterpret_cast<uint8_t*>(&one) == 1;
+}
+
+uint64_t alignTo(uint64_t offset, uint64_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+template<typename T>
+void writeValue(FILE* out, T value)
+{
+	fwrite(&value, sizeof(T), 1, out);
+}
+
+// Whether the value read from the CSV file is inside the range of the type
+// of its column, the converted value is never truncated.
+bool fitsColumnType(tp::JCBFile::ColumnType type, int64_t int_value, double float_value)
+{
+	switch(type) {
+	case tp::JCBFile::INT8:
+		return int_value >= numeric_limits<int8_t>::min() &&
+		       int_value <= numeric_limits<int8_t>::max();
+	case tp::JCBFile::INT16:
+		return int_value >= numeric_limits<int16_t>::min() &&
+		       int_value <= numeric_limits<int16_t>::max();
+	case tp::JCBFile::INT32:
+		return int_value >= numeric_limits<int32_t>::min() &&
+		       int_value <= numeric_limits<int32_t>::max();
+	case tp::JCBFile::FLOAT:
+		// Infinities and NaN are kept as they are
+		return !isfinite(float_value) ||
+		       fabs(float_value) <= numeric_limits<float>::max();
+	default:
+		return true;
+	}
+}
+
+} // anonymous namespace
+
+namespace tp {
+
+const char JCBFile::Magic[4] = {'J', 'C', 'B', '1'};
+
+JCBFile::JCBFile(const string& path) : mPath(path), mData(nullptr), mSize(0),
+	mRows(0), mColumns()
+{
+	if(!isLittleEndian())
+		throw JCUTException("Binary data files are only supported on little endian hosts");
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd == -1)
+		throw JCUTException("Data File: "+path+" not found!");
+	struct stat st;
+	if(fstat(fd, &st) == -1 || st.st_size < (off_t) HeaderSize) {
+		close(fd);
+		throw JCUTException("Data File: "+path+" is not a valid .jcb file!");
+	}
+	mSize = st.st_size;
+	void* addr = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(addr == MAP_FAILED)
+		throw JCUTException("Data File: "+path+" could not be mapped in memory!");
+	mData = static_cast<const char*>(addr);
+	try {
+		validate();
+	} catch(...) {
+		// The destructor does not run when the constructor throws
+		munmap(addr, mSize);
+		mData = nullptr;
+		throw;
+	}
+	// The rows are read one after the other by the test loop
+	madvise(addr, mSize, MADV_SEQUENTIAL);
+}
+
+void JCBFile::validate()
+{
+	const string& path = mPath;
+	uint32_t columns = 0;
+	memcpy(&columns, mData + 4, sizeof(columns));
+	memcpy(&mRows, mData + 8, sizeof(mRows));
+	if(memcmp(mData, Magic, sizeof(Magic)) ||
+	   HeaderSize + uint64_t(columns) * sizeof(ColumnDescriptor) > mSize)
+		throw JCUTException("Data File: "+path+" is not a valid .jcb file!");
+
+	mColumns.resize(columns);
+	memcpy(mColumns.data(), mData + HeaderSize, columns * sizeof(ColumnDescriptor));
+	for(unsigned j = 0; j < columns; ++j) {
+		const ColumnDescriptor& column = mColumns[j];
+		stringstream ss;
+		ss << "Data File: " << path << ": column " << j+1 << " ";
+		if(column.mType < INT8 || column.mType > BLOB)
+			throw JCUTException(ss.str()+"has an unknown type");
+		if(column.mSize == 0 ||
+		   (column.mType != BLOB && column.mSize != getTypeSize(getType(j))))
+			throw JCUTException(ss.str()+"has an invalid size");
+		if(column.mOffset % Alignment)
+			throw JCUTException(ss.str()+"is not aligned");
+		if(column.mOffset > mSize || mRows > (mSize - column.mOffset) / column.mSize)
+			throw JCUTException(ss.str()+"is truncated");
+	}
+}
+
+JCBFile::~JCBFile()
+{
+	if(mData)
+		munmap(const_cast<char*>(mData), mSize);
+}
+
+bool JCBFile::isJCBFile(const string& path)
+{
+	return path.size() > 4 && path.compare(path.size() - 4, 4, ".jcb") == 0;
+}
+
+unsigned JCBFile::getTypeSize(ColumnType type)
+{
+	switch(type) {
+	case INT8: return 1;
+	case INT16: return 2;
+	case INT32: return 4;
+	case INT64: return 8;
+	case FLOAT: return 4;
+	case DOUBLE: return 8;
+	case BLOB: return 0;
+	}
+	return 0;
+}
+
+string JCBFile::getTypeName(ColumnType type)
+{
+	switch(type) {
+	case INT8: return "i8";
+	case INT16: return "i16";
+	case INT32: return "i32";
+	case INT64: return "i64";
+	case FLOAT: return "f32";
+	case DOUBLE: return "f64";
+	case BLOB: return "blob";
+	}
+	return "";
+}
+
+vector<JCBFile::ColumnType> JCBFile::parseTypes(const string& list)
+{
+	vector<ColumnType> types;
+	stringstream ss(list);
+	string name;
+	while(getline(ss, name, ',')) {
+		ColumnType type = INT8;
+		for(; type < BLOB; type = static_cast<ColumnType>(type + 1))
+			if(getTypeName(type) == name)
+				break;
+		if(type == BLOB)
+			throw JCUTException("Invalid column type '"+name+"', valid types are: "
+					"i8, i16, i32, i64, f32 and f64");
+		types.push_back(type);
+	}
+	return types;
+}
+
+void JCBFile::convertCSV(const string& csv_path, const string& jcb_path,
+		vector<ColumnType> types)
+{
+	if(!isLittleEndian())
+		throw JCUTException("Binary data files are only supported on little endian hosts");
+	CSVReader csv(csv_path);
+	vector<llvm::StringRef> row;
+	bool guess = types.empty();
+	int64_t int_value = 0;
+	double float_value = 0;
+
+	// First pass: count the rows and find out the type of each column
+	while(csv.nextRow(row)) {
+		if(guess && types.empty())
+			types.assign(row.size(), INT64);
+		if(types.size() != row.size()) {
+			stringstream ss;
+			ss << "CSV File: " << csv_path << " has " << row.size()
+			   << " columns but " << types.size() << " types were given";
+			throw JCUTException(ss.str());
+		}
+		if(guess)
+			for(unsigned j = 0; j < row.size(); ++j)
+				if(types[j] == INT64 && !CSVReader::parseInt(row[j], int_value))
+					types[j] = DOUBLE;
+	}
+	uint64_t rows = csv.rowCount();
+	if(rows == 0)
+		throw JCUTException("CSV File: "+csv_path+" is empty");
+
+	vector<ColumnDescriptor> columns(types.size());
+	uint64_t offset = alignTo(HeaderSize + types.size() * sizeof(ColumnDescriptor), Alignment);
+	for(unsigned j = 0; j < types.size(); ++j) {
+		columns[j].mType = types[j];
+		columns[j].mSize = getTypeSize(types[j]);
+		columns[j].mOffset = offset;
+		offset = alignTo(offset + rows * columns[j].mSize, Alignment);
+	}
+
+	FILE* out = fopen(jcb_path.c_str(), "wb");
+	if(out == nullptr)
+		throw JCUTException("Could not open file "+jcb_path+" for writing");
+	try {
+		fwrite(Magic, sizeof(Magic), 1, out);
+		writeValue<uint32_t>(out, types.size());
+		writeValue<uint64_t>(out, rows);
+		fwrite(columns.data(), sizeof(ColumnDescriptor), columns.size(), out);
+
+		// One pass per column, the CSV file is mapped in memory so reading it
+		// again is cheap and we never hold more than one row.
+		for(unsigned j = 0; j < columns.size(); ++j) {
+			fseek(out, columns[j].mOffset, SEEK_SET);
+			csv.rewind();
+			while(csv.nextRow(row)) {
+				bool parsed = false;
+				if(types[j] == FLOAT || types[j] == DOUBLE) {
+					parsed = CSVReader::parseFloat(row[j], float_value);
+					if(!parsed && CSVReader::parseInt(row[j], int_value)) {
+						float_value = int_value;
+						parsed = true;
+					}
+				} else
+					parsed = CSVReader::parseInt(row[j], int_value);
+				if(!parsed || !fitsColumnType(types[j], int_value, float_value)) {
+					stringstream ss;
+					ss << "CSV File: " << csv_path << ":" << csv.lineNumber()
+					   << ": '" << row[j].str() << "' is not a valid "
+					   << getTypeName(types[j]) << " value";
+					throw JCUTException(ss.str());
+				}
+				switch(types[j]) {
+				case INT8: writeValue<int8_t>(out, int_value); break;
+				case INT16: writeValue<int16_t>(out, int_value); break;
+				case INT32: writeValue<int32_t>(out, int_value); break;
+				case INT64: writeValue<int64_t>(out, int_value); break;
+				case FLOAT: writeValue<float>(out, float_value); break;
+				case DOUBLE: writeValue<double>(out, float_value); break;
+				case BLOB: assert(false && "BLOB columns can not be converted from CSV");
+				}
+			}
+		}
+	} catch(...) {
+		// A partial file would be taken for a valid one by the tests
+		fclose(out);
+		remove(jcb_path.c_str());
+		throw;
+	}
+	if(fclose(out)) {
+		remove(jcb_path.c_str());
+		throw JCUTException("Could not write file "+jcb_path);
+	}
+}
+
+string JCBFile::toString(unsigned j, uint64_t row) const
+{
+	const char* value = static_cast<const char*>(getColumnData(j)) + row * getElementSize(j);
+	stringstream ss;
+	switch(getType(j)) {
+	case INT8: ss << (int) *reinterpret_cast<const int8_t*>(value); break;
+	case INT16: ss << *reinterpret_cast<const int16_t*>(value); break;
+	case INT32: ss << *reinterpret_cast<const int32_t*>(value); break;
+	case INT64: ss << *reinterpret_cast<const int64_t*>(value); break;
+	case FLOAT: ss << *reinterpret_cast<const float*>(value); break;
+	case DOUBLE: ss << *reinterpret_cast<const double*>(value); break;
+	case BLOB:
+		ss << "{" << hex << setfill('0');
+		for(unsigned i = 0; i < getElementSize(j); ++i)
+			ss << (i ? "," : "") << "0x" << setw(2) << (unsigned) (uint8_t) value[i];
+		ss << "}";
+		break;
+	}
+	return ss.str();
+}
+
+} // namespace tp
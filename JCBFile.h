@@ -0,0 +1,121 @@
+//===-- jcut/JCBFile.h - Binary columnar data files -------------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Binary columnar data files (.jcb) for the DataPlaceholders.
+///
+/// All the values are little endian. The file starts with a header:
+///
+///   offset 0   char[4]   magic "JCB1"
+///   offset 4   uint32    number of columns
+///   offset 8   uint64    number of rows
+///   offset 16  one 16 bytes descriptor per column:
+///              uint32    type (JCBFile::ColumnType)
+///              uint32    size in bytes of one value
+///              uint64    offset in the file of the first value
+///
+/// The values of a column are stored one after the other and the offset of
+/// every column is aligned to 16 bytes. The file is mapped in memory and the
+/// columns are used directly as the arrays the test loop reads the arguments
+/// from, nothing is parsed nor copied.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef JCBFILE_H_
+#define JCBFILE_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+namespace tp {
+
+class JCBFile {
+public:
+	enum ColumnType {
+		INT8 = 1,
+		INT16,
+		INT32,
+		INT64,
+		FLOAT,
+		DOUBLE,
+		BLOB, // Fixed size struct values
+	};
+
+	struct ColumnDescriptor {
+		uint32_t mType;
+		uint32_t mSize;
+		uint64_t mOffset;
+	};
+
+	static const char Magic[4];
+	static const unsigned HeaderSize = 16;
+	static const unsigned Alignment = 16;
+private:
+	string mPath;
+	const char* mData;
+	size_t mSize;
+	uint64_t mRows;
+	vector<ColumnDescriptor> mColumns;
+
+	/// Reads the header and the column descriptors, throws a JCUTException
+	/// when they do not describe the mapped file.
+	void validate();
+public:
+	explicit JCBFile(const string& path);
+	JCBFile(const JCBFile&) = delete;
+	JCBFile& operator=(const JCBFile&) = delete;
+	~JCBFile();
+
+	/// True when path has the .jcb extension
+	static bool isJCBFile(const string& path);
+	/// Size in bytes of a value of the given type, 0 for BLOB.
+	static unsigned getTypeSize(ColumnType type);
+	static string getTypeName(ColumnType type);
+
+	/// Writes a .jcb file with the content of a CSV file. types has one entry
+	/// per column, when empty the type of every column is guessed: INT64 if
+	/// all the values are integers or chars, DOUBLE otherwise. A value that
+	/// does not fit the type of its column is an error, nothing is written
+	/// when the conversion fails.
+	static void convertCSV(const string& csv_path, const string& jcb_path,
+			vector<ColumnType> types);
+	/// Parses a comma separated list of types: i8,i16,i32,i64,f32,f64
+	static vector<ColumnType> parseTypes(const string& list);
+
+	const string& getPath() const { return mPath; }
+	unsigned columnCount() const { return mColumns.size(); }
+	uint64_t rowCount() const { return mRows; }
+	ColumnType getType(unsigned j) const { return static_cast<ColumnType>(mColumns[j].mType); }
+	unsigned getElementSize(unsigned j) const { return mColumns[j].mSize; }
+	/// Pointer to the first value of the column j inside the mapped file
+	const void* getColumnData(unsigned j) const { return mData + mColumns[j].mOffset; }
+	/// The value at row as text, used to report the failing rows.
+	string toString(unsigned j, uint64_t row) const;
+};
+
+} // namespace tp
+
+#endif /* JCBFILE_H_ */
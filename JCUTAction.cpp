@@ -28,20 +28,53 @@
 
 #include "JCUTAction.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <thread>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <glob.h>
+#include <sys/stat.h>
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
+#include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/CompilerInstance.h"
 
 #include "TestParser.h"
 #include "TestGeneratorVisitor.h"
 #include "TestRunnerVisitor.h"
 #include "TestLoggerVisitor.h"
+#include "Fuzzer.h"
+#include "PlanCache.h"
+#include "TestReporter.h"
+#include "Worker.h"
+#include "TimeReport.h"
 
 using namespace llvm;
 
-extern cl::opt<string> TestFileOpt;
+extern cl::list<string> TestFileOpt;
+extern cl::opt<string> TestPatternOpt;
 extern cl::opt<bool> DumpOpt;
+extern cl::opt<bool> DataLoopOpt;
+extern cl::opt<string> PlanCacheOpt;
+extern cl::opt<unsigned> ColumnWidthOpt;
+extern cl::opt<string> ReportOpt;
+extern cl::opt<string> WorkersOpt;
+extern cl::opt<string> WorkerTokenOpt;
+extern cl::opt<bool> BenchOpt;
+extern cl::opt<string> FuzzOpt;
+extern cl::opt<string> FuzzCorpusOpt;
+extern cl::opt<unsigned> FuzzRunsOpt;
+extern cl::opt<unsigned> FuzzMaxLenOpt;
+extern cl::opt<unsigned> FuzzSeedOpt;
 
 // Static variables from StdCapture class.
 // @todo check if we can make them object variables.
@@ -56,8 +89,372 @@ namespace jcut {
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "JCUTAction"
 
+/// A test file of a run. All its nodes, including the copies made for the
+/// rows of the data files, are freed at once with it.
+struct TestPlanFile {
+	string mPath;
+	// Declared before the tests so it is destroyed after them
+	TestArena mArena;
+	unique_ptr<TestExpr> mTests;
+	// Why the file could not be parsed
+	string mError;
+
+	explicit TestPlanFile(const string& path) : mPath(path), mArena(),
+			mTests(nullptr), mError() {}
+};
+
+/// The tests of one run, shared by the modules of all its source files.
+struct TestPlan {
+	vector<unique_ptr<TestPlanFile>> mFiles;
+	// Number of source files whose compilation ended, with errors or not
+	unsigned mModuleCount;
+
+	TestPlan() : mFiles(), mModuleCount(0) {}
+
+	/// Visits the tests of every file that could be parsed
+	void accept(Visitor* v) {
+		for(unique_ptr<TestPlanFile>& file : mFiles) {
+			if(file->mTests == nullptr)
+				continue;
+			JCUTException::mExceptionSource = file->mPath;
+			TestArena::Scope arena_scope(file->mArena);
+			file->mTests->accept(v);
+		}
+	}
+};
+
+namespace {
+
+/// Last modification of a file, 0 when it can not be read
+time_t getModificationTime(const string& path)
+{
+	struct stat st;
+	if(stat(path.c_str(), &st) != 0)
+		return 0;
+	return st.st_mtime;
+}
+
+/// The source file being compiled and the headers it includes, without the
+/// system headers.
+vector<string> getDependencies(CompilerInstance& CI)
+{
+	vector<string> files;
+	SourceManager& SM = CI.getSourceManager();
+	for(SourceManager::fileinfo_iterator it = SM.fileinfo_begin();
+			it != SM.fileinfo_end(); ++it) {
+		if(it->second->IsSystemFile)
+			continue;
+		SmallString<128> path(it->first->getName());
+		llvm::sys::fs::make_absolute(path);
+		files.push_back(path.str().str());
+	}
+	return files;
+}
+
+/// The IR without the numbers of the attribute groups (#0) and of the
+/// metadata (!12), they change when other functions of the module change.
+/// The text of string constants is kept as is.
+string normalizeIR(const string& ir)
+{
+	string normalized;
+	normalized.reserve(ir.size());
+	bool quoted = false;
+	for(size_t i = 0; i < ir.size(); ++i) {
+		char c = ir[i];
+		normalized += c;
+		if(c == '"')
+			quoted = !quoted;
+		else if(!quoted && (c == '#' || c == '!'))
+			while(i + 1 < ir.size() && isdigit(static_cast<unsigned char>(ir[i + 1])))
+				++i;
+	}
+	return normalized;
+}
+
+/// Hash of the IR of every function defined in the module. The global
+/// variables a function uses are part of its IR, a new initial value changes
+/// the function.
+map<string, size_t> hashFunctions(llvm::Module* module)
+{
+	map<string, size_t> hashes;
+	for(llvm::Module::iterator F = module->begin(); F != module->end(); ++F) {
+		if(F->isDeclaration())
+			continue;
+		string ir;
+		llvm::raw_string_ostream os(ir);
+		// The attributes themselves, not the number of their group
+		os << F->getAttributes().getAsString(llvm::AttributeSet::FunctionIndex) << "\n";
+		F->print(os);
+		for(llvm::Function::iterator BB = F->begin(); BB != F->end(); ++BB)
+			for(llvm::BasicBlock::iterator I = BB->begin(); I != BB->end(); ++I)
+				for(unsigned i = 0; i < I->getNumOperands(); ++i) {
+					llvm::Value* op = I->getOperand(i)->stripPointerCasts();
+					if(llvm::GlobalVariable* GV = llvm::dyn_cast<llvm::GlobalVariable>(op))
+						GV->print(os);
+				}
+		os.flush();
+		hashes[F->getName().str()] = hash<string>()(normalizeIR(ir));
+	}
+	return hashes;
+}
+
+/// Adds the functions each function of the module uses, called or taken the
+/// address of, to callers.
+void addCallers(llvm::Module* module, map<string, set<string>>& callers)
+{
+	for(llvm::Module::iterator F = module->begin(); F != module->end(); ++F) {
+		if(F->isDeclaration())
+			continue;
+		for(llvm::Function::iterator BB = F->begin(); BB != F->end(); ++BB)
+			for(llvm::BasicBlock::iterator I = BB->begin(); I != BB->end(); ++I)
+				for(unsigned i = 0; i < I->getNumOperands(); ++i) {
+					llvm::Value* op = I->getOperand(i)->stripPointerCasts();
+					if(llvm::Function* callee = llvm::dyn_cast<llvm::Function>(op))
+						callers[callee->getName().str()].insert(F->getName().str());
+				}
+	}
+}
+
+/// Gives the tests of the other functions to no source file, so no module
+/// runs them. A test also runs when a function called by its before, after
+/// or mockup statements, or by the ones of its groups, is one of them.
+class AffectedTestsVisitor : public Visitor {
+private:
+	const set<string>& mFunctions;
+	/// Whether each group being visited, and the ones around it, call one of
+	/// the functions.
+	vector<bool> mGroupAffected;
+
+	bool calls(const TestFixture* TF) const {
+		if(TF == nullptr)
+			return false;
+		for(const shared_ptr<TestExpr>& stmt : TF->getStatements())
+			if(stmt->getType() == TestExpr::FUNC_CALL && mFunctions.count(
+					static_cast<FunctionCall*>(stmt.get())->getIdentifier()->toString()))
+				return true;
+		return false;
+	}
+	bool calls(const MockupFixture* MF) const {
+		if(MF == nullptr)
+			return false;
+		for(const MockupFunction* F : MF->getMockupFunctions())
+			if(mFunctions.count(F->getFunctionCall()->getIdentifier()->toString()))
+				return true;
+		return false;
+	}
+public:
+	explicit AffectedTestsVisitor(const set<string>& functions) : mFunctions(functions) {}
+
+	void VisitTestGroupFirst(TestGroup* TG) {
+		bool affected = mGroupAffected.size() && mGroupAffected.back();
+		if(const GlobalSetup* GS = TG->getGlobalSetup())
+			affected = affected || calls(GS->getTestFixture());
+		if(const GlobalTeardown* GT = TG->getGlobalTeardown())
+			affected = affected || calls(GT->getTestFixture());
+		if(const GlobalMockup* GM = TG->getGlobalMockup())
+			affected = affected || calls(GM->getMockupFixture());
+		mGroupAffected.push_back(affected);
+	}
+
+	void VisitTestGroup(TestGroup* TG) {
+		mGroupAffected.pop_back();
+	}
+
+	void VisitTestDefinition(TestDefinition* TD) {
+		string name = TD->getTestFunction()->getFunctionCall()->getIdentifier()->toString();
+		if(mFunctions.count(name) || (mGroupAffected.size() && mGroupAffected.back()))
+			return;
+		if(TD->getTestSetup() && calls(TD->getTestSetup()->getTestFixture()))
+			return;
+		if(TD->getTestTeardown() && calls(TD->getTestTeardown()->getTestFixture()))
+			return;
+		if(TD->getTestMockup() && calls(TD->getTestMockup()->getMockupFixture()))
+			return;
+		TD->setSourceFile("<not run>");
+	}
+};
+
+/// The tests no source file took, the source file that would have run them
+/// did not compile.
+class DroppedTestsVisitor : public Visitor {
+private:
+	unsigned mCount;
+public:
+	DroppedTestsVisitor() : mCount(0) {}
+
+	void VisitTestDefinition(TestDefinition* TD) {
+		if(!TD->getSourceFile().empty())
+			return;
+		string name = TD->getTestFunction()->getFunctionCall()->getIdentifier()->toString();
+		errs() << JCUTException::mExceptionSource << ":" << TD->getLine() << ":"
+		       << TD->getColumn() << ": The test of " << name
+		       << " was not run, its source file did not compile\n";
+		TD->setSourceFile("<not run>");
+		++mCount;
+	}
+
+	unsigned getCount() const { return mCount; }
+};
+
+bool matchesTestPattern(const string& name)
+{
+	stringstream ss(TestPatternOpt.getValue());
+	string pattern;
+	while(getline(ss, pattern, ','))
+		if(pattern.size() && fnmatch(pattern.c_str(), name.c_str(), 0) == 0)
+			return true;
+	return false;
+}
+
+/// Adds the test files inside dir and its subdirectories, sorted by name
+void findTestFiles(const string& dir, vector<string>& files)
+{
+	DIR* d = opendir(dir.c_str());
+	if(d == nullptr)
+		throw JCUTException("Unable to open the directory "+dir);
+	vector<string> names;
+	while(dirent* entry = readdir(d)) {
+		string name = entry->d_name;
+		if(name != "." && name != "..")
+			names.push_back(name);
+	}
+	closedir(d);
+	sort(names.begin(), names.end());
+
+	for(const string& name : names) {
+		string path = dir + "/" + name;
+		struct stat st;
+		if(stat(path.c_str(), &st) != 0)
+			continue;
+		if(S_ISDIR(st.st_mode))
+			findTestFiles(path, files);
+		else if(S_ISREG(st.st_mode) && matchesTestPattern(name))
+			files.push_back(path);
+	}
+}
+
+/// The files, directories and globs given with -t turned into test files
+vector<string> getTestFiles()
+{
+	vector<string> files;
+	for(const string& arg : TestFileOpt) {
+		glob_t paths;
+		// A path without a match is kept as is, opening it reports the error
+		if(glob(arg.c_str(), GLOB_NOCHECK | GLOB_TILDE, nullptr, &paths) != 0)
+			throw JCUTException("Invalid test file pattern "+arg);
+		for(size_t i = 0; i < paths.gl_pathc; ++i) {
+			string path = paths.gl_pathv[i];
+			struct stat st;
+			if(stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+				while(path.size() > 1 && path.back() == '/')
+					path.pop_back();
+				findTestFiles(path, files);
+			} else
+				files.push_back(path);
+		}
+		globfree(&paths);
+	}
+	// A file given twice runs once
+	vector<string> unique_files;
+	for(const string& file : files)
+		if(find(unique_files.begin(), unique_files.end(), file) == unique_files.end())
+			unique_files.push_back(file);
+	if(unique_files.empty())
+		throw JCUTException("No test files were found, the names of the test "
+				"files in a directory have to match "+TestPatternOpt.getValue());
+	return unique_files;
+}
+
+/// Runs in its own thread, the file gets its own arena and error source.
+///
+/// Unless the rows of the data files run in a loop, the tests are copied for
+/// every row here, once for all the modules. The copies do not depend on the
+/// module, so they are what --plan-cache keeps.
+void parseTestFile(TestPlanFile& file, const char* text = nullptr)
+{
+	TestArena::Scope arena_scope(file.mArena);
+	JCUTException::mExceptionSource = file.mPath;
+	try {
+		// The rows of a data loop are read with the types of the module
+		bool expand = DataLoopOpt.getValue() == false;
+		bool use_cache = expand && text == nullptr && PlanCacheOpt.getValue().size();
+		PlanCache cache(PlanCacheOpt.getValue());
+		if(use_cache) {
+			TimeReport::Timer timer(TimeReport::PLAN_CACHE, file.mPath);
+			file.mTests.reset(cache.load(file.mPath));
+			if(file.mTests)
+				return;
+		}
+		TimeReport::Timer timer(TimeReport::TOKENIZE, file.mPath);
+		TestDriver driver;
+		if(text)
+			driver.tokenize(text);
+		else
+			driver.tokenize(file.mPath);
+		timer.next(TimeReport::PARSE);
+		file.mTests.reset(driver.ParseTestExpr()); // Parse file and generate object structure tree
+		if(expand) {
+			timer.next(TimeReport::DATA_EXPANSION);
+			DataPlaceholderVisitor dp;
+			file.mTests->accept(&dp);
+		}
+		if(use_cache) {
+			timer.next(TimeReport::PLAN_CACHE);
+			cache.save(file.mPath, file.mTests.get());
+		}
+	} catch(const UnexpectedToken& e) {
+		file.mError = e.what();
+	} catch(const JCUTException& e) {
+		file.mError = e.what();
+		file.mTests.reset(); // A test without its data file is not run
+	}
+}
+
+} // anonymous namespace
+
+/// A source file compiled for the interpreter or --watch. The tests run in
+/// a copy of its module: the mockups rewrite the callers of the functions
+/// they replace, the original stays as clang generated it.
+struct SessionModule {
+	struct File {
+		string mPath;
+		time_t mModified;
+		uint64_t mHash;
+	};
+	string mSource;
+	// The source file and its headers as they were compiled
+	vector<File> mFiles;
+	unique_ptr<llvm::Module> mModule;
+
+	SessionModule(const string& source, llvm::Module* module) :
+		mSource(source), mFiles(), mModule(module) {}
+
+	/// A file only touched is not compiled again
+	bool isOutdated() {
+		for(File& file : mFiles) {
+			time_t modified = getModificationTime(file.mPath);
+			if(modified == file.mModified)
+				continue;
+			if(PlanCache::hashFile(file.mPath) != file.mHash)
+				return true;
+			file.mModified = modified;
+		}
+		return false;
+	}
+};
+
 bool JCUTAction::mUseInterpreterInput;
 std::string JCUTAction::mInterpreterInput;
+std::vector<std::string> JCUTAction::mSourceFiles;
+std::unique_ptr<TestPlan> JCUTAction::mTestPlan;
+std::vector<std::unique_ptr<TestReporter>> JCUTAction::mReporters;
+bool JCUTAction::mReportsOpen = false;
+// Declared before the session so it is destroyed after its modules
+std::unique_ptr<llvm::LLVMContext> JCUTAction::mSessionContext;
+std::vector<std::unique_ptr<SessionModule>> JCUTAction::mSession;
+std::set<std::string> JCUTAction::mChangedFunctions;
+bool JCUTAction::mKeepSession = false;
+bool JCUTAction::mCompileOnly = false;
 // @todo remove this global variable.
 int TotalTestsFailed = 0;
 
@@ -77,6 +474,329 @@ bool JCUTAction::BeginSourceFileAction(CompilerInstance &CI, StringRef Filename)
 	return true;
 }
 
+void JCUTAction::setSourceFiles(const std::vector<std::string>& sources) {
+	mSourceFiles = sources;
+	mTestPlan.reset();
+}
+
+std::vector<std::unique_ptr<TestReporter>>& JCUTAction::getReporters() {
+	if(mReportsOpen)
+		return mReporters;
+	mReportsOpen = true;
+	mReporters = TestReporter::create(ReportOpt.getValue());
+	for(unique_ptr<TestReporter>& reporter : mReporters)
+		reporter->begin();
+	return mReporters;
+}
+
+void JCUTAction::endRun() {
+	// The last source file takes the tests of the functions no other file
+	// defines, they are lost when it does not compile.
+	if(mTestPlan) {
+		DroppedTestsVisitor dropped;
+		mTestPlan->accept(&dropped);
+		TotalTestsFailed += dropped.getCount();
+	}
+	TimeReport::Timer timer(TimeReport::REPORTING, "");
+	for(unique_ptr<TestReporter>& reporter : mReporters)
+		reporter->end();
+	mReporters.clear();
+	mReportsOpen = false;
+}
+
+llvm::LLVMContext* JCUTAction::getSessionContext() {
+	if(!mSessionContext)
+		mSessionContext.reset(new llvm::LLVMContext);
+	return mSessionContext.get();
+}
+
+bool JCUTAction::hasSession(const std::vector<std::string>& sources) {
+	if(mSession.empty() || mSession.size() != sources.size())
+		return false;
+	for(unique_ptr<SessionModule>& m : mSession)
+		if(find(sources.begin(), sources.end(), m->mSource) == sources.end())
+			return false;
+	return getOutdatedSources(sources).empty();
+}
+
+std::vector<std::string> JCUTAction::getOutdatedSources(
+		const std::vector<std::string>& sources) {
+	vector<string> outdated;
+	for(const string& source : sources) {
+		auto it = find_if(mSession.begin(), mSession.end(),
+				[&](const unique_ptr<SessionModule>& m) { return m->mSource == source; });
+		if(it == mSession.end() || (*it)->isOutdated())
+			outdated.push_back(source);
+	}
+	return outdated;
+}
+
+std::vector<std::string> JCUTAction::getSessionFiles() {
+	vector<string> files;
+	for(unique_ptr<SessionModule>& m : mSession)
+		for(const SessionModule::File& file : m->mFiles)
+			if(find(files.begin(), files.end(), file.mPath) == files.end())
+				files.push_back(file.mPath);
+	return files;
+}
+
+std::vector<std::string> JCUTAction::getTestFileNames() {
+	return getTestFiles();
+}
+
+void JCUTAction::closeSession() {
+	mSession.clear();
+	mChangedFunctions.clear();
+}
+
+void JCUTAction::addToSession(const std::string& source, llvm::Module* module,
+		const std::vector<std::string>& files) {
+	unique_ptr<SessionModule> m(new SessionModule(source, module));
+	for(const string& file : files) {
+		SessionModule::File f = { file, getModificationTime(file), PlanCache::hashFile(file) };
+		m->mFiles.push_back(f);
+	}
+
+	map<string, size_t> after = hashFunctions(module);
+	for(unique_ptr<SessionModule>& old : mSession) {
+		if(old->mSource != source)
+			continue;
+		// Only the tests of the functions that changed run again
+		map<string, size_t> before = hashFunctions(old->mModule.get());
+		for(auto& f : after) {
+			auto it = before.find(f.first);
+			if(it == before.end() || it->second != f.second)
+				mChangedFunctions.insert(f.first);
+		}
+		for(auto& f : before)
+			if(after.count(f.first) == 0)
+				mChangedFunctions.insert(f.first);
+		old = move(m);
+		return;
+	}
+	// A source file that could not be compiled before is new to all the tests
+	if(mCompileOnly)
+		for(auto& f : after)
+			mChangedFunctions.insert(f.first);
+	mSession.push_back(move(m));
+}
+
+std::set<std::string> JCUTAction::getAffectedFunctions() {
+	map<string, set<string>> callers;
+	for(unique_ptr<SessionModule>& m : mSession)
+		addCallers(m->mModule.get(), callers);
+	set<string> affected;
+	vector<string> pending(mChangedFunctions.begin(), mChangedFunctions.end());
+	while(pending.size()) {
+		string name = pending.back();
+		pending.pop_back();
+		if(!affected.insert(name).second)
+			continue;
+		for(const string& caller : callers[name])
+			pending.push_back(caller);
+	}
+	return affected;
+}
+
+unsigned JCUTAction::runSession(const std::set<std::string>* functions,
+		const std::vector<std::string>& test_files,
+		const std::vector<std::string>* sources) {
+	// The tests are parsed again, they may have changed
+	mTestPlan.reset();
+	TestPlan* plan = getTestPlan();
+	if(functions) {
+		// A test file that changed runs all its tests
+		AffectedTestsVisitor affected(*functions);
+		for(unique_ptr<TestPlanFile>& file : plan->mFiles) {
+			if(file->mTests == nullptr || find(test_files.begin(),
+					test_files.end(), file->mPath) != test_files.end())
+				continue;
+			JCUTException::mExceptionSource = file->mPath;
+			TestArena::Scope arena_scope(file->mArena);
+			file->mTests->accept(&affected);
+		}
+	}
+	vector<SessionModule*> modules;
+	for(unique_ptr<SessionModule>& m : mSession)
+		if(sources == nullptr || find(sources->begin(), sources->end(),
+				m->mSource) != sources->end())
+			modules.push_back(m.get());
+	unsigned count = 0;
+	for(size_t i = 0; i < modules.size(); ++i) {
+		SessionModule& m = *modules[i];
+		try {
+			count += runModule(plan, llvm::CloneModule(m.mModule.get()), m.mSource,
+					i + 1 == modules.size());
+		} catch(const UnexpectedToken& e){
+			errs() << e.what() << "\n";
+		}
+		catch (const JCUTException& e) {
+			errs() << e.what() << "\n";
+		}
+	}
+	endRun();
+	return count;
+}
+
+void JCUTAction::runInterpreterInput() {
+	runSession(nullptr, vector<string>());
+}
+
+unsigned JCUTAction::runTests(const std::vector<std::string>& sources) {
+	return runSession(nullptr, vector<string>(), &sources);
+}
+
+unsigned JCUTAction::runChangedTests(const std::vector<std::string>& test_files) {
+	set<string> affected = getAffectedFunctions();
+	mChangedFunctions.clear();
+	return runSession(&affected, test_files);
+}
+
+TestPlan* JCUTAction::getTestPlan() {
+	if(mTestPlan)
+		return mTestPlan.get();
+	mTestPlan.reset(new TestPlan);
+	vector<unique_ptr<TestPlanFile>>& files = mTestPlan->mFiles;
+	if(mUseInterpreterInput) {
+		files.push_back(unique_ptr<TestPlanFile>(new TestPlanFile("jcut")));
+		parseTestFile(*files.back(), mInterpreterInput.c_str());
+	} else {
+		for(const string& path : getTestFiles())
+			files.push_back(unique_ptr<TestPlanFile>(new TestPlanFile(path)));
+		// The files are independent, each thread takes the next one
+		atomic<unsigned> next(0);
+		auto parse = [&]() {
+			for(unsigned i = next++; i < files.size(); i = next++)
+				parseTestFile(*files[i]);
+		};
+		unsigned thread_count = min<unsigned>(max(thread::hardware_concurrency(), 1u),
+				files.size());
+		vector<thread> threads;
+		for(unsigned i = 1; i < thread_count; ++i)
+			threads.push_back(thread(parse));
+		parse();
+		for(thread& t : threads)
+			t.join();
+	}
+	// Reported once, not for every source file
+	for(unique_ptr<TestPlanFile>& file : files)
+		if(file->mError.size())
+			errs() << file->mError << "\n";
+	return mTestPlan.get();
+}
+
+void JCUTAction::runFuzzer(llvm::Module* module) {
+	JCUTException::mExceptionSource = "jcut";
+	// The module is deleted on every return until the JIT takes it
+	unique_ptr<llvm::Module> owned_module(module);
+	// The counters are added before the JIT takes the module
+	Fuzzer fuzzer(module, FuzzOpt.getValue());
+	std::string Error;
+	unique_ptr<llvm::ExecutionEngine> EE(llvm::ExecutionEngine::createJIT(module, &Error));
+	if (!EE) {
+		llvm::errs() << "unable to make execution engine: " << Error << "\n";
+		return;
+	}
+	owned_module.release();
+	string corpus = FuzzCorpusOpt.getValue();
+	if(corpus.empty())
+		corpus = "fuzz-"+FuzzOpt.getValue();
+	llvm::outs() << "Fuzzing " << FuzzOpt.getValue() << ": " << fuzzer.edgeCount()
+			<< " edges, " << fuzzer.headerSize() << " bytes header, corpus in "
+			<< corpus << "\n";
+	llvm::outs().flush();
+	fuzzer.run(EE.get(), corpus, FuzzRunsOpt.getValue(),
+			FuzzMaxLenOpt.getValue(), FuzzSeedOpt.getValue());
+}
+
+unsigned JCUTAction::runModule(TestPlan* plan, llvm::Module* module,
+		const string& source, bool last) {
+	// The module is deleted on every return until the JIT takes it
+	unique_ptr<llvm::Module> owned_module(module);
+	// Only the tests of the functions defined in this module are
+	// generated and run. The last source file takes the tests no
+	// other file defined, to report them.
+	SourceFileVisitor owner(module, source, last);
+	plan->accept(&owner);
+	if(owner.getTestCount() == 0)
+		return 0;
+
+	Trace::Span span("source", source);
+	// The workers of --workers generate and run the tests of the module
+	bool remote = WorkersOpt.getValue().size();
+	unique_ptr<TestRunnerVisitor> runner;
+	// The copies for the rows were made with the plan, this creates the
+	// tables of the tests run in a loop. With --workers it is done here too,
+	// the copies of the rows that can not run in a loop are numbered and
+	// sent to the workers with the other tests.
+	TimeReport::Timer timer(TimeReport::DATA_EXPANSION, source);
+	DataPlaceholderVisitor dp(DataLoopOpt.getValue(), module);
+	dp.setSourceFile(source);
+	plan->accept(&dp);
+	if(remote == false) {
+		// The tests of all the files go into the same module
+		timer.next(TimeReport::IR_GENERATION);
+		TestGeneratorVisitor visitor(module);
+		visitor.setSourceFile(source);
+		visitor.setBench(BenchOpt.getValue());
+		plan->accept(&visitor); // Generate LLVM IR code
+
+		timer.next(TimeReport::JIT);
+		Trace::Span jit_span("jit", "execution engine");
+		std::string Error;
+		llvm::ExecutionEngine* EE = llvm::ExecutionEngine::createJIT(module, &Error);
+		if(EE)
+			owned_module.release();
+		runner.reset(new TestRunnerVisitor(EE,DumpOpt.getValue(),module));
+		jit_span.end();
+		timer.stop();
+		if (runner->isValidExecutionEngine() == false) {
+			llvm::errs() << "unable to make execution engine: " << Error << "\n";
+			return 0;
+		}
+
+		runner->setSourceFile(source);
+	}
+	timer.stop();
+
+	TestLoggerVisitor results_logger;
+	results_logger.setLogFormat(TestLoggerVisitor::LOG_ALL);
+	if(ColumnWidthOpt.getValue())
+		results_logger.setFixedColumnWidth(ColumnWidthOpt.getValue());
+	else {
+		OutputFixerVisitor fixer(results_logger);
+		fixer.setSourceFile(source);
+		plan->accept(&fixer);
+	}
+	// Each test is printed as soon as it ran
+	vector<TestReporter*> reporters(1, &results_logger);
+	for(unique_ptr<TestReporter>& reporter : getReporters())
+		reporters.push_back(reporter.get());
+
+	results_logger.begin();
+	if(remote) {
+		// Timing the tests of another machine would mean nothing here
+		if(BenchOpt.getValue())
+			llvm::errs() << "--bench is ignored by the tests run with --workers\n";
+		vector<RemoteTestFile> files;
+		for(unique_ptr<TestPlanFile>& file : plan->mFiles)
+			if(file->mTests)
+				files.push_back(RemoteTestFile(file->mPath, file->mTests.get()));
+		TotalTestsFailed += runOnWorkers(WorkersOpt.getValue(),
+				WorkerTokenOpt.getValue(), module, source,
+				DataLoopOpt.getValue(), files, reporters);
+	} else {
+		for(TestReporter* reporter : reporters)
+			runner->addReporter(reporter);
+		plan->accept(runner.get());
+	}
+	results_logger.end();
+
+	// this application exits with the number of tests failed.
+	TotalTestsFailed += results_logger.getTestsFailed();
+	return owner.getTestCount();
+}
+
 void JCUTAction::EndSourceFileAction() {
 		DEBUG(errs() << "'JCUTAction' EndSourceFileAction\n");
 
@@ -85,47 +805,35 @@ void JCUTAction::EndSourceFileAction() {
 		llvm::Module* module = takeModule();
 
 		try {
-			TestDriver driver;
-			if(mUseInterpreterInput) {
-				JCUTException::mExceptionSource = "jcut";
-				driver.tokenize(mInterpreterInput.c_str());
-			}
-			else {
-				JCUTException::mExceptionSource = TestFileOpt.getValue(); // quick workaround
-				driver.tokenize(TestFileOpt.getValue());
+			// Only the module that defines the function is fuzzed
+			if(FuzzOpt.getValue().size()) {
+				llvm::Function* F = module ? module->getFunction(FuzzOpt.getValue()) : nullptr;
+				if(F && !F->isDeclaration())
+					runFuzzer(module);
+				else
+					delete module;
+				return;
 			}
-			unique_ptr<TestExpr> tests (driver.ParseTestExpr()); // Parse file and generate object structure tree
-
-			DataPlaceholderVisitor dp;
-			tests->accept(&dp); // Generate functions using data place holders.
-
-			TestGeneratorVisitor visitor(module);
-			tests->accept(&visitor); // Generate LLVM IR code
-
-			std::string Error;
-			TestRunnerVisitor runner(llvm::ExecutionEngine::createJIT(module, &Error),DumpOpt.getValue(),module);
-			if (runner.isValidExecutionEngine() == false) {
-				llvm::errs() << "unable to make execution engine: " << Error << "\n";
+			// A source file that did not compile has no module, the tests
+			// it would have taken are reported by endRun.
+			if(module == nullptr) {
+				if(!mCompileOnly)
+					++getTestPlan()->mModuleCount;
 				return;
 			}
+			string source = getCurrentFile().str();
+			// The next runs of the interpreter and of --watch use the module
+			// without compiling the source file again.
+			if(mKeepSession) {
+				addToSession(source, module, getDependencies(getCompilerInstance()));
+				if(mCompileOnly)
+					return;
+				module = llvm::CloneModule(module);
+			}
 
-			TestLoggerVisitor results_logger;
-			results_logger.setLogFormat(TestLoggerVisitor::LOG_ALL);
-			runner.setColumnOrder(results_logger.getColumnOrder());
-			runner.setColumnNames(results_logger.getColumnNames());
-
-			tests->accept(&runner);
-
-			OutputFixerVisitor fixer(results_logger);
-			// @note The following two calls have to happen in this exact
-			// same order:
-			//  1st OutputFixerVisitor so we can get the right widths of all the output
-			//  2nd TestLoggerVisitor so we can print the test information
-			tests->accept(&fixer);
-			tests->accept(&results_logger);
-
-			// this application exits with the number of tests failed.
-			TotalTestsFailed += results_logger.getTestsFailed();
+			TestPlan* plan = getTestPlan();
+			bool last = ++plan->mModuleCount >= mSourceFiles.size();
+			runModule(plan, module, source, last);
 		} catch(const UnexpectedToken& e){
 			errs() << e.what() << "\n";
 		}
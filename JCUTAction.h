@@ -33,17 +33,23 @@
 #include <string>
 #include <sstream>
 #include <memory>
+#include <set>
+#include <vector>
 #include "clang/CodeGen/CodeGenAction.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/RecursiveASTVisitor.h"
+#include "SymbolIndex.h"
 
 namespace clang {
 	class CompilerInstance;
 }
 namespace llvm {
 	class StringRef;
+	class Module;
+	class LLVMContext;
 }
+class TestReporter;
 
 using namespace clang;
 using llvm::StringRef;
@@ -52,7 +58,52 @@ namespace jcut {
 
 extern int TotalTestsFailed;
 
+struct TestPlan;
+struct SessionModule;
+
 class JCUTAction : public clang::EmitLLVMOnlyAction{
+private:
+	/// The C source files of the current run, in the order they are compiled
+	static std::vector<std::string> mSourceFiles;
+	/// The tests are parsed by the action of the first source file and used
+	/// by the actions of all the others.
+	static std::unique_ptr<TestPlan> mTestPlan;
+	/// The reports of --report, they are written for the whole run
+	static std::vector<std::unique_ptr<TestReporter>> mReporters;
+	static bool mReportsOpen;
+	/// Owns the modules of the session, it outlives the actions
+	static std::unique_ptr<llvm::LLVMContext> mSessionContext;
+	/// The source files compiled for the interpreter or --watch, kept
+	/// between their runs.
+	static std::vector<std::unique_ptr<SessionModule>> mSession;
+	/// The functions whose code changed since the last run of --watch
+	static std::set<std::string> mChangedFunctions;
+
+	/// Generates and runs the tests of the functions defined in module, it
+	/// takes ownership of the module. Returns the number of tests given to it.
+	static unsigned runModule(TestPlan* plan, llvm::Module* module,
+			const std::string& source, bool last);
+	/// Adds the module of a source file compiled again to the session, or
+	/// replaces the one it had. files are the source file and its headers.
+	static void addToSession(const std::string& source, llvm::Module* module,
+			const std::vector<std::string>& files);
+	/// Parses the tests and runs them in copies of the modules of the
+	/// session, or of the modules of sources when it is given. When
+	/// functions is given only their tests and the tests of test_files run.
+	/// Returns the number of tests run.
+	static unsigned runSession(const std::set<std::string>* functions,
+			const std::vector<std::string>& test_files,
+			const std::vector<std::string>* sources = nullptr);
+	/// The functions that changed and the ones calling them, directly or not
+	static std::set<std::string> getAffectedFunctions();
+	/// The context of the modules compiled for the interpreter
+	static llvm::LLVMContext* getSessionContext();
+	/// Fuzzes the function given with --fuzz instead of running the tests
+	void runFuzzer(llvm::Module* module);
+	/// Parses the tests the first time it is called in a run
+	static TestPlan* getTestPlan();
+	/// Opens the reports the first time it is called in a run
+	static std::vector<std::unique_ptr<TestReporter>>& getReporters();
 public:
 	/* These two static variables are used as workaround to communicate with
 	 * the main execution flow. Keep in mind that a JCUTAction will be
@@ -64,7 +115,40 @@ public:
 	 */
 	static bool mUseInterpreterInput;
 	static std::string mInterpreterInput;
-	JCUTAction() {}
+	/// The modules are kept in the session for the next runs
+	static bool mKeepSession;
+	/// The source files are compiled into the session, the tests do not run
+	static bool mCompileOnly;
+	JCUTAction() : EmitLLVMOnlyAction(mKeepSession ? getSessionContext() : nullptr) {}
+
+	/// Starts a new run over the given source files, the tests will be parsed
+	/// again the next time they are needed.
+	static void setSourceFiles(const std::vector<std::string>& sources);
+	/// Finishes the reports of the current run
+	static void endRun();
+
+	/// Whether the session holds the modules of exactly these source files
+	/// and none of them, or their headers, changed since they were compiled.
+	static bool hasSession(const std::vector<std::string>& sources);
+	/// The sources not in the session, or changed since they were compiled
+	static std::vector<std::string> getOutdatedSources(
+			const std::vector<std::string>& sources);
+	/// The source files of the session and the headers they include
+	static std::vector<std::string> getSessionFiles();
+	/// The test files given with -t
+	static std::vector<std::string> getTestFileNames();
+	/// Runs all the tests in the modules of the given source files of the
+	/// session. Returns the number of tests run.
+	static unsigned runTests(const std::vector<std::string>& sources);
+	/// Runs the tests of test_files and the tests of the functions affected
+	/// by the source files compiled since the last call. Returns the number
+	/// of tests run.
+	static unsigned runChangedTests(const std::vector<std::string>& test_files);
+	/// Runs mInterpreterInput in copies of the modules of the session, the
+	/// source files are not compiled again.
+	static void runInterpreterInput();
+	/// Forgets the modules of the session, the next run compiles them again
+	static void closeSession();
 
 	bool BeginInvocation(CompilerInstance& CI);
 	bool BeginSourceFileAction(CompilerInstance &CI, StringRef Filename);
@@ -72,53 +156,81 @@ public:
 };
 
 /////////
-class LsFunctionsVisitor : public RecursiveASTVisitor<LsFunctionsVisitor> {
+/// Adds the functions, global variables and types declared in a C file to
+/// the SymbolIndex.
+class IndexSymbolsVisitor : public RecursiveASTVisitor<IndexSymbolsVisitor> {
 private:
 	std::string mCurrentFile;
+
+	bool isInCurrentFile(Decl* D) {
+		SourceManager& m = D->getASTContext().getSourceManager();
+		return mCurrentFile == m.getFilename(D->getLocation()).str();
+	}
 public:
-	LsFunctionsVisitor(const std::string str) : mCurrentFile(str) {}
-	virtual ~LsFunctionsVisitor() {}
+	IndexSymbolsVisitor(const std::string str) : mCurrentFile(str) {}
+	virtual ~IndexSymbolsVisitor() {}
 	virtual bool VisitFunctionDecl(FunctionDecl* D){
-		SourceLocation sl = D->getLocation();
-		SourceManager& m = D->getASTContext().getSourceManager();
-		std::string source_location = m.getFilename(sl).str();
-		if(mCurrentFile == source_location) {
+		if(isInCurrentFile(D)) {
 			std::stringstream ss;
-			ss << "\t" << D->getCallResultType().getAsString() << " ";
+			ss << D->getCallResultType().getAsString() << " ";
 			ss << "\t" << D->getQualifiedNameAsString() << "(";
+			std::string params;
 			FunctionDecl::param_iterator i = nullptr;
 			for( i = D->param_begin(); i !=D->param_end(); ++i) {
 				ss << (*i)->getType().getAsString() << " ";
 				ss << (*i)->getFirstDecl()->getNameAsString() << ", ";
+				params += (params.size() ? ", " : "") + (*i)->getNameAsString();
 			}
 			std::string str = ss.str();
 			str = str.substr(0,str.find_last_of(","));
 			str += ");";
-			std::cout << str << std::endl;
+			SymbolIndex::instance().addSymbol(mCurrentFile, Symbol(Symbol::FUNCTION,
+					D->getNameAsString(), str, params));
 		}
 		return true;
 	}
+	virtual bool VisitVarDecl(VarDecl* D) {
+		if(D->isFileVarDecl() && isInCurrentFile(D))
+			SymbolIndex::instance().addSymbol(mCurrentFile, Symbol(Symbol::GLOBAL,
+					D->getNameAsString(), D->getType().getAsString() + " " +
+					D->getNameAsString() + ";"));
+		return true;
+	}
+	virtual bool VisitTypedefNameDecl(TypedefNameDecl* D) {
+		if(isInCurrentFile(D))
+			SymbolIndex::instance().addSymbol(mCurrentFile, Symbol(Symbol::TYPE,
+					D->getNameAsString(), "typedef " +
+					D->getUnderlyingType().getAsString() + " " + D->getNameAsString() + ";"));
+		return true;
+	}
+	virtual bool VisitTagDecl(TagDecl* D) {
+		if(D->isCompleteDefinition() && D->getIdentifier() && isInCurrentFile(D))
+			SymbolIndex::instance().addSymbol(mCurrentFile, Symbol(Symbol::TYPE,
+					D->getNameAsString(), std::string(D->getKindName()) + " " +
+					D->getNameAsString() + ";"));
+		return true;
+	}
 };
 
-class LsFunctionsConsumer : public ASTConsumer {
+class IndexSymbolsConsumer : public ASTConsumer {
 public:
-	LsFunctionsConsumer(const std::string s) {
-		visitor = std::unique_ptr<LsFunctionsVisitor>(new LsFunctionsVisitor(s));
+	IndexSymbolsConsumer(const std::string s) {
+		visitor = std::unique_ptr<IndexSymbolsVisitor>(new IndexSymbolsVisitor(s));
 	}
-	virtual ~LsFunctionsConsumer() {}
+	virtual ~IndexSymbolsConsumer() {}
 	virtual void HandleTranslationUnit(ASTContext& C) {
 		visitor->TraverseTranslationUnitDecl(C.getTranslationUnitDecl());
-		std::cout << std::endl;
 	}
 private:
-	std::unique_ptr<LsFunctionsVisitor> visitor;
+	std::unique_ptr<IndexSymbolsVisitor> visitor;
 };
 
-class LsFunctionsAction : public ASTFrontendAction {
+/// Indexes the symbols of the C files, the ones indexed before are forgotten
+class IndexSymbolsAction : public ASTFrontendAction {
 	virtual ASTConsumer* CreateASTConsumer(
 			clang::CompilerInstance &Compiler, llvm::StringRef InFile) {
-		std::cout << InFile.str() << ":" << std::endl;
-		return new LsFunctionsConsumer(InFile.str());
+		SymbolIndex::instance().beginFile(InFile.str());
+		return new IndexSymbolsConsumer(InFile.str());
 	}
 };
 ////////
@@ -0,0 +1,771 @@
+//===-- jcut/PlanCache.cpp - Cache of the parsed test files -----*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "PlanCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "TestParser.h"
+
+namespace {
+
+using namespace tp;
+
+const char Magic[4] = {'J', 'C', 'P', '1'};
+// Changed every time the format changes, the caches of another version are
+// parsed again.
+const uint32_t FormatVersion = 2;
+
+uint64_t fnv1a(const char* data, size_t size)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for(size_t i = 0; i < size; ++i) {
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+/// A whole file mapped in memory, read only
+class MappedFile {
+private:
+	const char* mData;
+	size_t mSize;
+public:
+	explicit MappedFile(const string& path) : mData(nullptr), mSize(0) {
+		int fd = open(path.c_str(), O_RDONLY);
+		if(fd == -1)
+			return;
+		struct stat st;
+		if(fstat(fd, &st) == 0 && st.st_size > 0) {
+			void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(addr != MAP_FAILED) {
+				mData = static_cast<const char*>(addr);
+				mSize = st.st_size;
+			}
+		}
+		close(fd);
+	}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() {
+		if(mData)
+			munmap(const_cast<char*>(mData), mSize);
+	}
+
+	const char* data() const { return mData; }
+	size_t size() const { return mSize; }
+};
+
+/// The CSV files read to copy the tests for each of their rows. Binary data
+/// files and generators are read when the tests run, not when they are saved.
+class DataFileVisitor : public Visitor {
+private:
+	vector<string> mFiles;
+public:
+	void VisitTestInfo(TestData* data) {
+		if(data->hasGenerators())
+			return;
+		string path = data->getDataPath();
+		if(JCBFile::isJCBFile(path) == false &&
+		   find(mFiles.begin(), mFiles.end(), path) == mFiles.end())
+			mFiles.push_back(path);
+	}
+	const vector<string>& getFiles() const { return mFiles; }
+};
+
+class PlanWriter {
+private:
+	string mBuffer;
+
+	void write(const void* data, size_t size) {
+		mBuffer.append(static_cast<const char*>(data), size);
+	}
+public:
+	const string& getBuffer() const { return mBuffer; }
+
+	void u8(uint8_t value) { write(&value, 1); }
+	void u32(uint32_t value) { write(&value, 4); }
+	void i32(int32_t value) { write(&value, 4); }
+	void u64(uint64_t value) { write(&value, 8); }
+	void f32(float value) { write(&value, 4); }
+	void str(const string& s) {
+		u32(s.size());
+		write(s.data(), s.size());
+	}
+
+	void write(const NumericConstant* NC) {
+		u8(NC->isInt());
+		if(NC->isInt())
+			i32(NC->getInt());
+		else
+			f32(NC->getFloat());
+	}
+
+	void write(const Constant* C) {
+		u8(C->getType());
+		if(C->isNumericConstant())
+			write(C->getNumericConstant());
+		else if(C->isStringConstant())
+			str(C->getStringConstant()->getString());
+		else if(C->isCharConstant())
+			u8(C->getCharConstant()->getChar());
+		str(C->toString());
+	}
+
+	void write(const Operand* O) {
+		u8(O->isIdentifier());
+		if(O->isIdentifier())
+			str(O->getIdentifier()->toString());
+		else
+			write(O->getConstant());
+	}
+
+	void write(const ExpectedConstant* EC) {
+		u8(EC->isDataPlaceholder());
+		if(EC->isDataPlaceholder())
+			str(EC->getDataPlaceholder()->getName());
+		else
+			write(EC->getConstant());
+	}
+
+	void write(const InitializerValue* IV) {
+		u8(IV->isStructInitializer());
+		if(IV->isStructInitializer())
+			write(&IV->getStructInitializer());
+		else
+			write(&IV->getArgument());
+	}
+
+	void write(const StructInitializer* SI) {
+		if(const InitializerList* IL = SI->getInitializerList()) {
+			u8(0);
+			u32(IL->getArguments().size());
+			for(const InitializerValue* IV : IL->getArguments())
+				write(IV);
+			return;
+		}
+		const DesignatedInitializer* DI = SI->getDesignatedInitializer();
+		u8(1);
+		u32(DI->getInitializers().size());
+		for(const tuple<Identifier*,InitializerValue*>& init : DI->getInitializers()) {
+			str(get<0>(init)->toString());
+			write(get<1>(init));
+		}
+	}
+
+	void write(const BufferAlloc* BA) {
+		write(BA->getSizeConstant());
+		u8(BA->isAllocatingStruct());
+		if(BA->isAllocatingStruct())
+			write(BA->getStructInitializer());
+		else
+			write(BA->getDefaultValue());
+	}
+
+	void write(const FunctionArgument* FA) {
+		if(FA->isDataPlaceholder()) {
+			u8(2);
+			str(FA->getDataPlaceholder()->getName());
+		} else if(FA->isBufferAlloc()) {
+			u8(1);
+			write(FA->getBufferAlloc());
+		} else {
+			u8(0);
+			write(FA->getArgument());
+		}
+	}
+
+	void write(const FunctionCall* FC) {
+		str(FC->getIdentifier()->toString());
+		u32(FC->getArgCount());
+		for(const shared_ptr<FunctionArgument>& FA : FC->getArguments())
+			write(FA.get());
+	}
+
+	void write(const ExpectedExpression* EE) {
+		write(EE->getLHSOperand());
+		str(EE->getComparisonOperator()->toString());
+		write(EE->getRHSOperand());
+		i32(EE->getLine());
+		i32(EE->getColumn());
+	}
+
+	void write(const VariableAssignment* VA) {
+		str(VA->getIdentifier()->toString());
+		if(VA->isArgument()) {
+			u8(0);
+			write(VA->getConstant());
+		} else if(VA->isStructInitializer()) {
+			u8(1);
+			write(VA->getStructInitializer());
+		} else {
+			u8(2);
+			write(VA->getBufferAlloc());
+		}
+	}
+
+	void write(const MockupFunction* MF) {
+		write(MF->getFunctionCall());
+		if(MF->getConstant()) {
+			u8(0);
+			write(MF->getConstant());
+		} else if(MF->getVoidIdentifier()) {
+			u8(1);
+			str(MF->getVoidIdentifier()->toString());
+		} else if(MF->isSequence()) {
+			u8(2);
+			u32(MF->getSequence()->getValues().size());
+			for(const Constant* C : MF->getSequence()->getValues())
+				write(C);
+		} else {
+			u8(3);
+			str(MF->getDataPlaceholder()->getName());
+		}
+	}
+
+	void write(const MockupFixture* MF) {
+		vector<MockupFunction*> functions = MF->getMockupFunctions();
+		u32(functions.size());
+		for(const MockupFunction* F : functions)
+			write(F);
+		u32(MF->getMockupVariables().size());
+		for(const MockupVariable* MV : MF->getMockupVariables())
+			write(MV->getVariableAssignment());
+	}
+
+	void write(const TestFixture* TF) {
+		u32(TF->getStatements().size());
+		for(const shared_ptr<TestExpr>& stmt : TF->getStatements()) {
+			u8(stmt->getType());
+			if(stmt->getType() == TestExpr::FUNC_CALL)
+				write(static_cast<const FunctionCall*>(stmt.get()));
+			else if(stmt->getType() == TestExpr::VAR_ASSIGN)
+				write(static_cast<const VariableAssignment*>(stmt.get()));
+			else if(stmt->getType() == TestExpr::EXPECT_EXPR)
+				write(static_cast<const ExpectedExpression*>(stmt.get()));
+			else
+				throw JCUTException("Unexpected statement in a test fixture");
+		}
+	}
+
+	void write(const TestData* TD) {
+		u8(TD->hasGenerators());
+		if(TD->hasGenerators() == false) {
+			str(TD->getDataPath());
+			return;
+		}
+		u32(TD->getGenerators().size());
+		for(const DataGenerator* G : TD->getGenerators()) {
+			u8(G->getKind());
+			u32(G->getArguments().size());
+			for(const string& arg : G->getArguments())
+				str(arg);
+		}
+	}
+
+	void write(const TestDefinition* TD) {
+		i32(TD->getLine());
+		i32(TD->getColumn());
+		u8(TD->isProperty());
+		u8(TD->getTestData() != nullptr);
+		if(TD->getTestData())
+			write(TD->getTestData());
+		u8(TD->getTestMockup() != nullptr);
+		if(TD->getTestMockup())
+			write(TD->getTestMockup()->getMockupFixture());
+		u8(TD->getTestSetup() != nullptr);
+		if(TD->getTestSetup())
+			write(TD->getTestSetup()->getTestFixture());
+		TestFunction* F = TD->getTestFunction();
+		write(F->getFunctionCall());
+		u8(F->getExpectedResult() != nullptr);
+		if(ExpectedResult* ER = F->getExpectedResult()) {
+			str(ER->getComparisonOperator()->toString());
+			write(ER->getExpectedConstant());
+		}
+		u8(TD->getTestTeardown() != nullptr);
+		if(TD->getTestTeardown())
+			write(TD->getTestTeardown()->getTestFixture());
+	}
+
+	void write(TestGroup* TG) {
+		str(TG->getGroupName());
+		u8(TG->getGlobalMockup() != nullptr);
+		if(TG->getGlobalMockup())
+			write(TG->getGlobalMockup()->getMockupFixture());
+		u8(TG->getGlobalSetup() != nullptr);
+		if(TG->getGlobalSetup())
+			write(TG->getGlobalSetup()->getTestFixture());
+		const GlobalTeardown* GT = TG->getGlobalTeardown();
+		u8(GT != nullptr);
+		if(GT) {
+			u8(GT->getTestFixture() != nullptr);
+			if(GT->getTestFixture())
+				write(GT->getTestFixture());
+		}
+		u32(TG->getTests().size());
+		for(TestExpr* test : TG->getTests()) {
+			u8(test->getType());
+			if(test->getType() == TestExpr::TEST_GROUP)
+				write(static_cast<TestGroup*>(test));
+			else
+				write(static_cast<const TestDefinition*>(test));
+		}
+	}
+};
+
+/// Rebuilds the tree written by the PlanWriter. Every read checks the end of
+/// the buffer, a truncated or corrupted cache throws a JCUTException.
+class PlanReader {
+private:
+	const char* mPos;
+	const char* mEnd;
+
+	void read(void* data, size_t size) {
+		if(size_t(mEnd - mPos) < size)
+			throw JCUTException("The plan cache is truncated");
+		memcpy(data, mPos, size);
+		mPos += size;
+	}
+	void corrupted() {
+		throw JCUTException("The plan cache is corrupted");
+	}
+public:
+	PlanReader(const char* data, size_t size) : mPos(data), mEnd(data + size) {}
+
+	bool atEnd() const { return mPos == mEnd; }
+
+	uint8_t u8() { uint8_t value; read(&value, 1); return value; }
+	uint32_t u32() { uint32_t value; read(&value, 4); return value; }
+	int32_t i32() { int32_t value; read(&value, 4); return value; }
+	uint64_t u64() { uint64_t value; read(&value, 8); return value; }
+	float f32() { float value; read(&value, 4); return value; }
+	string str() {
+		uint32_t size = u32();
+		if(size_t(mEnd - mPos) < size)
+			corrupted();
+		string s(mPos, size);
+		mPos += size;
+		return s;
+	}
+	/// A count of elements, each one takes at least a byte
+	uint32_t count() {
+		uint32_t n = u32();
+		if(size_t(mEnd - mPos) < n)
+			corrupted();
+		return n;
+	}
+
+	NumericConstant* readNumericConstant() {
+		if(u8())
+			return new NumericConstant(i32());
+		return new NumericConstant(f32());
+	}
+
+	Constant* readConstant() {
+		unique_ptr<Constant> C;
+		switch(u8()) {
+		case Constant::NUMERIC:
+			C.reset(new Constant(readNumericConstant()));
+			break;
+		case Constant::STRING:
+			C.reset(new Constant(new StringConstant(str())));
+			break;
+		case Constant::CHAR:
+			C.reset(new Constant(new CharConstant(u8())));
+			break;
+		default:
+			corrupted();
+		}
+		C->setString(str());
+		return C.release();
+	}
+
+	Operand* readOperand() {
+		if(u8())
+			return new Operand(new Identifier(str()));
+		return new Operand(readConstant());
+	}
+
+	ExpectedConstant* readExpectedConstant() {
+		if(u8())
+			return new ExpectedConstant(unique_ptr<DataPlaceholder>(new DataPlaceholder(str())));
+		return new ExpectedConstant(readConstant());
+	}
+
+	InitializerValue* readInitializerValue() {
+		if(u8())
+			return new InitializerValue(readStructInitializer());
+		return new InitializerValue(readNumericConstant());
+	}
+
+	StructInitializer* readStructInitializer() {
+		uint8_t kind = u8();
+		uint32_t n = count();
+		if(kind == 0) {
+			vector<unique_ptr<InitializerValue>> values;
+			for(uint32_t i = 0; i < n; ++i)
+				values.push_back(unique_ptr<InitializerValue>(readInitializerValue()));
+			vector<InitializerValue*> args;
+			for(unique_ptr<InitializerValue>& IV : values)
+				args.push_back(IV.release());
+			return new StructInitializer(new InitializerList(args));
+		}
+		if(kind != 1)
+			corrupted();
+		vector<pair<unique_ptr<Identifier>,unique_ptr<InitializerValue>>> values;
+		for(uint32_t i = 0; i < n; ++i) {
+			unique_ptr<Identifier> id(new Identifier(str()));
+			values.push_back(make_pair(move(id),
+					unique_ptr<InitializerValue>(readInitializerValue())));
+		}
+		vector<tuple<Identifier*,InitializerValue*>> init;
+		for(auto& value : values)
+			init.push_back(make_tuple(value.first.release(), value.second.release()));
+		return new StructInitializer(new DesignatedInitializer(init));
+	}
+
+	BufferAlloc* readBufferAlloc() {
+		unique_ptr<NumericConstant> size(readNumericConstant());
+		if(u8()) {
+			StructInitializer* init = readStructInitializer();
+			return new BufferAlloc(size.release(), init);
+		}
+		NumericConstant* value = readNumericConstant();
+		return new BufferAlloc(size.release(), value);
+	}
+
+	FunctionArgument* readFunctionArgument() {
+		switch(u8()) {
+		case 0: return new FunctionArgument(readConstant());
+		case 1: return new FunctionArgument(readBufferAlloc());
+		case 2: return new FunctionArgument(unique_ptr<DataPlaceholder>(new DataPlaceholder(str())));
+		}
+		corrupted();
+		return nullptr;
+	}
+
+	FunctionCall* readFunctionCall() {
+		unique_ptr<Identifier> name(new Identifier(str()));
+		uint32_t n = count();
+		vector<unique_ptr<FunctionArgument>> values;
+		for(uint32_t i = 0; i < n; ++i)
+			values.push_back(unique_ptr<FunctionArgument>(readFunctionArgument()));
+		vector<FunctionArgument*> args;
+		for(unique_ptr<FunctionArgument>& FA : values)
+			args.push_back(FA.release());
+		return new FunctionCall(name.release(), args);
+	}
+
+	ExpectedExpression* readExpectedExpression() {
+		unique_ptr<Operand> LHS(readOperand());
+		unique_ptr<ComparisonOperator> CO(new ComparisonOperator(str()));
+		unique_ptr<Operand> RHS(readOperand());
+		int line = i32();
+		int column = i32();
+		return new ExpectedExpression(LHS.release(), CO.release(), RHS.release(),
+				line, column);
+	}
+
+	VariableAssignment* readVariableAssignment() {
+		unique_ptr<Identifier> id(new Identifier(str()));
+		switch(u8()) {
+		case 0: {
+			Constant* C = readConstant();
+			return new VariableAssignment(id.release(), C);
+		}
+		case 1: {
+			StructInitializer* SI = readStructInitializer();
+			return new VariableAssignment(id.release(), SI);
+		}
+		case 2: {
+			BufferAlloc* BA = readBufferAlloc();
+			return new VariableAssignment(id.release(), BA);
+		}
+		}
+		corrupted();
+		return nullptr;
+	}
+
+	MockupFunction* readMockupFunction() {
+		unique_ptr<FunctionCall> FC(readFunctionCall());
+		switch(u8()) {
+		case 0: {
+			Constant* C = readConstant();
+			return new MockupFunction(FC.release(), C);
+		}
+		case 1: {
+			Identifier* id = new Identifier(str());
+			return new MockupFunction(FC.release(), id);
+		}
+		case 2: {
+			uint32_t n = count();
+			vector<unique_ptr<Constant>> values;
+			for(uint32_t i = 0; i < n; ++i)
+				values.push_back(unique_ptr<Constant>(readConstant()));
+			vector<Constant*> seq;
+			for(unique_ptr<Constant>& C : values)
+				seq.push_back(C.release());
+			return new MockupFunction(FC.release(), new MockupSequence(seq));
+		}
+		case 3: {
+			unique_ptr<DataPlaceholder> dp(new DataPlaceholder(str()));
+			return new MockupFunction(FC.release(), move(dp));
+		}
+		}
+		corrupted();
+		return nullptr;
+	}
+
+	MockupFixture* readMockupFixture() {
+		uint32_t n = count();
+		vector<unique_ptr<MockupFunction>> functions;
+		for(uint32_t i = 0; i < n; ++i)
+			functions.push_back(unique_ptr<MockupFunction>(readMockupFunction()));
+		n = count();
+		vector<unique_ptr<VariableAssignment>> variables;
+		for(uint32_t i = 0; i < n; ++i)
+			variables.push_back(unique_ptr<VariableAssignment>(readVariableAssignment()));
+		vector<MockupFunction*> func;
+		for(unique_ptr<MockupFunction>& MF : functions)
+			func.push_back(MF.release());
+		vector<MockupVariable*> var;
+		for(unique_ptr<VariableAssignment>& VA : variables)
+			var.push_back(new MockupVariable(VA.release()));
+		return new MockupFixture(func, var);
+	}
+
+	TestFixture* readTestFixture() {
+		uint32_t n = count();
+		vector<unique_ptr<TestExpr>> values;
+		for(uint32_t i = 0; i < n; ++i) {
+			switch(u8()) {
+			case TestExpr::FUNC_CALL:
+				values.push_back(unique_ptr<TestExpr>(readFunctionCall()));
+				break;
+			case TestExpr::VAR_ASSIGN:
+				values.push_back(unique_ptr<TestExpr>(readVariableAssignment()));
+				break;
+			case TestExpr::EXPECT_EXPR:
+				values.push_back(unique_ptr<TestExpr>(readExpectedExpression()));
+				break;
+			default:
+				corrupted();
+			}
+		}
+		vector<TestExpr*> stmt;
+		for(unique_ptr<TestExpr>& t : values)
+			stmt.push_back(t.release());
+		return new TestFixture(stmt);
+	}
+
+	TestData* readTestData() {
+		if(u8() == 0) {
+			// The parser keeps the double quotes of the path
+			unique_ptr<StringConstant> path(new StringConstant("\"" + str() + "\""));
+			return new TestData(move(path));
+		}
+		uint32_t n = count();
+		vector<unique_ptr<DataGenerator>> values;
+		for(uint32_t i = 0; i < n; ++i) {
+			uint8_t kind = u8();
+			if(kind != DataGenerator::RANGE && kind != DataGenerator::RANDOM)
+				corrupted();
+			uint32_t arg_count = count();
+			vector<string> args;
+			for(uint32_t j = 0; j < arg_count; ++j)
+				args.push_back(str());
+			values.push_back(unique_ptr<DataGenerator>(
+					new DataGenerator(static_cast<DataGenerator::Kind>(kind), args)));
+		}
+		vector<DataGenerator*> generators;
+		for(unique_ptr<DataGenerator>& G : values)
+			generators.push_back(G.release());
+		return new TestData(generators);
+	}
+
+	TestDefinition* readTestDefinition() {
+		int line = i32();
+		int column = i32();
+		bool property = u8();
+		unique_ptr<TestData> data(u8() ? readTestData() : nullptr);
+		unique_ptr<TestMockup> mockup(u8() ? new TestMockup(readMockupFixture()) : nullptr);
+		unique_ptr<TestSetup> setup(u8() ? new TestSetup(readTestFixture()) : nullptr);
+		unique_ptr<FunctionCall> FC(readFunctionCall());
+		unique_ptr<ExpectedResult> ER(nullptr);
+		if(u8()) {
+			unique_ptr<ComparisonOperator> CO(new ComparisonOperator(str()));
+			ExpectedConstant* EC = readExpectedConstant();
+			ER.reset(new ExpectedResult(CO.release(), EC));
+		}
+		unique_ptr<TestFunction> function(new TestFunction(FC.release(), ER.release()));
+		unique_ptr<TestTeardown> teardown(u8() ? new TestTeardown(readTestFixture()) : nullptr);
+		TestDefinition* TD = new TestDefinition(data.release(), function.release(),
+				setup.release(), teardown.release(), mockup.release());
+		TD->setProperty(property);
+		TD->setLine(line);
+		TD->setColumn(column);
+		return TD;
+	}
+
+	TestGroup* readTestGroup() {
+		unique_ptr<Identifier> name(new Identifier(str()));
+		unique_ptr<GlobalMockup> gm(u8() ? new GlobalMockup(readMockupFixture()) : nullptr);
+		unique_ptr<GlobalSetup> gs(u8() ? new GlobalSetup(readTestFixture()) : nullptr);
+		unique_ptr<GlobalTeardown> gt(nullptr);
+		if(u8())
+			gt.reset(new GlobalTeardown(u8() ? readTestFixture() : nullptr));
+		uint32_t n = count();
+		vector<unique_ptr<TestExpr>> values;
+		for(uint32_t i = 0; i < n; ++i) {
+			switch(u8()) {
+			case TestExpr::TEST_GROUP:
+				values.push_back(unique_ptr<TestExpr>(readTestGroup()));
+				break;
+			case TestExpr::TEST_DEFINITION:
+				values.push_back(unique_ptr<TestExpr>(readTestDefinition()));
+				break;
+			default:
+				corrupted();
+			}
+		}
+		vector<TestExpr*> tests;
+		for(unique_ptr<TestExpr>& t : values)
+			tests.push_back(t.release());
+		return new TestGroup(name.release(), tests, gm.release(), gs.release(),
+				gt.release());
+	}
+};
+
+} // anonymous namespace
+
+namespace tp {
+
+uint64_t PlanCache::hashFile(const string& path)
+{
+	MappedFile file(path);
+	if(file.data() == nullptr)
+		return 0;
+	return fnv1a(file.data(), file.size());
+}
+
+string PlanCache::getCachePath(uint64_t hash) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.jcp", static_cast<unsigned long long>(hash));
+	return mDir + "/" + name;
+}
+
+TestExpr* PlanCache::load(const string& test_file) const
+{
+	uint64_t hash = hashFile(test_file);
+	if(hash == 0)
+		return nullptr;
+	MappedFile cache(getCachePath(hash));
+	if(cache.data() == nullptr || cache.size() < sizeof(Magic) ||
+	   memcmp(cache.data(), Magic, sizeof(Magic)) != 0)
+		return nullptr;
+	try {
+		PlanReader reader(cache.data() + sizeof(Magic), cache.size() - sizeof(Magic));
+		if(reader.u32() != FormatVersion)
+			return nullptr;
+		if(reader.u64() != hash)
+			return nullptr;
+		uint32_t data_files = reader.count();
+		for(uint32_t i = 0; i < data_files; ++i) {
+			string path = reader.str();
+			if(reader.u64() != hashFile(path))
+				return nullptr; // The data file changed
+		}
+		unique_ptr<TestGroup> group(reader.readTestGroup());
+		if(reader.atEnd() == false)
+			return nullptr;
+		return new TestFile(group.release());
+	} catch(const JCUTException&) {
+		return nullptr; // Parse the test file again
+	}
+}
+
+void PlanCache::save(const string& test_file, TestExpr* tests) const
+{
+	uint64_t hash = hashFile(test_file);
+	if(hash == 0)
+		return;
+	DataFileVisitor data_files;
+	tests->accept(&data_files);
+
+	PlanWriter writer;
+	writer.u32(FormatVersion);
+	writer.u64(hash);
+	writer.u32(data_files.getFiles().size());
+	for(const string& path : data_files.getFiles()) {
+		writer.str(path);
+		writer.u64(hashFile(path));
+	}
+	writer.write(static_cast<TestFile*>(tests)->getTestGroup());
+
+	mkdir(mDir.c_str(), 0777);
+	string path = getCachePath(hash);
+	// The cache is never seen half written, even by another jcut running
+	// at the same time.
+	stringstream tmp;
+	tmp << path << "." << getpid() << ".tmp";
+	FILE* out = fopen(tmp.str().c_str(), "wb");
+	if(out == nullptr)
+		return;
+	const string& buffer = writer.getBuffer();
+	bool written = fwrite(Magic, 1, sizeof(Magic), out) == sizeof(Magic) &&
+			fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+	if(fclose(out) != 0 || !written || rename(tmp.str().c_str(), path.c_str()) != 0)
+		unlink(tmp.str().c_str());
+}
+
+string PlanCache::serialize(TestExpr* tests)
+{
+	PlanWriter writer;
+	writer.write(static_cast<TestFile*>(tests)->getTestGroup());
+	return writer.getBuffer();
+}
+
+TestExpr* PlanCache::deserialize(const string& data)
+{
+	PlanReader reader(data.data(), data.size());
+	unique_ptr<TestGroup> group(reader.readTestGroup());
+	if(reader.atEnd() == false)
+		throw JCUTException("The plan received has extra data");
+	return new TestFile(group.release());
+}
+
+} // namespace tp
@@ -0,0 +1,89 @@
+//===-- jcut/PlanCache.h - Cache of the parsed test files -------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Binary cache of the tree of a test file (--plan-cache).
+///
+/// The tree is saved once the tests have been copied for every row of their
+/// CSV files, so a run that finds it in the cache neither tokenizes the test
+/// file nor reads the CSV files. The cache file is named after the FNV-1a
+/// hash of the contents of the test file:
+///
+///   <dir>/<hash>.jcp
+///
+/// All the values are little endian:
+///
+///   char[4]   magic "JCP1"
+///   uint32    version of the format, a cache of another version is ignored
+///   uint64    hash of the test file
+///   uint32    number of data files
+///             for each one: string path, uint64 hash of its contents
+///   the nodes of the tree in pre-order
+///
+/// A string is its uint32 length followed by its characters. The cache is
+/// out of date when the hash of any of the data files changed.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef PLANCACHE_H_
+#define PLANCACHE_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+namespace tp {
+
+class TestExpr;
+
+class PlanCache {
+private:
+	string mDir;
+
+	string getCachePath(uint64_t hash) const;
+public:
+	explicit PlanCache(const string& dir) : mDir(dir) {}
+
+	/// The tree of test_file, nullptr when it is not in the cache or the
+	/// cache is out of date.
+	TestExpr* load(const string& test_file) const;
+	/// Saves the tree of test_file, the TestFile returned by the parser. A
+	/// cache that can not be written is not an error, the tests still run.
+	void save(const string& test_file, TestExpr* tests) const;
+
+	/// The tree of a test file in memory, in the format of the cache, to send
+	/// it to a jcut --worker. The data files are not included.
+	static string serialize(TestExpr* tests);
+	/// The TestFile of serialize(), throws a JCUTException when data is not
+	/// a valid tree.
+	static TestExpr* deserialize(const string& data);
+
+	/// FNV-1a hash of the contents of a file, 0 when it can not be read
+	static uint64_t hashFile(const string& path);
+};
+
+} // namespace tp
+
+#endif /* PLANCACHE_H_ */
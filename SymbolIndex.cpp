@@ -0,0 +1,138 @@
+//===-- jcut/SymbolIndex.cpp - Symbols of the loaded files ------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "SymbolIndex.h"
+
+#include <cctype>
+#include <set>
+#include <sys/stat.h>
+
+#include "PlanCache.h"
+
+namespace jcut {
+
+unique_ptr<SymbolIndex> SymbolIndex::index(nullptr);
+
+SymbolIndex& SymbolIndex::instance()
+{
+	if(!index)
+		index = unique_ptr<SymbolIndex>(new SymbolIndex());
+	return *index;
+}
+
+void SymbolIndex::beginFile(const string& file)
+{
+	FileSymbols& symbols = mFiles[file];
+	symbols.mSymbols.clear();
+	struct stat st;
+	symbols.mModified = (stat(file.c_str(), &st) == 0) ? st.st_mtime : 0;
+	symbols.mHash = tp::PlanCache::hashFile(file);
+}
+
+void SymbolIndex::addSymbol(const string& file, const Symbol& symbol)
+{
+	mFiles[file].mSymbols.push_back(symbol);
+}
+
+void SymbolIndex::removeFile(const string& file)
+{
+	mFiles.erase(file);
+}
+
+vector<string> SymbolIndex::getOutdatedFiles(const vector<string>& files)
+{
+	vector<string> outdated;
+	for(const string& file : files) {
+		auto it = mFiles.find(file);
+		if(it == mFiles.end()) {
+			outdated.push_back(file);
+			continue;
+		}
+		struct stat st;
+		time_t modified = (stat(file.c_str(), &st) == 0) ? st.st_mtime : 0;
+		if(modified == it->second.mModified)
+			continue;
+		// Touched but not changed, only the time is updated
+		if(tp::PlanCache::hashFile(file) == it->second.mHash)
+			it->second.mModified = modified;
+		else
+			outdated.push_back(file);
+	}
+	return outdated;
+}
+
+void SymbolIndex::printFunctions(const vector<string>& files, ostream& out) const
+{
+	for(const string& file : files) {
+		out << file << ":" << endl;
+		auto it = mFiles.find(file);
+		if(it != mFiles.end())
+			for(const Symbol& symbol : it->second.mSymbols)
+				if(symbol.mKind == Symbol::FUNCTION)
+					out << "\t" << symbol.mDeclaration << endl;
+		out << endl;
+	}
+}
+
+vector<string> SymbolIndex::complete(const string& line) const
+{
+	vector<string> completions;
+	// A function followed by ( gets the names of its parameters
+	if(line.size() && line[line.size()-1] == '(') {
+		string::size_type begin = line.size() - 1;
+		while(begin > 0 && (isalnum(line[begin-1]) || line[begin-1] == '_'))
+			--begin;
+		string name = line.substr(begin, line.size() - 1 - begin);
+		for(auto& file : mFiles)
+			for(const Symbol& symbol : file.second.mSymbols)
+				if(symbol.mKind == Symbol::FUNCTION && symbol.mName == name) {
+					completions.push_back(line + symbol.mParameters + ")");
+					return completions;
+				}
+		return completions;
+	}
+
+	string::size_type begin = line.size();
+	while(begin > 0 && (isalnum(line[begin-1]) || line[begin-1] == '_'))
+		--begin;
+	string word = line.substr(begin);
+	if(word.empty())
+		return completions;
+	// The same name may be declared in many files
+	set<string> names;
+	for(auto& file : mFiles)
+		for(const Symbol& symbol : file.second.mSymbols)
+			if(symbol.mName.compare(0, word.size(), word) == 0)
+				names.insert(symbol.mKind == Symbol::FUNCTION ?
+						symbol.mName + "(" : symbol.mName);
+	for(const string& name : names)
+		completions.push_back(line.substr(0, begin) + name);
+	return completions;
+}
+
+} /* namespace jcut */
@@ -0,0 +1,103 @@
+//===-- jcut/SymbolIndex.h - Symbols of the loaded files --------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Functions, global variables and types of the loaded C files.
+///
+/// The interpreter indexes a C file when it is loaded. /ls prints the
+/// functions from the index and the tab completion offers the names it
+/// holds, neither of them parses the C files again. A file is indexed again
+/// when its modification time and its contents changed.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SYMBOLINDEX_H_
+#define SYMBOLINDEX_H_
+
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace jcut {
+
+struct Symbol {
+	enum Kind { FUNCTION, GLOBAL, TYPE };
+	Kind mKind;
+	string mName;
+	// As declared in C, i.e. int sum(int a, int b);
+	string mDeclaration;
+	// The names of the parameters of a function, i.e. a, b
+	string mParameters;
+
+	Symbol(Kind kind, const string& name, const string& declaration,
+			const string& parameters = "") : mKind(kind), mName(name),
+			mDeclaration(declaration), mParameters(parameters) {}
+};
+
+class SymbolIndex {
+private:
+	struct FileSymbols {
+		time_t mModified;
+		uint64_t mHash;
+		vector<Symbol> mSymbols;
+
+		FileSymbols() : mModified(0), mHash(0), mSymbols() {}
+	};
+	map<string, FileSymbols> mFiles;
+	static unique_ptr<SymbolIndex> index;
+
+	SymbolIndex() : mFiles() {}
+public:
+	SymbolIndex(const SymbolIndex&) = delete;
+	SymbolIndex& operator=(const SymbolIndex&) = delete;
+
+	/// The index of the interpreter, the completion callback of linenoise
+	/// has no other way to get to it.
+	static SymbolIndex& instance();
+
+	/// Starts indexing file again, its symbols are forgotten
+	void beginFile(const string& file);
+	void addSymbol(const string& file, const Symbol& symbol);
+	/// Forgets the symbols of a file unloaded
+	void removeFile(const string& file);
+
+	/// The files not indexed yet, or changed since they were indexed
+	vector<string> getOutdatedFiles(const vector<string>& files);
+
+	/// Prints the functions of the files, as /ls does
+	void printFunctions(const vector<string>& files, ostream& out) const;
+	/// The lines completing the last word of line with the names of the
+	/// index. A function name followed by ( is completed with the names of
+	/// its parameters.
+	vector<string> complete(const string& line) const;
+};
+
+} /* namespace jcut */
+
+#endif /* SYMBOLINDEX_H_ */
@@ -0,0 +1,58 @@
+//===-- jcut/TestArena.cpp - Memory of the test tree ------------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "TestArena.h"
+
+namespace tp {
+
+thread_local TestArena* TestArena::sCurrent = nullptr;
+
+TestArena::~TestArena()
+{
+	for(char* block : mBlocks)
+		delete [] block;
+}
+
+void* TestArena::allocate(size_t size)
+{
+	size = (size + Alignment - 1) & ~(Alignment - 1);
+	if(mPos == nullptr || size_t(mEnd - mPos) < size) {
+		// Big nodes do not exist, but just in case get a block of their size
+		size_t block_size = size > BlockSize ? size : BlockSize;
+		// new [] of char returns memory aligned for any fundamental type
+		mBlocks.push_back(new char[block_size]);
+		mPos = mBlocks.back();
+		mEnd = mPos + block_size;
+	}
+	void* ptr = mPos;
+	mPos += size;
+	mAllocated += size;
+	return ptr;
+}
+
+} // namespace tp
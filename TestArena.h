@@ -0,0 +1,93 @@
+//===-- jcut/TestArena.h - Memory of the test tree --------------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Bump allocator for the nodes of the tree of a test file.
+///
+/// TestExpr overloads operator new: while a TestArena::Scope is alive every
+/// node is carved from the blocks of its arena, one pointer bump each. The
+/// operator delete of a node allocated this way does nothing, the blocks are
+/// given back all at once when the arena is destroyed. Nodes created when no
+/// arena is in use come from the heap as before.
+///
+/// An arena is not thread safe, every thread uses its own Scope.
+///
+/// The destructors of the nodes still run, they release the strings and
+/// vectors the nodes own, so the arena has to outlive the tree.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TESTARENA_H_
+#define TESTARENA_H_
+
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+namespace tp {
+
+class TestArena {
+private:
+	vector<char*> mBlocks;
+	char* mPos;
+	char* mEnd;
+	size_t mAllocated;
+
+	// Each thread parsing a test file uses its own arena
+	static thread_local TestArena* sCurrent;
+	static const size_t BlockSize = 64*1024;
+public:
+	/// Every allocation is aligned to this
+	static const size_t Alignment = 16;
+
+	/// Makes an arena the one used by the new TestExpr nodes until the scope
+	/// ends, then the previous one (if any) is used again.
+	class Scope {
+	private:
+		TestArena* mPrevious;
+	public:
+		explicit Scope(TestArena& arena) : mPrevious(sCurrent) { sCurrent = &arena; }
+		~Scope() { sCurrent = mPrevious; }
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	TestArena() : mBlocks(), mPos(nullptr), mEnd(nullptr), mAllocated(0) {}
+	TestArena(const TestArena&) = delete;
+	TestArena& operator=(const TestArena&) = delete;
+	~TestArena();
+
+	void* allocate(size_t size);
+
+	/// Bytes handed out so far
+	size_t getAllocated() const { return mAllocated; }
+	size_t getBlockCount() const { return mBlocks.size(); }
+
+	/// The arena of the innermost Scope, nullptr when there is none
+	static TestArena* getCurrent() { return sCurrent; }
+};
+
+} // namespace tp
+
+#endif /* TESTARENA_H_ */
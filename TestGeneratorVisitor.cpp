@@ -30,6 +30,7 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/DataLayout.h"
 #include "TestParser.h"
 #include "JCUTScanner.h"
 
@@ -43,7 +44,15 @@ mCurrentBB(nullptr),
 mReturnValue(nullptr),
 mFUDReturnValue(nullptr),
 mWarnings(),
-mTestResult(nullptr)
+mTestResult(nullptr),
+mDataTable(nullptr),
+mDataRow(nullptr),
+mDataColumn(0),
+mDataCall(nullptr),
+mInDataCall(false),
+mBench(false),
+mSaveGlobals(nullptr),
+mRestoreGlobals(nullptr)
 {
 }
 
@@ -52,6 +61,15 @@ mTestResult(nullptr)
  */
 void TestGeneratorVisitor::VisitFunctionArgument(tp::FunctionArgument *arg)
 {
+	if(arg->isDataPlaceholder() && mInDataCall) {
+		llvm::Function *currentFunction = mModule->getFunction(mCurrentFuncCall);
+		llvm::Function::arg_iterator arg_it = currentFunction->arg_begin();
+		for(unsigned i = 0; i < arg->getIndex(); ++i)
+			++arg_it;
+		mArgs.push_back(loadDataColumn(arg_it->getType()));
+		return;
+	}
+
 	if(arg->isDataPlaceholder()) {
 		string file = __FILE__;
 		unsigned pos = file.find_last_of('/') + 1;
@@ -188,6 +206,7 @@ void TestGeneratorVisitor::VisitFunctionArgument(tp::FunctionArgument *arg)
 
 void TestGeneratorVisitor::VisitFunctionCallFirst(FunctionCall *FC) {
 	mCurrentFuncCall = FC->getIdentifier()->toString();
+	mInDataCall = (mDataCall == FC);
 	Function *funcToBeCalled = nullptr;
 
 	auto it = mFunctionsWrapped.find(mCurrentFuncCall);
@@ -230,6 +249,7 @@ void TestGeneratorVisitor::VisitFunctionCall(FunctionCall *FC)
 	mInstructions.push_back(call);
 	mArgs.clear();
 	mCurrentFuncCall.clear();
+	mInDataCall = false;
 }
 
 void TestGeneratorVisitor::VisitExpectedResult(ExpectedResult *ER)
@@ -250,28 +270,33 @@ void TestGeneratorVisitor::VisitExpectedResult(ExpectedResult *ER)
 
 	stringstream ss;
 	const ExpectedConstant* EC = ER->getExpectedConstant();
-	assert(EC->isDataPlaceholder() == false && "Cannot generate ExpectedResult code from a DataPlaceholder.");
+	llvm::Value* c = nullptr;
+	if(EC->isDataPlaceholder() && mDataTable)
+		c = loadDataColumn(returnedType);
+	else {
+		assert(EC->isDataPlaceholder() == false && "Cannot generate ExpectedResult code from a DataPlaceholder.");
+
+		const tp::Constant* C = EC->getConstant();
+		if(C->isCharConstant()) {
+			ss << static_cast<int>(C->getCharConstant()->getChar());
+		}
 
-	const tp::Constant* C = EC->getConstant();
-	if(C->isCharConstant()) {
-		ss << static_cast<int>(C->getCharConstant()->getChar());
-	}
+		if(C->isNumericConstant()) {
+			ss << EC->getConstant()->toString();
+			assert(ss.str().size() && "Invalid numeric string!");
+		}
 
-	if(C->isNumericConstant()) {
-		ss << EC->getConstant()->toString();
-		assert(ss.str().size() && "Invalid numeric string!");
-	}
+		if(C->isStringConstant()) {
+			const string& str = EC->getConstant()->getStringConstant()->getString();
+			stringstream tmp;
+			tmp << static_cast<const void*>(str.c_str());
+			ss << tmp.str();
+			assert(ss.str().size() && "Invalid string constant!");
+		}
 
-	if(C->isStringConstant()) {
-		const string& str = EC->getConstant()->getStringConstant()->getString();
-		stringstream tmp;
-		tmp << static_cast<const void*>(str.c_str());
-		ss << tmp.str();
-		assert(ss.str().size() && "Invalid string constant!");
+		c = createValue(returnedType, ss.str());
 	}
 
-	llvm::Value* c = createValue(returnedType, ss.str());
-
 	string InstName = "ComparisonInstruction";
     Value* i = nullptr;
     auto comparison_type = ER->getComparisonOperator()->getType();
@@ -378,6 +403,7 @@ void TestGeneratorVisitor::VisitExpectedExpression(ExpectedExpression *EE)
 	MB->getInstList().push_back(load);
 	MB->getInstList().push_back(ret);
 	EE->setLLVMResultFunction(result_func);
+	mPendingEE.push_back(EE);
 }
 
 void TestGeneratorVisitor::VisitMockupFunction(MockupFunction* MF)
@@ -393,6 +419,9 @@ void TestGeneratorVisitor::VisitMockupFunction(MockupFunction* MF)
 		mockup_name = mockup_name.substr(0, mockup_name.find_last_of('_')) + ss.str();
 	}
 	mMockupNames[mockup_name] = true;
+	if(MF->isDataPlaceholder())
+		throw JCUTException("The mockup function "+func_name+"() = @; needs a CSV file.\n"
+				"\tDataPlaceholders are only valid in a test mockup {} with a data {} statement");
 	llvm::Function *llvm_func = mModule->getFunction(func_name);
 	if( llvm_func == nullptr) {
 		cout << "Function NOT found...creating declaration and definition" << endl;
@@ -413,57 +442,66 @@ void TestGeneratorVisitor::VisitMockupFunction(MockupFunction* MF)
 			params.push_back(arg.getType());
 		FunctionType* FT = FunctionType::get(llvm_func->getReturnType(),ArrayRef<Type*>(params),false);
 		Function* mockup_function = cast<Function>(mModule->getOrInsertFunction(mockup_name, FT, llvm_func->getAttributes()));
-		BasicBlock* MB = BasicBlock::Create(mModule->getContext(),"mockup_block",mockup_function);
-		// The expected value has to match the return value type from the llvm_func
-		ReturnInst* ret = nullptr;
-		if(llvm_func->getReturnType() == mBuilder.getVoidTy()) {
-			ret = mBuilder.CreateRetVoid();
+		// Index of the next value to be returned by a mockup sequence
+		GlobalVariable* g_ndx = nullptr;
+		if(MF->isSequence()) {
+			if(llvm_func->getReturnType() == mBuilder.getVoidTy())
+				throw JCUTException("The function "+func_name+"() has void as return value.\n"
+						"\tIt can not return a sequence of values.");
+			g_ndx = createMockupSequence(mockup_function, MF->getSequence(), mockup_name);
 		} else {
-			llvm::Value* val = nullptr;
-			if(llvm_func->getReturnType()->getTypeID() == Type::PointerTyID) {
-				// Cast it to pointer type
-				string str =  expected->toString();
-				if(str.find('.') != string::npos)
-					throw JCUTException("Floating point values are not valid for returning as pointer type!");
-				unsigned bitwidth = llvm_func->getReturnType()->getPointerElementType()->getIntegerBitWidth();
-				int radix = 10;
-				size_t pos = str.find('x');
-				if(pos != string::npos) {
-					radix = 16;
-					str = str.substr(pos+1,str.size()-pos+1);
-				} else if(str[0] == '0'){
-					radix = 8;
-				}
-				APInt int_value =  getAPIntTruncating(bitwidth, str, radix);
-				ConstantInt* int_constant = ConstantInt::get
-						(mModule->getContext(), int_value);
-				AllocaInst* ptr_val = mBuilder.CreateAlloca(llvm_func->getReturnType()->getPointerElementType());
-				AllocaInst* ptr = mBuilder.CreateAlloca(llvm_func->getReturnType());
-
-				StoreInst* stor = mBuilder.CreateStore(int_constant, ptr_val);
-				LoadInst* load = mBuilder.CreateLoad(ptr_val, false);
-				SExtInst* sext = cast<SExtInst>(mBuilder.CreateSExt(load, mBuilder.getInt64Ty()));
-				CastInst* int_to_ptr =
-						cast<CastInst>(
-						mBuilder.CreateIntToPtr
-								(load, llvm_func->getReturnType()));
-				StoreInst* fin = mBuilder.CreateStore(int_to_ptr, ptr);
-				LoadInst* load_1 = mBuilder.CreateLoad(ptr);
-				MB->getInstList().push_back(ptr_val);
-				MB->getInstList().push_back(ptr);
-				MB->getInstList().push_back(stor);
-				MB->getInstList().push_back(load);
-				MB->getInstList().push_back(sext);
-				MB->getInstList().push_back(int_to_ptr);
-				MB->getInstList().push_back(fin);
-				MB->getInstList().push_back(load_1);
-				ret = mBuilder.CreateRet(load_1);
+			BasicBlock* MB = BasicBlock::Create(mModule->getContext(),"mockup_block",mockup_function);
+			// The expected value has to match the return value type from the llvm_func
+			ReturnInst* ret = nullptr;
+			if(llvm_func->getReturnType() == mBuilder.getVoidTy()) {
+				ret = mBuilder.CreateRetVoid();
 			} else {
-				val = createValue(llvm_func->getReturnType(), expected->toString());
-				ret = mBuilder.CreateRet(val);
+				llvm::Value* val = nullptr;
+				if(llvm_func->getReturnType()->getTypeID() == Type::PointerTyID) {
+					// Cast it to pointer type
+					string str =  expected->toString();
+					if(str.find('.') != string::npos)
+						throw JCUTException("Floating point values are not valid for returning as pointer type!");
+					unsigned bitwidth = llvm_func->getReturnType()->getPointerElementType()->getIntegerBitWidth();
+					int radix = 10;
+					size_t pos = str.find('x');
+					if(pos != string::npos) {
+						radix = 16;
+						str = str.substr(pos+1,str.size()-pos+1);
+					} else if(str[0] == '0'){
+						radix = 8;
+					}
+					APInt int_value =  getAPIntTruncating(bitwidth, str, radix);
+					ConstantInt* int_constant = ConstantInt::get
+							(mModule->getContext(), int_value);
+					AllocaInst* ptr_val = mBuilder.CreateAlloca(llvm_func->getReturnType()->getPointerElementType());
+					AllocaInst* ptr = mBuilder.CreateAlloca(llvm_func->getReturnType());
+
+					StoreInst* stor = mBuilder.CreateStore(int_constant, ptr_val);
+					LoadInst* load = mBuilder.CreateLoad(ptr_val, false);
+					SExtInst* sext = cast<SExtInst>(mBuilder.CreateSExt(load, mBuilder.getInt64Ty()));
+					CastInst* int_to_ptr =
+							cast<CastInst>(
+							mBuilder.CreateIntToPtr
+									(load, llvm_func->getReturnType()));
+					StoreInst* fin = mBuilder.CreateStore(int_to_ptr, ptr);
+					LoadInst* load_1 = mBuilder.CreateLoad(ptr);
+					MB->getInstList().push_back(ptr_val);
+					MB->getInstList().push_back(ptr);
+					MB->getInstList().push_back(stor);
+					MB->getInstList().push_back(load);
+					MB->getInstList().push_back(sext);
+					MB->getInstList().push_back(int_to_ptr);
+					MB->getInstList().push_back(fin);
+					MB->getInstList().push_back(load_1);
+					ret = mBuilder.CreateRet(load_1);
+				} else {
+					val = createValue(llvm_func->getReturnType(), expected->toString());
+					ret = mBuilder.CreateRet(val);
+				}
 			}
+			MB->getInstList().push_back(ret);
 		}
-		MB->getInstList().push_back(ret);
 		///////////////////////////////////////////////////////
 
 		const string& fp_name = "gvar_fp_"+func_name;
@@ -540,6 +578,10 @@ void TestGeneratorVisitor::VisitMockupFunction(MockupFunction* MF)
 		BasicBlock* B_2 = BasicBlock::Create
 				(mModule->getContext(),"change_to_"+mockup_name+"_block",
 														change_to_mockup);
+		// Every test starts returning the first value of a sequence
+		if(g_ndx)
+			B_2->getInstList().push_back(
+					mBuilder.CreateStore(mBuilder.getInt32(0), g_ndx));
 		StoreInst* store_2 =
 				mBuilder.CreateStore(mockup_function, g_fp);
 		ReturnInst* return_2 = mBuilder.CreateRetVoid();
@@ -568,6 +610,13 @@ void TestGeneratorVisitor::VisitMockupFunction(MockupFunction* MF)
 	}
 }
 
+void TestGeneratorVisitor::VisitGroupMockup(GlobalMockup *GM)
+{
+	mGroupMockups.push_back(nullptr);
+	for(MockupFunction* m : GM->getMockupFixture()->getMockupFunctions())
+		mGroupMockups.push_back(m->getMockupFunction());
+}
+
 /**
  * Creates LLVM IR code for a single global variable assignment.
  *
@@ -639,6 +688,17 @@ void TestGeneratorVisitor::VisitVariableAssignment(VariableAssignment *VA)
 void TestGeneratorVisitor::VisitTestDefinitionFirst(TestDefinition *TD)
 {
     mCurrentFud = TD->getTestFunction()->getFunctionCall()->getIdentifier()->toString();
+    mDataTable = TD->getDataTable();
+    if(mDataTable) {
+        mDataRow = new GlobalVariable(*mModule,
+                        mBuilder.getInt64Ty(),
+                        false,
+                        GlobalValue::LinkageTypes::ExternalLinkage,
+                        mBuilder.getInt64(0),
+                        "data_row_"+mCurrentFud);
+        mDataColumn = 0;
+        mDataCall = TD->getTestFunction()->getFunctionCall();
+    }
 }
 
 void TestGeneratorVisitor::VisitTestSetup(TestSetup *TS)
@@ -702,6 +762,14 @@ void TestGeneratorVisitor::VisitTestDefinition(TestDefinition *TD)
     string func_name = "test_"+TD->getTestFunction()->getFunctionCall()->getIdentifier()->toString();
     Function *testFunction = generateFunction(func_name, true, mInstructions);
 	TD->setLLVMFunction(testFunction);
+	TD->setExpectedExpressions(mPendingEE);
+	mPendingEE.clear();
+	TD->setDriverFunction(createTestDriver(TD));
+	if(mBench && TD->getDataTable() == nullptr)
+		TD->setBenchFunction(createBenchFunction(TD));
+	mDataTable = nullptr;
+	mDataRow = nullptr;
+	mDataCall = nullptr;
     // The warnings may include test-setup, test-function, or test-teardown
     TD->setWarnings(mWarnings);
 
@@ -738,6 +806,12 @@ void TestGeneratorVisitor::VisitGroupTeardown(GlobalTeardown *GT)
 
 void TestGeneratorVisitor::VisitTestGroup(TestGroup *TG)
 {
+    if(TG->getGlobalMockup()) {
+        while(mGroupMockups.back() != nullptr)
+            mGroupMockups.pop_back();
+        mGroupMockups.pop_back(); // the nullptr marker
+    }
+
     if(mBackupGroup.size()) {
         string func_name = "group_cleanup_"+TG->getGroupName();
         restoreGlobalVariables(mBackupGroup);
@@ -1100,6 +1174,573 @@ llvm::AllocaInst* TestGeneratorVisitor::bufferAllocInitialization(llvm::Type* pt
 	return alloc1; //alloc1 is a pointer type to type.
 }
 
+llvm::GlobalVariable* TestGeneratorVisitor::createMockupSequence(
+		llvm::Function* mockup, const MockupSequence* seq, const string& mockup_name)
+{
+	Type* RetTy = mockup->getReturnType();
+	const vector<tp::Constant*>& values = seq->getValues();
+	assert(values.size() && "Empty mockup sequence");
+	vector<llvm::Constant*> constants;
+	for(const tp::Constant* C : values) {
+		string value = C->toString();
+		if(C->isCharConstant()) {
+			stringstream ss;
+			ss << (int) C->getCharConstant()->getChar();
+			value = ss.str();
+		}
+		llvm::Constant* c = nullptr;
+		if(RetTy->isPointerTy()) {
+			if(value.find('.') != string::npos)
+				throw JCUTException("Floating point values are not valid for returning as pointer type!");
+			c = ConstantExpr::getIntToPtr(
+					cast<llvm::Constant>(createValue(mBuilder.getInt64Ty(), value)), RetTy);
+		} else if(RetTy->isIntegerTy() || RetTy->isFloatingPointTy()) {
+			c = cast<llvm::Constant>(createValue(RetTy, value));
+		} else
+			throw JCUTException("Mockup sequences are only supported for integer, "
+					"floating point and pointer return types");
+		constants.push_back(c);
+	}
+
+	ArrayType* AT = ArrayType::get(RetTy, constants.size());
+	GlobalVariable* g_values = new GlobalVariable(/*Module=*/*mModule,
+								 /*Type=*/AT,
+								 /*isConstant=*/true,
+								 /*Linkage=*/GlobalValue::PrivateLinkage,
+								 /*Initializer=*/ConstantArray::get(AT, constants),
+								 /*Name=*/mockup_name+"_values");
+	GlobalVariable* g_ndx = new GlobalVariable(/*Module=*/*mModule,
+								 /*Type=*/mBuilder.getInt32Ty(),
+								 /*isConstant=*/false,
+								 /*Linkage=*/GlobalValue::PrivateLinkage,
+								 /*Initializer=*/mBuilder.getInt32(0),
+								 /*Name=*/mockup_name+"_ndx");
+
+	BasicBlock* MB = BasicBlock::Create(mModule->getContext(),"mockup_block",mockup);
+	mBuilder.SetInsertPoint(MB);
+	// ndx = mockup_ndx; mockup_ndx = (ndx < N-1) ? ndx+1 : ndx; return values[ndx];
+	Value* ndx = mBuilder.CreateLoad(g_ndx);
+	Value* last = mBuilder.getInt32(constants.size()-1);
+	Value* next = mBuilder.CreateSelect(mBuilder.CreateICmpULT(ndx, last),
+			mBuilder.CreateAdd(ndx, mBuilder.getInt32(1)), ndx);
+	mBuilder.CreateStore(next, g_ndx);
+	vector<Value*> ndxs;
+	ndxs.push_back(mBuilder.getInt32(0));
+	ndxs.push_back(ndx);
+	Value* ptr = mBuilder.CreateInBoundsGEP(g_values, ndxs);
+	mBuilder.CreateRet(mBuilder.CreateLoad(ptr));
+	mBuilder.ClearInsertionPoint();
+
+	return g_ndx;
+}
+
+llvm::Value* TestGeneratorVisitor::loadDataColumn(llvm::Type* type)
+{
+	assert(mDataTable && mDataRow && "Not in data loop mode");
+	unsigned ndx = mDataTable->getPlaceholderColumn(mDataColumn++);
+	if(ndx >= mDataTable->columnCount())
+		throw JCUTException("Not enough data in file "+mDataTable->getPath()+
+				" for function "+mDataCall->getFunctionCalledString());
+	DataTable::Column& column = mDataTable->getColumn(ndx);
+	if(column.isMapped())
+		return loadMappedColumn(column, type);
+	if(column.isGenerated())
+		return loadGeneratedColumn(column, type);
+	if(column.isInput())
+		return loadInputColumn(column, type);
+	LLVMContext& ctx = mModule->getContext();
+	llvm::Constant* values = nullptr;
+	if(type->isIntegerTy(8))
+		values = ConstantDataArray::get(ctx, column.getValues<uint8_t>());
+	else if(type->isIntegerTy(16))
+		values = ConstantDataArray::get(ctx, column.getValues<uint16_t>());
+	else if(type->isIntegerTy(32))
+		values = ConstantDataArray::get(ctx, column.getValues<uint32_t>());
+	else if(type->isIntegerTy(64))
+		values = ConstantDataArray::get(ctx, column.getValues<uint64_t>());
+	else if(type->isFloatTy())
+		values = ConstantDataArray::get(ctx, column.getValues<float>());
+	else if(type->isDoubleTy())
+		values = ConstantDataArray::get(ctx, column.getValues<double>());
+	else if(type->isIntegerTy() || type->isFloatingPointTy()) {
+		// Uncommon types such as bool (i1) or long double
+		vector<llvm::Constant*> constants;
+		if(type->isIntegerTy())
+			for(int64_t v : column.getValues<int64_t>())
+				constants.push_back(ConstantInt::get(type, v, true));
+		else
+			for(double v : column.getValues<double>())
+				constants.push_back(ConstantFP::get(type, v));
+		values = ConstantArray::get(ArrayType::get(type, constants.size()), constants);
+	} else
+		assert(false && "Data loop mode only supports integer and floating point types");
+
+	GlobalVariable* g_column = new GlobalVariable(/*Module=*/*mModule,
+								 /*Type=*/values->getType(),
+								 /*isConstant=*/true,
+								 /*Linkage=*/GlobalValue::PrivateLinkage,
+								 /*Initializer=*/values,
+								 /*Name=*/"data_column_"+mCurrentFud);
+	LoadInst* row = mBuilder.CreateLoad(mDataRow);
+	vector<Value*> ndxs;
+	ndxs.push_back(mBuilder.getInt64(0));
+	ndxs.push_back(row);
+	Instruction* ptr = GetElementPtrInst::CreateInBounds(g_column, ndxs);
+	LoadInst* value = mBuilder.CreateLoad(ptr);
+	mInstructions.push_back(row);
+	mInstructions.push_back(ptr);
+	mInstructions.push_back(value);
+	return value;
+}
+
+llvm::Value* TestGeneratorVisitor::loadMappedColumn(DataTable::Column& column, llvm::Type* type)
+{
+	const JCBFile* file = column.mFile;
+	unsigned j = column.mFileColumn;
+	unsigned size = file->getElementSize(j);
+	LLVMContext& ctx = mModule->getContext();
+	llvm::Type* element = nullptr;
+	switch(file->getType(j)) {
+	case JCBFile::INT8: element = llvm::Type::getInt8Ty(ctx); break;
+	case JCBFile::INT16: element = llvm::Type::getInt16Ty(ctx); break;
+	case JCBFile::INT32: element = llvm::Type::getInt32Ty(ctx); break;
+	case JCBFile::INT64: element = llvm::Type::getInt64Ty(ctx); break;
+	case JCBFile::FLOAT: element = llvm::Type::getFloatTy(ctx); break;
+	case JCBFile::DOUBLE: element = llvm::Type::getDoubleTy(ctx); break;
+	case JCBFile::BLOB: element = ArrayType::get(llvm::Type::getInt8Ty(ctx), size); break;
+	}
+	// No initializer, the values are never copied into the module.
+	GlobalVariable* g_column = new GlobalVariable(/*Module=*/*mModule,
+								 /*Type=*/element,
+								 /*isConstant=*/true,
+								 /*Linkage=*/GlobalValue::ExternalLinkage,
+								 /*Initializer=*/nullptr,
+								 /*Name=*/"data_column_"+mCurrentFud);
+	column.mGlobal = g_column;
+	LoadInst* row = mBuilder.CreateLoad(mDataRow);
+	Instruction* ptr = GetElementPtrInst::CreateInBounds(g_column, row);
+	mInstructions.push_back(row);
+	mInstructions.push_back(ptr);
+
+	stringstream error;
+	error << "Column " << j+1 << " of file " << file->getPath() << " has "
+		  << JCBFile::getTypeName(file->getType(j)) << " values that can not be "
+		  << "passed to function " << mDataCall->getFunctionCalledString();
+	if(file->getType(j) == JCBFile::BLOB) {
+		// Structs passed by value are either pointers to a copy (byval) or
+		// coerced to a scalar of the same size.
+		DataLayout layout(mModule);
+		Instruction* cast = nullptr;
+		if(type->isPointerTy() && type->getPointerElementType()->isSized() &&
+		   layout.getTypeAllocSize(type->getPointerElementType()) == size)
+			cast = new BitCastInst(ptr, type);
+		else if(type->isSized() && layout.getTypeStoreSize(type) == size) {
+			Instruction* value_ptr = new BitCastInst(ptr, type->getPointerTo());
+			mInstructions.push_back(value_ptr);
+			cast = new LoadInst(value_ptr);
+		} else
+			throw JCUTException(error.str());
+		mInstructions.push_back(cast);
+		return cast;
+	}
+
+	LoadInst* value = mBuilder.CreateLoad(ptr);
+	mInstructions.push_back(value);
+	llvm::Value* cast = castDataValue(value, type);
+	if(cast == nullptr)
+		throw JCUTException(error.str());
+	return cast;
+}
+
+llvm::Value* TestGeneratorVisitor::loadGeneratedColumn(const DataTable::Column& column, llvm::Type* type)
+{
+	const DataGenerator* gen = column.mGenerator;
+	llvm::Type* i64 = mBuilder.getInt64Ty();
+	llvm::Type* f64 = mBuilder.getDoubleTy();
+	auto push = [this](Instruction* I) -> llvm::Value* {
+		mInstructions.push_back(I);
+		return I;
+	};
+	// The position of the value in the generator: (row / stride) % count
+	llvm::Value* ndx = push(mBuilder.CreateLoad(mDataRow));
+	if(column.mStride != 1)
+		ndx = push(BinaryOperator::CreateUDiv(ndx, ConstantInt::get(i64, column.mStride)));
+	ndx = push(BinaryOperator::CreateURem(ndx, ConstantInt::get(i64, gen->count())));
+
+	// Same operations in the same order as DataGenerator::getIntAt() and
+	// DataGenerator::getFloatAt(), the failing rows are reported with them.
+	llvm::Value* value = nullptr;
+	if(gen->getKind() == DataGenerator::RANGE) {
+		if(gen->isFloat()) {
+			llvm::Value* real = push(new UIToFPInst(ndx, f64));
+			real = push(BinaryOperator::CreateFMul(real, ConstantFP::get(f64, gen->getStepFloat())));
+			value = push(BinaryOperator::CreateFAdd(real, ConstantFP::get(f64, gen->getFirstFloat())));
+		} else {
+			llvm::Value* offset = push(BinaryOperator::CreateMul(ndx,
+					ConstantInt::get(i64, gen->getStepInt(), true)));
+			value = push(BinaryOperator::CreateAdd(offset,
+					ConstantInt::get(i64, gen->getFirstInt(), true)));
+		}
+	} else {
+		// splitmix64, see DataGenerator::hash()
+		llvm::Value* z = push(BinaryOperator::CreateAdd(ndx, ConstantInt::get(i64, 1)));
+		z = push(BinaryOperator::CreateMul(z, ConstantInt::get(i64, DataGenerator::HashIncrement)));
+		z = push(BinaryOperator::CreateAdd(z, ConstantInt::get(i64, gen->getSeed())));
+		const uint64_t shifts[] = { 30, 27, 31 };
+		const uint64_t multipliers[] = { DataGenerator::HashMultiplier1, DataGenerator::HashMultiplier2 };
+		for(unsigned i = 0; i < 3; ++i) {
+			llvm::Value* shifted = push(BinaryOperator::CreateLShr(z, ConstantInt::get(i64, shifts[i])));
+			z = push(BinaryOperator::CreateXor(z, shifted));
+			if(i < 2)
+				z = push(BinaryOperator::CreateMul(z, ConstantInt::get(i64, multipliers[i])));
+		}
+		if(gen->isFloat()) {
+			llvm::Value* bits = push(BinaryOperator::CreateLShr(z, ConstantInt::get(i64, 11)));
+			llvm::Value* unit = push(new UIToFPInst(bits, f64));
+			unit = push(BinaryOperator::CreateFMul(unit, ConstantFP::get(f64, 1.0 / 9007199254740992.0)));
+			unit = push(BinaryOperator::CreateFMul(unit,
+					ConstantFP::get(f64, gen->getMaxFloat() - gen->getFirstFloat())));
+			value = push(BinaryOperator::CreateFAdd(unit, ConstantFP::get(f64, gen->getFirstFloat())));
+		} else {
+			uint64_t span = static_cast<uint64_t>(gen->getMaxInt() - gen->getFirstInt()) + 1;
+			if(span)
+				z = push(BinaryOperator::CreateURem(z, ConstantInt::get(i64, span)));
+			value = push(BinaryOperator::CreateAdd(z, ConstantInt::get(i64, gen->getFirstInt(), true)));
+		}
+	}
+
+	llvm::Value* cast = castDataValue(value, type);
+	if(cast == nullptr)
+		throw JCUTException("The values of the data generator "+gen->toString()+
+				" can not be passed to function "+mDataCall->getFunctionCalledString());
+	return cast;
+}
+
+llvm::Value* TestGeneratorVisitor::loadInputColumn(DataTable::Column& column, llvm::Type* type)
+{
+	if(column.mGlobal == nullptr) {
+		// Each input is stored in 8 bytes
+		if((!type->isIntegerTy() && !type->isFloatTy() && !type->isDoubleTy()) ||
+		   type->getPrimitiveSizeInBits() > 64)
+			throw JCUTException("The inputs of a property must be integers, floats "
+					"or doubles: "+mDataCall->getFunctionCalledString());
+		column.mInputType = type;
+		column.mGlobal = new GlobalVariable(/*Module=*/*mModule,
+									 /*Type=*/type,
+									 /*isConstant=*/false,
+									 /*Linkage=*/GlobalValue::ExternalLinkage,
+									 /*Initializer=*/nullptr,
+									 /*Name=*/"property_input_"+mCurrentFud);
+	}
+	LoadInst* value = mBuilder.CreateLoad(column.mGlobal);
+	mInstructions.push_back(value);
+	// The same input can be passed to parameters of different types
+	llvm::Value* cast = castDataValue(value, type);
+	if(cast == nullptr)
+		throw JCUTException("The input @"+column.mName+" can not be passed to "
+				"function "+mDataCall->getFunctionCalledString());
+	return cast;
+}
+
+llvm::Value* TestGeneratorVisitor::castDataValue(llvm::Value* value, llvm::Type* type)
+{
+	llvm::Type* from = value->getType();
+	if(from == type)
+		return value;
+	Instruction* cast = nullptr;
+	if(from->isIntegerTy() && type->isIntegerTy())
+		cast = CastInst::CreateIntegerCast(value, type, /*isSigned=*/true);
+	else if(from->isIntegerTy() && type->isFloatingPointTy())
+		cast = new SIToFPInst(value, type);
+	else if(from->isFloatingPointTy() && type->isIntegerTy())
+		cast = new FPToSIInst(value, type);
+	else if(from->isFloatingPointTy() && type->isFloatingPointTy())
+		cast = CastInst::CreateFPCast(value, type);
+	else
+		return nullptr;
+	mInstructions.push_back(cast);
+	return cast;
+}
+
+llvm::StructType* TestGeneratorVisitor::getTestDriverResultType()
+{
+	StructType* ResultTy = mModule->getTypeByName("struct.TestDriverResult");
+	if(ResultTy)
+		return ResultTy;
+	vector<Type*> fields;
+	fields.push_back(mBuilder.getInt8Ty());   // passed
+	fields.push_back(mBuilder.getInt64Ty());  // failed_ee_mask
+	fields.push_back(mBuilder.getInt64Ty());  // int_value
+	fields.push_back(mBuilder.getDoubleTy()); // fp_value
+	fields.push_back(mBuilder.getInt8PtrTy());// ptr_value
+	fields.push_back(mBuilder.getInt64Ty());  // row_begin
+	fields.push_back(mBuilder.getInt64Ty());  // row_end
+	fields.push_back(mBuilder.getInt8PtrTy());// failed_rows
+	fields.push_back(mBuilder.getInt64Ty());  // failed_row_count
+	return StructType::create(mModule->getContext(), fields, "struct.TestDriverResult");
+}
+
+void TestGeneratorVisitor::emitTestDriverBody(TestDefinition* TD, Value* out,
+		Value*& passed, Value*& mask)
+{
+	const vector<ExpectedExpression*>& EEs = TD->getExpectedExpressions();
+	vector<MockupFunction*> mockups;
+	if(TD->hasTestMockup())
+		mockups = TD->getTestMockup()->getMockupFixture()->getMockupFunctions();
+	for(MockupFunction* m : mockups)
+		mBuilder.CreateCall(m->getMockupFunction());
+
+	Function* test = TD->getLLVMFunction();
+	Value* ret = mBuilder.CreateCall(test);
+	passed = mBuilder.CreateCall(TD->getLLVMResultFunction());
+
+	mask = mBuilder.getInt64(0);
+	for(unsigned i = 0; i < EEs.size(); ++i) {
+		Value* ee = mBuilder.CreateCall(EEs[i]->getLLVMResultFunction());
+		Value* failed = mBuilder.CreateICmpEQ(ee, mBuilder.getInt8(0));
+		mask = mBuilder.CreateOr(mask, mBuilder.CreateSelect(failed,
+				mBuilder.getInt64(1ULL << i), mBuilder.getInt64(0)));
+	}
+
+	// Do the opposite steps for the Mockups and point back to the mockup
+	// functions of the current group.
+	for(MockupFunction* m : mockups)
+		mBuilder.CreateCall(m->getOriginalFunction());
+	if(mockups.size()) {
+		unsigned first = mGroupMockups.size();
+		while(first && mGroupMockups[first-1] != nullptr)
+			--first;
+		for(unsigned i = first; i < mGroupMockups.size(); ++i)
+			mBuilder.CreateCall(mGroupMockups[i]);
+	}
+
+	Type* RetTy = test->getReturnType();
+	switch(RetTy->getTypeID()) {
+		case Type::IntegerTyID:
+			mBuilder.CreateStore(mBuilder.CreateZExtOrTrunc(ret, mBuilder.getInt64Ty()),
+					mBuilder.CreateStructGEP(out, 2));
+			break;
+		case Type::FloatTyID:
+			mBuilder.CreateStore(mBuilder.CreateFPExt(ret, mBuilder.getDoubleTy()),
+					mBuilder.CreateStructGEP(out, 3));
+			break;
+		case Type::DoubleTyID:
+			mBuilder.CreateStore(ret, mBuilder.CreateStructGEP(out, 3));
+			break;
+		case Type::PointerTyID:
+			mBuilder.CreateStore(mBuilder.CreateBitCast(ret, mBuilder.getInt8PtrTy()),
+					mBuilder.CreateStructGEP(out, 4));
+			break;
+		default: // void and struct types are not reported
+			break;
+	}
+}
+
+llvm::Function* TestGeneratorVisitor::createTestDriver(TestDefinition* TD)
+{
+	const vector<ExpectedExpression*>& EEs = TD->getExpectedExpressions();
+	if(EEs.size() > sizeof(TestDriverResult::failed_ee_mask)*8) {
+		if(mDataRow)
+			throw JCUTException("Too many expected expressions to run the test "+
+					TD->getTestFunction()->getFunctionCall()->getFunctionCalledString()+
+					" in data loop mode.\n\tRun it without --data-loop");
+		return nullptr; // The runner will call each function on its own
+	}
+
+	if(mDataRow) {
+		createGlobalsSnapshot();
+		TD->setSaveGlobalsFunction(mSaveGlobals);
+	}
+
+	Function* test = TD->getLLVMFunction();
+	StructType* ResultTy = getTestDriverResultType();
+	vector<Type*> params;
+	params.push_back(PointerType::getUnqual(ResultTy));
+	FunctionType* FT = FunctionType::get(mBuilder.getVoidTy(), params, false);
+	Function* driver = Function::Create(FT, GlobalValue::ExternalLinkage,
+			"driver_"+test->getName().str(), mModule);
+	LLVMContext& ctx = mModule->getContext();
+	BasicBlock* BB = BasicBlock::Create(ctx, "block_"+driver->getName().str(), driver);
+	mBuilder.SetInsertPoint(BB);
+	Value* out = driver->arg_begin();
+	Value* passed = nullptr;
+	Value* mask = nullptr;
+
+	if(mDataRow == nullptr) {
+		emitTestDriverBody(TD, out, passed, mask);
+		mBuilder.CreateStore(passed, mBuilder.CreateStructGEP(out, 0));
+		mBuilder.CreateStore(mask, mBuilder.CreateStructGEP(out, 1));
+		mBuilder.CreateRetVoid();
+		mBuilder.ClearInsertionPoint();
+		return driver;
+	}
+
+	// for(row = row_begin; row < row_end; ++row) run the test and mark the
+	// failing rows in the failed_rows bitmap.
+	BasicBlock* Cond = BasicBlock::Create(ctx, "data_loop_cond", driver);
+	BasicBlock* Body = BasicBlock::Create(ctx, "data_loop_body", driver);
+	BasicBlock* Failed = BasicBlock::Create(ctx, "data_row_failed", driver);
+	BasicBlock* Next = BasicBlock::Create(ctx, "data_loop_next", driver);
+	BasicBlock* Exit = BasicBlock::Create(ctx, "data_loop_exit", driver);
+
+	Value* begin = mBuilder.CreateLoad(mBuilder.CreateStructGEP(out, 5));
+	Value* end = mBuilder.CreateLoad(mBuilder.CreateStructGEP(out, 6));
+	Value* bitmap = mBuilder.CreateLoad(mBuilder.CreateStructGEP(out, 7));
+	mBuilder.CreateBr(Cond);
+
+	mBuilder.SetInsertPoint(Cond);
+	PHINode* row = mBuilder.CreatePHI(mBuilder.getInt64Ty(), 2, "row");
+	PHINode* failed_rows = mBuilder.CreatePHI(mBuilder.getInt64Ty(), 2, "failed_rows");
+	PHINode* all_mask = mBuilder.CreatePHI(mBuilder.getInt64Ty(), 2, "failed_ee_mask");
+	mBuilder.CreateCondBr(mBuilder.CreateICmpULT(row, end), Body, Exit);
+
+	// Every row starts with the globals of the module the runner saved, as
+	// the rows of a test run without --data-loop each run in their own fork.
+	mBuilder.SetInsertPoint(Body);
+	mBuilder.CreateCall(mRestoreGlobals);
+	mBuilder.CreateStore(row, mDataRow);
+	emitTestDriverBody(TD, out, passed, mask);
+	Value* new_mask = mBuilder.CreateOr(all_mask, mask);
+	Value* row_failed = mBuilder.CreateOr(
+			mBuilder.CreateICmpEQ(passed, mBuilder.getInt8(0)),
+			mBuilder.CreateICmpNE(mask, mBuilder.getInt64(0)));
+	BasicBlock* BodyEnd = mBuilder.GetInsertBlock();
+	mBuilder.CreateCondBr(row_failed, Failed, Next);
+
+	// failed_rows[(row-row_begin)/8] |= 1 << (row-row_begin)%8;
+	mBuilder.SetInsertPoint(Failed);
+	Value* offset = mBuilder.CreateSub(row, begin);
+	Value* byte = mBuilder.CreateInBoundsGEP(bitmap, mBuilder.CreateLShr(offset, 3));
+	Value* bit = mBuilder.CreateShl(mBuilder.getInt8(1),
+			mBuilder.CreateTrunc(mBuilder.CreateAnd(offset, 7), mBuilder.getInt8Ty()));
+	mBuilder.CreateStore(mBuilder.CreateOr(mBuilder.CreateLoad(byte), bit), byte);
+	Value* inc = mBuilder.CreateAdd(failed_rows, mBuilder.getInt64(1));
+	mBuilder.CreateBr(Next);
+
+	mBuilder.SetInsertPoint(Next);
+	PHINode* count = mBuilder.CreatePHI(mBuilder.getInt64Ty(), 2);
+	count->addIncoming(failed_rows, BodyEnd);
+	count->addIncoming(inc, Failed);
+	Value* next_row = mBuilder.CreateAdd(row, mBuilder.getInt64(1));
+	mBuilder.CreateBr(Cond);
+
+	row->addIncoming(begin, BB);
+	row->addIncoming(next_row, Next);
+	failed_rows->addIncoming(mBuilder.getInt64(0), BB);
+	failed_rows->addIncoming(count, Next);
+	all_mask->addIncoming(mBuilder.getInt64(0), BB);
+	all_mask->addIncoming(new_mask, Next);
+
+	mBuilder.SetInsertPoint(Exit);
+	mBuilder.CreateStore(mBuilder.CreateZExt(
+			mBuilder.CreateICmpEQ(failed_rows, mBuilder.getInt64(0)), mBuilder.getInt8Ty()),
+			mBuilder.CreateStructGEP(out, 0));
+	mBuilder.CreateStore(all_mask, mBuilder.CreateStructGEP(out, 1));
+	mBuilder.CreateStore(failed_rows, mBuilder.CreateStructGEP(out, 8));
+	mBuilder.CreateRetVoid();
+	mBuilder.ClearInsertionPoint();
+
+	return driver;
+}
+
+void TestGeneratorVisitor::createGlobalsSnapshot()
+{
+	if(mSaveGlobals)
+		return;
+	vector<GlobalVariable*> globals;
+	for(GlobalVariable& G : mModule->getGlobalList())
+		if(!G.isConstant() && !G.isDeclaration() && !G.isThreadLocal())
+			globals.push_back(&G);
+
+	LLVMContext& ctx = mModule->getContext();
+	FunctionType* FT = FunctionType::get(mBuilder.getVoidTy(), false);
+	mSaveGlobals = Function::Create(FT, GlobalValue::ExternalLinkage,
+			"jcut_save_globals", mModule);
+	mRestoreGlobals = Function::Create(FT, GlobalValue::ExternalLinkage,
+			"jcut_restore_globals", mModule);
+	BasicBlock* save = BasicBlock::Create(ctx, "block_save_globals", mSaveGlobals);
+	BasicBlock* restore = BasicBlock::Create(ctx, "block_restore_globals", mRestoreGlobals);
+	DataLayout layout(mModule);
+	for(GlobalVariable* G : globals) {
+		Type* T = G->getType()->getElementType();
+		GlobalVariable* saved = new GlobalVariable(/*Module=*/*mModule,
+									 /*Type=*/T,
+									 /*isConstant=*/false,
+									 /*Linkage=*/GlobalValue::PrivateLinkage,
+									 /*Initializer=*/llvm::Constant::getNullValue(T),
+									 /*Name=*/G->getName()+"_saved");
+		uint64_t size = layout.getTypeAllocSize(T);
+		mBuilder.SetInsertPoint(save);
+		mBuilder.CreateMemCpy(saved, G, size, 1);
+		mBuilder.SetInsertPoint(restore);
+		mBuilder.CreateMemCpy(G, saved, size, 1);
+	}
+	mBuilder.SetInsertPoint(save);
+	mBuilder.CreateRetVoid();
+	mBuilder.SetInsertPoint(restore);
+	mBuilder.CreateRetVoid();
+	mBuilder.ClearInsertionPoint();
+}
+
+llvm::Function* TestGeneratorVisitor::createBenchFunction(TestDefinition* TD)
+{
+	Function* test = TD->getLLVMFunction();
+	vector<Type*> params;
+	params.push_back(mBuilder.getInt64Ty());
+	FunctionType* FT = FunctionType::get(mBuilder.getVoidTy(), params, false);
+	Function* bench = Function::Create(FT, GlobalValue::ExternalLinkage,
+			"bench_"+test->getName().str(), mModule);
+	LLVMContext& ctx = mModule->getContext();
+	BasicBlock* BB = BasicBlock::Create(ctx, "block_"+bench->getName().str(), bench);
+	BasicBlock* Cond = BasicBlock::Create(ctx, "bench_loop_cond", bench);
+	BasicBlock* Body = BasicBlock::Create(ctx, "bench_loop_body", bench);
+	BasicBlock* Exit = BasicBlock::Create(ctx, "bench_loop_exit", bench);
+	mBuilder.SetInsertPoint(BB);
+	Value* n = bench->arg_begin();
+
+	Type* RetTy = test->getReturnType();
+	Value* sink = nullptr;
+	if(RetTy->isVoidTy() == false)
+		sink = mBuilder.CreateAlloca(RetTy, nullptr, "sink");
+	vector<MockupFunction*> mockups;
+	if(TD->hasTestMockup())
+		mockups = TD->getTestMockup()->getMockupFixture()->getMockupFunctions();
+	for(MockupFunction* m : mockups)
+		mBuilder.CreateCall(m->getMockupFunction());
+	mBuilder.CreateBr(Cond);
+
+	// for(i = 0; i < n; ++i) sink = test();
+	mBuilder.SetInsertPoint(Cond);
+	PHINode* i = mBuilder.CreatePHI(mBuilder.getInt64Ty(), 2, "i");
+	mBuilder.CreateCondBr(mBuilder.CreateICmpULT(i, n), Body, Exit);
+
+	mBuilder.SetInsertPoint(Body);
+	Value* ret = mBuilder.CreateCall(test);
+	if(sink)
+		mBuilder.CreateStore(ret, sink, /*isVolatile=*/true);
+	Value* next = mBuilder.CreateAdd(i, mBuilder.getInt64(1));
+	mBuilder.CreateBr(Cond);
+
+	i->addIncoming(mBuilder.getInt64(0), BB);
+	i->addIncoming(next, Body);
+
+	// As the driver does, back to the mockups of the current group
+	mBuilder.SetInsertPoint(Exit);
+	for(MockupFunction* m : mockups)
+		mBuilder.CreateCall(m->getOriginalFunction());
+	if(mockups.size()) {
+		unsigned first = mGroupMockups.size();
+		while(first && mGroupMockups[first-1] != nullptr)
+			--first;
+		for(unsigned j = first; j < mGroupMockups.size(); ++j)
+			mBuilder.CreateCall(mGroupMockups[j]);
+	}
+	mBuilder.CreateRetVoid();
+	mBuilder.ClearInsertionPoint();
+
+	return bench;
+}
+
 string TestGeneratorVisitor::getUniqueTestName(const string& name)
 {
     string unique_name = name + "_0";
@@ -1118,6 +1759,21 @@ string TestGeneratorVisitor::getUniqueTestName(const string& name)
     return unique_name;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Find the tests of the functions defined in a module
+
+void SourceFileVisitor::VisitTestDefinition(TestDefinition* TD)
+{
+	if(!TD->getSourceFile().empty())
+		return;
+	string name = TD->getTestFunction()->getFunctionCall()->getIdentifier()->toString();
+	llvm::Function* F = mModule->getFunction(name);
+	if(mTakeAll || (F && !F->isDeclaration())) {
+		TD->setSourceFile(mSource);
+		++mTestCount;
+	}
+}
+
 //////////////////////////////////////////////////////////////////////
 // Replace all the DataPlaceholders to generate all the functions
 
@@ -1125,8 +1781,24 @@ void DataPlaceholderVisitor::VisitTestDefinition(TestDefinition* TD)
 {
 	TestData *d = TD->getTestData();
 	TestFunction* TF = TD->getTestFunction();
+	// Mockup functions returning values from the CSV file: f() = @;
+	vector<MockupFunction*> mockup_dp;
+	if(TD->hasTestMockup())
+		mockup_dp = TD->getTestMockup()->getMockupFixture()->getDataPlaceholderMockups();
+	bool has_placeholders = TF->hasDataPlaceholders() || mockup_dp.size();
+
+	if (TD->isProperty()) {
+		TD->setDataTable(createPropertyTable(TD));
+		return; // The TestRunnerVisitor chooses the values
+	}
 
-	if (d == nullptr && TF->hasDataPlaceholders()) {
+	for (const DataPlaceholder* dp : TF->getFunctionCall()->getDataPlaceholders())
+		if (dp->hasName())
+			throw JCUTException("Named DataPlaceholders like "+dp->toString()+
+					" can only be used inside a property { }: "+
+					TF->getFunctionCall()->getFunctionCalledString());
+
+	if (d == nullptr && has_placeholders) {
 		string func = TF->getFunctionCall()->getFunctionCalledString();
 		ExpectedResult* R = TF->getExpectedResult();
 		if(R && R->isDataPlaceholder())
@@ -1135,14 +1807,23 @@ void DataPlaceholderVisitor::VisitTestDefinition(TestDefinition* TD)
 				"\tAdd it with the statement: 'data { \"path-to-file.csv\"; }'");
 	}
 
-	if (d && TF->hasDataPlaceholders() == false)
+	if (d && has_placeholders == false)
 		return; // Do not open file
 
-	if (d && TF->hasDataPlaceholders()) {
+	if (d && has_placeholders) {
 		string path = d->getDataPath();
+		if(d->hasGenerators()) {
+			TD->setDataTable(createGeneratedDataTable(TD));
+			return; // The values are computed by the test loop
+		}
+		if(JCBFile::isJCBFile(path)) {
+			TD->setDataTable(createBinaryDataTable(TD, path));
+			return; // A single function will iterate over all the rows
+		}
 		CSVDriver csv(path);
 
-		unsigned placeholder_count = TF->getFunctionCall()->getDataPlaceholdersPos().size();
+		unsigned placeholder_count = mockup_dp.size();
+		placeholder_count += TF->getFunctionCall()->getDataPlaceholdersPos().size();
 		ExpectedResult* R = TF->getExpectedResult();
 		if(R)
 			placeholder_count += (R->isDataPlaceholder())?1:0;
@@ -1154,21 +1835,36 @@ void DataPlaceholderVisitor::VisitTestDefinition(TestDefinition* TD)
 			throw JCUTException("Not enough data in CVS file "+path+" for function "+func);
 		}
 
+		if(mDataLoop) {
+			shared_ptr<DataTable> table = createDataTable(TD, csv);
+			if(table) {
+				TD->setDataTable(table);
+				return; // A single function will iterate over all the rows
+			}
+			csv.rewind(); // Fall back to one test per row
+		}
+
 		vector<TestDefinition*> to_be_added;
-		for(unsigned i = 0; i < csv.rowCount(); ++i) {
+		while(csv.nextRow()) {
 			///////////////////////////////////////
 			// Copy the test definition N times
 			TestDefinition* copy = new TestDefinition(*TD);
+			// The columns are consumed in the same order the placeholders
+			// appear in the test file: mockups, arguments and expected result.
+			unsigned j = 0;
+			if(copy->hasTestMockup()) {
+				for(MockupFunction* MF : copy->getTestMockup()->getMockupFixture()->getDataPlaceholderMockups())
+					MF->replaceDataPlaceholder(csv.getMockupSequenceAt(j++));
+			}
 
 			FunctionCall* FC = copy->getTestFunction()->getFunctionCall();
 			vector<unsigned> dp_positions =  FC->getDataPlaceholdersPos();
-			unsigned j = 0;
 			for(unsigned pos : dp_positions)
-				FC->replaceDataPlaceholder(pos, csv.getFunctionArgumentAt(i,j++));
+				FC->replaceDataPlaceholder(pos, csv.getFunctionArgumentAt(j++));
 
 			ExpectedResult* ER = copy->getTestFunction()->getExpectedResult();
 			if(ER && ER->isDataPlaceholder())
-				ER->replaceDataPlaceholder(csv.getExpectedConstantAt(i,j++));
+				ER->replaceDataPlaceholder(csv.getExpectedConstantAt(j++));
 
 			to_be_added.push_back(copy);
 			//
@@ -1181,6 +1877,146 @@ void DataPlaceholderVisitor::VisitTestDefinition(TestDefinition* TD)
 	}
 }
 
+shared_ptr<DataTable> DataPlaceholderVisitor::createDataTable(TestDefinition* TD, CSVDriver& csv)
+{
+	if(TD->hasTestMockup() &&
+	   TD->getTestMockup()->getMockupFixture()->getDataPlaceholderMockups().size())
+		return nullptr;
+
+	TestFunction* TF = TD->getTestFunction();
+	FunctionCall* FC = TF->getFunctionCall();
+	llvm::Function* F = mModule->getFunction(FC->getIdentifier()->toString());
+	if(F == nullptr || F->getArgumentList().size() != FC->getArgCount())
+		return nullptr; // Let the TestGeneratorVisitor report the error
+
+	vector<llvm::Type*> params;
+	for(llvm::Argument& arg : F->getArgumentList())
+		params.push_back(arg.getType());
+	// The types of the columns in the same order the DataPlaceholders appear
+	vector<llvm::Type*> types;
+	for(unsigned pos : FC->getDataPlaceholdersPos())
+		types.push_back(params[pos]);
+	ExpectedResult* ER = TF->getExpectedResult();
+	if(ER && ER->isDataPlaceholder())
+		types.push_back(F->getReturnType());
+	for(llvm::Type* type : types)
+		if(!type->isIntegerTy() && !type->isFloatingPointTy())
+			return nullptr;
+
+	shared_ptr<DataTable> table(new DataTable(TD->getTestData()->getDataPath(), types.size()));
+	// The rows are parsed straight into the columns with the type of the
+	// parameter they are passed to, no Constant is created for them.
+	while(csv.nextRow()) {
+		for(unsigned j = 0; j < types.size(); ++j) {
+			DataTable::Column& column = table->getColumn(j);
+			llvm::StringRef field = csv.getFieldAt(j);
+			if(types[j]->isFloatingPointTy()) {
+				double value = 0;
+				int64_t int_value = 0; // Hexadecimal and char constants
+				if(CSVReader::parseFloat(field, value))
+					column.addFloat(value);
+				else if(CSVReader::parseInt(field, int_value))
+					column.addFloat(int_value);
+				else
+					return nullptr;
+			} else {
+				int64_t value = 0;
+				if(!CSVReader::parseInt(field, value))
+					return nullptr;
+				column.addInt(value);
+			}
+		}
+	}
+	table->setRowCount(csv.rowCount());
+	return table;
+}
+
+shared_ptr<DataTable> DataPlaceholderVisitor::createBinaryDataTable(TestDefinition* TD, const string& path)
+{
+	TestFunction* TF = TD->getTestFunction();
+	string func = TF->getFunctionCall()->getFunctionCalledString();
+	ExpectedResult* R = TF->getExpectedResult();
+	if(R && R->isDataPlaceholder())
+		func += " " + R->getComparisonOperator()->toString() + " @";
+	if(TD->hasTestMockup() &&
+	   TD->getTestMockup()->getMockupFixture()->getDataPlaceholderMockups().size())
+		throw JCUTException("Mockup functions can not return values from the binary "
+				"data file "+path+" used by "+func);
+
+	shared_ptr<JCBFile> file(new JCBFile(path));
+	unsigned placeholder_count = TF->getFunctionCall()->getDataPlaceholdersPos().size();
+	if(R && R->isDataPlaceholder())
+		++placeholder_count;
+	if(placeholder_count > file->columnCount())
+		throw JCUTException("Not enough data in file "+path+" for function "+func);
+	return shared_ptr<DataTable>(new DataTable(file));
+}
+
+shared_ptr<DataTable> DataPlaceholderVisitor::createGeneratedDataTable(TestDefinition* TD)
+{
+	TestFunction* TF = TD->getTestFunction();
+	const vector<DataGenerator*>& generators = TD->getTestData()->getGenerators();
+	string desc = TD->getTestData()->getDataPath();
+	string func = TF->getFunctionCall()->getFunctionCalledString();
+	ExpectedResult* R = TF->getExpectedResult();
+	if(R && R->isDataPlaceholder())
+		func += " " + R->getComparisonOperator()->toString() + " @";
+	if(TD->hasTestMockup() &&
+	   TD->getTestMockup()->getMockupFixture()->getDataPlaceholderMockups().size())
+		throw JCUTException("Mockup functions can not return values from the data "
+				"generators "+desc+" used by "+func);
+
+	unsigned placeholder_count = TF->getFunctionCall()->getDataPlaceholdersPos().size();
+	if(R && R->isDataPlaceholder())
+		++placeholder_count;
+	// Every generator multiplies the number of rows, an unused one would
+	// only run the same rows again.
+	if(placeholder_count != generators.size()) {
+		stringstream ss;
+		ss << "The function " << func << " has " << placeholder_count
+		   << " DataPlaceholders but there are " << generators.size()
+		   << " data generators: " << desc;
+		throw JCUTException(ss.str());
+	}
+	return shared_ptr<DataTable>(new DataTable(desc, generators));
+}
+
+shared_ptr<DataTable> DataPlaceholderVisitor::createPropertyTable(TestDefinition* TD)
+{
+	TestFunction* TF = TD->getTestFunction();
+	string func = TF->getFunctionCall()->getFunctionCalledString();
+	ExpectedResult* R = TF->getExpectedResult();
+	if(R)
+		func += " " + R->getComparisonOperator()->toString() + " " +
+				R->getExpectedConstant()->toString();
+	if(TD->hasTestMockup() &&
+	   TD->getTestMockup()->getMockupFixture()->getDataPlaceholderMockups().size())
+		throw JCUTException("Mockup functions can not return random values in "
+				"the property "+func);
+
+	// One input per name, every unnamed DataPlaceholder is an input on its own.
+	vector<string> names;
+	vector<unsigned> columns;
+	for(const DataPlaceholder* dp : TF->getFunctionCall()->getDataPlaceholders()) {
+		vector<string>::iterator it = find(names.begin(), names.end(), dp->getName());
+		if(dp->hasName() && it != names.end())
+			columns.push_back(it - names.begin());
+		else {
+			columns.push_back(names.size());
+			names.push_back(dp->getName());
+		}
+	}
+	if(R && R->isDataPlaceholder()) {
+		const DataPlaceholder* dp = R->getExpectedConstant()->getDataPlaceholder();
+		vector<string>::iterator it = find(names.begin(), names.end(), dp->getName());
+		if(!dp->hasName() || it == names.end())
+			throw JCUTException("The expected result of the property "+func+
+					" must be a constant or one of its inputs, i.e. f(@x) == @x");
+		columns.push_back(it - names.begin());
+	}
+	return shared_ptr<DataTable>(new DataTable(names, columns));
+}
+
 void DataPlaceholderVisitor::VisitTestGroupFirst(TestGroup*)
 {
 	mTests.push(nullptr);
@@ -47,6 +47,27 @@ namespace llvm {
 
 using namespace tp;
 
+/// Gives the tests of the functions defined in a module to the C source file
+/// the module was compiled from. A test already given to another source file
+/// is left alone.
+class SourceFileVisitor : public Visitor {
+	void VisitTestDefinition(TestDefinition*);
+private:
+	llvm::Module* mModule;
+	string mSource;
+	/// Give all the remaining tests to this source file, even when their
+	/// function is not defined in it. It is used for the last source file so
+	/// the errors of those tests are reported.
+	bool mTakeAll;
+	unsigned mTestCount;
+public:
+	SourceFileVisitor(llvm::Module* mod, const string& source, bool take_all) :
+		mModule(mod), mSource(source), mTakeAll(take_all), mTestCount(0) {}
+
+	/// The number of tests given to the source file
+	unsigned getTestCount() const { return mTestCount; }
+};
+
 class DataPlaceholderVisitor : public Visitor {
 	void VisitTestDefinition(TestDefinition*);
 	void VisitTestGroupFirst(TestGroup*);
@@ -57,6 +78,26 @@ private:
 	/// Used to control the TestDefinition that should be replaced for the
 	/// current group.
 	stack<TestDefinition*> mTests;
+	/// When true the tests are not cloned for every row of their data file,
+	/// a DataTable is attached to them instead.
+	bool mDataLoop;
+	/// Used to know the types of the function under test in data loop mode.
+	llvm::Module* mModule;
+
+	/// Reads the data file into a DataTable. Returns nullptr when the test can
+	/// not be run in data loop mode, i.e. any of its DataPlaceholders is not
+	/// an integer or floating point value.
+	shared_ptr<DataTable> createDataTable(TestDefinition* TD, CSVDriver& csv);
+	/// Maps a binary data file. These files are always run in data loop mode.
+	shared_ptr<DataTable> createBinaryDataTable(TestDefinition* TD, const string& path);
+	/// The rows are all the combinations of the values of the data generators.
+	/// Like binary data files they are always run in data loop mode.
+	shared_ptr<DataTable> createGeneratedDataTable(TestDefinition* TD);
+	/// The inputs of a property { }, their values are chosen when it runs.
+	shared_ptr<DataTable> createPropertyTable(TestDefinition* TD);
+public:
+	DataPlaceholderVisitor(bool data_loop = false, llvm::Module* mod = nullptr) :
+		mDataLoop(data_loop && mod), mModule(mod) {}
 };
 
 class TestGeneratorVisitor : public Visitor {
@@ -101,6 +142,28 @@ private:
     std::string mCurrentFuncCall; // Name of the current FunctionCall we are visiting.
     llvm::ZExtInst* mTestResult;
     std::map<string,llvm::Function*> mFunctionsWrapped;
+    /// ExpectedExpressions visited since the last TestDefinition. They are
+    /// evaluated by the driver function of the next test.
+    std::vector<ExpectedExpression*> mPendingEE;
+    /// Functions that switch to the group mockups, a nullptr marks the
+    /// beginning of a new group. The driver of a test with its own mockups
+    /// uses them to point back to the mockups of the current group.
+    std::vector<llvm::Function*> mGroupMockups;
+    /// The following attributes are only used by tests run in data loop mode.
+    DataTable* mDataTable;
+    /// Index of the row being run
+    llvm::GlobalVariable* mDataRow;
+    /// Next column of mDataTable to be used by a DataPlaceholder
+    unsigned mDataColumn;
+    /// The function call of the test, the only one that may use DataPlaceholders
+    FunctionCall* mDataCall;
+    bool mInDataCall;
+    /// Create the benchmark functions of --bench
+    bool mBench;
+    /// Copy the writable globals of the module to their saved copies and
+    /// back, shared by all the data loop drivers of the module.
+    llvm::Function* mSaveGlobals;
+    llvm::Function* mRestoreGlobals;
 
     /**
 	 * Creates a new Value of the same Type as type with real_value
@@ -191,6 +254,19 @@ private:
     llvm::Value* createFloatComparison(ComparisonOperator::Type,llvm::Value* LHS, llvm::Value* RHS);
     llvm::Value* createPtrComparison(ComparisonOperator::Type,llvm::Value* LHS, llvm::Value* RHS);
 
+    /**
+     * Generates the body of a mockup function which returns the values in seq
+     * one after the other. The values are stored in a constant array and a
+     * global variable holds the index of the next value to be returned. Once
+     * the end of the array is reached the last value is returned for every
+     * subsequent call.
+     *
+     * @return The index global variable. It needs to be reset every time the
+     * mockup function is switched on.
+     */
+    llvm::GlobalVariable* createMockupSequence(llvm::Function* mockup,
+    		const MockupSequence* seq, const string& mockup_name);
+
     /**
      * Allocates and initializes a buffer of type ptrType->elementType using BufferAlloc information.
      * The resulting instructions generated will be stored in the vector 'instructions'.
@@ -204,11 +280,99 @@ private:
                                                 std::vector<llvm::Instruction*>& instructions);
 
     string getUniqueTestName(const string& name);
+
+    /**
+     * Emits the next column of mDataTable as a constant array of the given
+     * type and loads the value for the row being run.
+     */
+    llvm::Value* loadDataColumn(llvm::Type* type);
+    /**
+     * Same as loadDataColumn() for a column of a binary data file. The column
+     * is declared as an external global that the TestRunnerVisitor maps to
+     * the file, the value read is converted to the given type.
+     */
+    llvm::Value* loadMappedColumn(DataTable::Column& column, llvm::Type* type);
+    /**
+     * Same as loadDataColumn() for a column of a data generator. The value
+     * is computed from the row being run, see DataGenerator.
+     */
+    llvm::Value* loadGeneratedColumn(const DataTable::Column& column, llvm::Type* type);
+    /**
+     * Converts a value of a data column to the type of the parameter it is
+     * passed to. Returns nullptr when it can not be converted.
+     */
+    llvm::Value* castDataValue(llvm::Value* value, llvm::Type* type);
+    /**
+     * Same as loadDataColumn() for an input of a property. The value is read
+     * from an external global that the TestRunnerVisitor maps to the input.
+     */
+    llvm::Value* loadInputColumn(DataTable::Column& column, llvm::Type* type);
+
+    /**
+     * Emits the instructions that run the test once, from the current insert
+     * point of mBuilder, and stores its return value in the TestDriverResult
+     * out.
+     *
+     * @param[out] passed The value returned by the test result function.
+     * @param[out] mask The bitmask of failed ExpectedExpressions.
+     */
+    void emitTestDriverBody(TestDefinition* TD, llvm::Value* out,
+    		llvm::Value*& passed, llvm::Value*& mask);
+
+    /// LLVM equivalent of the struct TestDriverResult.
+    llvm::StructType* getTestDriverResultType();
+
+    /**
+     * Creates the driver function for the given test:
+     *
+     * void driver_test_<fud>(TestDriverResult*);
+     *
+     * It switches to the test mockups, calls the test function and its result
+     * function, evaluates every ExpectedExpression and reverts the mockups.
+     * Everything the runner needs is written to the TestDriverResult so a
+     * test can be run with a single native call.
+     *
+     * For a test with a DataTable the driver runs the rows in the range
+     * [row_begin, row_end) and sets a bit in failed_rows for each failing row,
+     * bit 0 is row_begin. The globals saved by the save globals function of
+     * the test are restored before every row.
+     *
+     * @return The driver or nullptr when the test has more ExpectedExpressions
+     * than bits in TestDriverResult::failed_ee_mask.
+     */
+    llvm::Function* createTestDriver(TestDefinition* TD);
+
+    /**
+     * Creates the functions that save and restore the writable globals of
+     * the module, the first time a data loop driver is created:
+     *
+     * void jcut_save_globals();
+     * void jcut_restore_globals();
+     *
+     * Every global is copied to a private global of the same type. The
+     * globals created for the tests after this call are not saved.
+     */
+    void createGlobalsSnapshot();
+
+    /**
+     * Creates the function --bench times for the given test:
+     *
+     * void bench_test_<fud>(i64 n);
+     *
+     * It switches to the test mockups, calls the test function n times and
+     * reverts the mockups. Every return value is stored to a volatile local
+     * so the calls are not optimized away. The expected result is compared
+     * on every call, as when the test runs.
+     */
+    llvm::Function* createBenchFunction(TestDefinition* TD);
 public:
     TestGeneratorVisitor(llvm::Module *mod);
     TestGeneratorVisitor(const TestGeneratorVisitor&) = delete;
     ~TestGeneratorVisitor() {}
 
+    /// The tests without a data table get a benchmark function
+    void setBench(bool bench) { mBench = bench; }
+
     void VisitFunctionArgument(FunctionArgument *);
     void VisitFunctionCall(FunctionCall *);
     void VisitFunctionCallFirst(FunctionCall *);
@@ -217,6 +381,7 @@ public:
     // Used to compare expressions in 'after or after_all' statements.
     void VisitExpectedExpression(ExpectedExpression *);
     void VisitMockupFunction(MockupFunction*);
+    void VisitGroupMockup(GlobalMockup *);
     void VisitVariableAssignment(VariableAssignment *);
     /// Generates an LLVM Function that calls a function, assigns a variable or
     /// checks an expected expression.
@@ -31,10 +31,13 @@
 
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <cstring>
 #include <map>
 #include "Visitor.h"
 #include "TestParser.h"
 #include "TestGeneratorVisitor.h"
+#include "TestReporter.h"
 
 using namespace std;
 using namespace tp;
@@ -42,7 +45,7 @@ using namespace tp;
 /**
  * Logs the results of the tests ran in standard output
  */
-class TestLoggerVisitor : public Visitor {
+class TestLoggerVisitor : public TestReporter {
 public:
     enum LogFormat {
         LOG_ALL = 1 << 0, // 1
@@ -57,9 +60,9 @@ public:
     };
 private:
     unsigned WIDTH; // The 'terminal' width
-    // Column Name and its width
-    map<ColumnName,unsigned> mColumnWidth;
-    map<ColumnName,string> mColumnName;
+    // Column Name and its width, indexed by ColumnName
+    unsigned mColumnWidth[MAX_COLUMN];
+    const char* mColumnName[MAX_COLUMN];
     vector<ColumnName> mOrder;
     string mPadding;
     unsigned mTestCount = 0;
@@ -67,6 +70,8 @@ private:
     unsigned mTestsFailed = 0;
     int mFmt = LOG_ALL;
     bool mCurrentTestPassed = false;
+    // The columns get wider as the tests print longer values
+    bool mAdaptive = true;
 
     void logFunctionOutput(LLVMFunctionHolder *FH, const string& name);
 public:
@@ -84,10 +89,12 @@ public:
         mColumnName[WARNING] = "WARNING";
         mColumnName[FUD_OUTPUT] = "FUNCTION OUTPUT";
         mColumnName[FAILED_EE] = "FAILED EXPECTED EXPRESSIONS";
+        mColumnName[FAILED_ROWS] = "FAILED ROWS";
+        mColumnName[BENCHMARK] = "BENCHMARK";
         /////////////////////////////////////////
 
-        for(auto& it : mColumnName)
-            mColumnWidth[it.first] = it.second.size();
+        for(unsigned column = 0; column < MAX_COLUMN; ++column)
+            mColumnWidth[column] = strlen(mColumnName[column]);
 
         // The order in which we will print the columns.
         // @todo load these ones dynamically
@@ -111,7 +118,8 @@ public:
         WIDTH += mPadding.size()*mOrder.size();// Add the padding for each column
     }
 
-    void VisitTestFileFirst(TestFile* TF)
+    /// Prints the names of the columns, before the first test runs.
+    void begin()
     {
         cout << left;
         cout << setw(WIDTH) << setfill('=') << '=' << setfill(' ') << endl;
@@ -121,7 +129,8 @@ public:
         cout << setw(WIDTH) << setfill('~') << '~' << setfill(' ') << endl;
     }
 
-    void VisitTestFile(TestFile* TF)
+    /// Prints the counters of all the tests logged so far.
+    void end()
     {
         assert(mTestCount == (mTestsPassed + mTestsFailed) && "Invalid test count");
         cout << setw(WIDTH) << setfill('~') << '~' << setfill(' ') << endl;
@@ -140,33 +149,44 @@ public:
         }
     }
 
-    void VisitTestDefinitionFirst(TestDefinition *TD) {
+    /// Prints the results of a test as soon as it ran, only the counters of
+    /// the summary are kept.
+    void testFinished(TestDefinition *TD, const TestResults& results,
+            double seconds) {
         // Print the columns in the given order, then print a new line and
 		// optionally print more information about the current test.
 		++mTestCount;
-		const map<ColumnName,string>& results = TD->getTestResults();
-		mCurrentTestPassed = (results.at(RESULT) == "PASSED")? true : false;
+		if(mAdaptive) {
+			// The columns known before running were measured already, only
+			// the actual results make a column wider from this test on.
+			bool wider = false;
+			for(auto column : mOrder) {
+				if(results.get(column).size() > mColumnWidth[column]) {
+					mColumnWidth[column] = results.get(column).size();
+					wider = true;
+				}
+			}
+			if(wider)
+				calculateTotalWidth();
+		}
+		mCurrentTestPassed = (results.get(RESULT) == "PASSED")? true : false;
         if(mCurrentTestPassed && (mFmt & (LOG_ALL | LOG_PASSING)) ){
         	++mTestsPassed;
             for(auto column : mOrder)
-            	cout << setw(mColumnWidth[column]) << results.at(column) << mPadding;
+            	cout << setw(mColumnWidth[column]) << results.get(column) << mPadding;
         }
         else if(mCurrentTestPassed==false && (mFmt & (LOG_ALL | LOG_FAILING)) ) {
         	++mTestsFailed;
             for(auto column : mOrder)
-            	cout << setw(mColumnWidth[column]) << results.at(column) << mPadding;
+            	cout << setw(mColumnWidth[column]) << results.get(column) << mPadding;
         }
         cout << endl;
-    }
 
-    void VisitTestDefinition(TestDefinition *TD) {
-    	const map<ColumnName,string>& results = TD->getTestResults();
-
-    	if(results.find(WARNING) != results.end())
-			cout << results.at(WARNING) << endl;
+    	if(results.has(WARNING))
+			cout << results.get(WARNING) << endl;
 
-		if(results.find(FUD_OUTPUT) != results.end()) {
-			string test_output = results.at(FUD_OUTPUT);
+		if(results.has(FUD_OUTPUT)) {
+			const string& test_output = results.get(FUD_OUTPUT);
 			if(!test_output.empty()) {
 				string fud = TD->getTestFunction()->getFunctionCall()->getFunctionCalledString();
 				stringstream ss;
@@ -177,8 +197,14 @@ public:
 			}
 		}
 
-		if(results.find(FAILED_EE) != results.end())
-			cout << results.at(FAILED_EE) << endl;
+		if(results.has(FAILED_EE))
+			cout << results.get(FAILED_EE) << endl;
+
+		if(results.has(FAILED_ROWS))
+			cout << results.get(FAILED_ROWS) << endl;
+
+		if(results.has(BENCHMARK))
+			cout << results.get(BENCHMARK) << endl;
 
 		cout << setw(WIDTH) << setfill('-') << '-' << setfill(' ') << endl;
     }
@@ -208,18 +234,31 @@ public:
 
     void setLogFormat(int fmt) { mFmt = fmt; }
 
+    /// Every column is width characters wide, or as wide as its name. Longer
+    /// values are printed whole and push the rest of their row.
+    void setFixedColumnWidth(unsigned width) {
+        mAdaptive = false;
+        for(unsigned column = 0; column < MAX_COLUMN; ++column)
+            mColumnWidth[column] = max<unsigned>(width, strlen(mColumnName[column]));
+        calculateTotalWidth();
+    }
+
     const vector<ColumnName>& getColumnOrder() { return mOrder; }
-    const map<ColumnName,unsigned>& getColumnWidths() { return mColumnWidth; }
-    const map<ColumnName,string>& getColumnNames() { return mColumnName; }
+    const unsigned* getColumnWidths() { return mColumnWidth; }
 
     unsigned getTestsFailed() const { return mTestsFailed; }
 
 };
 
+/**
+ * Fits the columns of the TestLoggerVisitor to the values known before the
+ * tests run, so the results can be printed as soon as each test finishes.
+ * Only the actual results may make a column wider later on.
+ */
 class OutputFixerVisitor : public Visitor {
     TestLoggerVisitor& mLogger;
     const vector<ColumnName>& mOrder;
-    const map<ColumnName,unsigned>& mColumnWidth;
+    const unsigned* mColumnWidth;
 public:
     OutputFixerVisitor() = delete;
     OutputFixerVisitor(const OutputFixerVisitor&) = delete;
@@ -231,8 +270,10 @@ public:
 
     void VisitTestDefinition(TestDefinition *TD) {
         for(auto column : mOrder) {
+            if(column == RESULT || column == ACTUAL_RESULT)
+                continue; // Not known until the test runs
             string str = TestResults::getColumnString(column, TD);
-            if(str.size() > mColumnWidth.at(column))
+            if(str.size() > mColumnWidth[column])
                 mLogger.setColumnWidth(column, str.size());
         }
     }
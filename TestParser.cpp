@@ -29,16 +29,19 @@
 #include "TestParser.h"
 #include <iostream>
 #include <exception>
+#include <cctype>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "llvm/Support/FileSystem.h"
 
 using namespace std;
 using namespace tp;
 
 int TestGroup::group_count = 0;
-string JCUTException::mExceptionSource;
-
-extern unsigned column;
-extern "C" int yylex();
+thread_local string JCUTException::mExceptionSource;
 
 
 UnexpectedToken::UnexpectedToken(tp::Token token, string expected)
@@ -50,7 +53,7 @@ UnexpectedToken::UnexpectedToken(tp::Token token, string expected)
 	if(mToken.mType == TOK_EOF)
 		ss << "End of file. ";
 	else
-		ss << mToken.mLexeme << ". ";
+		ss << mToken.mLexeme.str() << ". ";
 	if(!mExpected.empty())
 		ss << "Expecting a valid " << mExpected << ".";
 	mMsg = ss.str();
@@ -62,57 +65,73 @@ const char* UnexpectedToken::what() const throw () {
 }
 
 
-ostream& tp::operator << (ostream& os, Token& token)
+ostream& tp::operator << (ostream& os, const Token& token)
 {
-    os << token.mLine << ":" << token.mColumn << ": [" << token.mType << "] " << token.mLexeme;
+    os << token.mLine << ":" << token.mColumn << ": [" << token.mType << "] " << token.mLexeme.str();
     return os;
 }
 
 void Tokenizer::tokenize(const string& filename)
 {
-	mTokens.clear();
-
-	yyin = fopen( filename.c_str(), "r" );
-	if(yyin == nullptr)
+	unmap();
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd == -1)
 		throw JCUTException("Could not open file "+filename);
-	int type = TokenType::TOK_ERR;
-
-	while((type = yylex()) != TOK_EOF) {
-		mTokens.push_back(std::move(Token(yytext, yyleng, type, yylineno, column)));
+	struct stat st;
+	if(fstat(fd, &st) == -1) {
+		close(fd);
+		throw JCUTException("Could not read file "+filename);
 	}
-	fclose(yyin);
-
-	mTokens.push_back(std::move(Token(yytext, yyleng, type, yylineno, column+1)));
-	mNextToken = mTokens.begin();
+	if(st.st_size) {
+		void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(addr == MAP_FAILED) {
+			close(fd);
+			throw JCUTException("Could not map file "+filename+" in memory");
+		}
+		madvise(addr, st.st_size, MADV_SEQUENTIAL);
+		mMap = static_cast<const char*>(addr);
+		mMapSize = st.st_size;
+	}
+	// The mapping stays valid after closing the file
+	close(fd);
+	tokenize(mMap, mMapSize);
 }
 
 void Tokenizer::tokenize(const char* buffer)
 {
-	mTokens.clear();
-
-	YY_BUFFER_STATE state = yy_scan_string(buffer);
-
-	int type = TokenType::TOK_ERR;
-
-	while((type = yylex()) != TOK_EOF) {
-		mTokens.push_back(std::move(Token(yytext, yyleng, type, yylineno, column)));
-	}
+	mText = buffer;
+	tokenize(mText.data(), mText.size());
+}
 
-	mTokens.push_back(std::move(Token(yytext, yyleng, type, yylineno, column+1)));
-	mNextToken = mTokens.begin();
+void Tokenizer::tokenize(const char* buffer, size_t size)
+{
+	mScanner = Scanner(buffer, size);
+	mNext = scan();
+}
 
-	yy_delete_buffer(state);
+void Tokenizer::unmap()
+{
+	if(mMap)
+		munmap(const_cast<char*>(mMap), mMapSize);
+	mMap = nullptr;
+	mMapSize = 0;
 }
 
-Token Tokenizer::peekToken()
+Token Tokenizer::scan()
 {
-	return *mNextToken;
+	int type = mScanner.next();
+	if(type == TOK_EOF) // The end of file is one column past the last token
+		return Token(mScanner.text(), 0, type, mScanner.line(), mScanner.column()+1);
+	return Token(mScanner.text(), mScanner.length(), type,
+			mScanner.line(), mScanner.column());
 }
 
 Token Tokenizer::nextToken()
 {
-	Token next = *mNextToken;
-	mNextToken++;
+	Token next = mNext;
+	// Keep returning the end of file once it is reached
+	if(next.mType != TOK_EOF)
+		mNext = scan();
 	return next;
 }
 
@@ -121,7 +140,27 @@ Token Tokenizer::nextToken()
 // TestParser method definition
 //
 
-int TestExpr::leaks = 0;
+std::atomic<int> TestExpr::leaks(0);
+
+void* TestExpr::operator new(size_t size)
+{
+	// The first bytes of every node say which arena it came from, if any.
+	TestArena* arena = TestArena::getCurrent();
+	size += TestArena::Alignment;
+	char* ptr = static_cast<char*>(arena ? arena->allocate(size) : ::operator new(size));
+	*reinterpret_cast<TestArena**>(ptr) = arena;
+	return ptr + TestArena::Alignment;
+}
+
+void TestExpr::operator delete(void* ptr)
+{
+	if (ptr == nullptr)
+		return;
+	char* block = static_cast<char*>(ptr) - TestArena::Alignment;
+	if (*reinterpret_cast<TestArena**>(block) == nullptr)
+		::operator delete(block);
+	// Otherwise the memory goes back when the arena is destroyed
+}
 unsigned LLVMFunctionHolder::warning_count = 0;
 
 unique_ptr<DataPlaceholder> TestDriver::ParseDataPlaceholder()
@@ -129,9 +168,13 @@ unique_ptr<DataPlaceholder> TestDriver::ParseDataPlaceholder()
 	if (mCurrentToken != '@')
 		throw UnexpectedToken(mCurrentToken, "DataPlaceHolder '@'");
 
-	unique_ptr<DataPlaceholder> pl(new DataPlaceholder);
-	mCurrentToken = mTokenizer.nextToken();
-	return pl;
+	mCurrentToken = mTokenizer.nextToken(); // eat up the '@'
+	if (mCurrentToken == TOK_IDENTIFIER) { // @x
+		unique_ptr<DataPlaceholder> pl(new DataPlaceholder(mCurrentToken.mLexeme.str()));
+		mCurrentToken = mTokenizer.nextToken();
+		return pl;
+	}
+	return unique_ptr<DataPlaceholder>(new DataPlaceholder);
 }
 
 BufferAlloc* TestDriver::ParseBufferAlloc()
@@ -170,7 +213,7 @@ Identifier* TestDriver::ParseIdentifier()
 {
 	if (mCurrentToken != TOK_IDENTIFIER)
 		throw UnexpectedToken(mCurrentToken, "identifier");
-	Identifier * id = new Identifier(mCurrentToken.mLexeme);
+	Identifier * id = new Identifier(mCurrentToken.mLexeme.str());
 	mCurrentToken = mTokenizer.nextToken(); // eat current identifier
 	return id;
 }
@@ -359,7 +402,7 @@ ExpectedResult* TestDriver::ParseExpectedResult()
 ComparisonOperator* TestDriver::ParseComparisonOperator()
 {
 	if (mCurrentToken == TOK_COMPARISON_OP) {
-		ComparisonOperator* cmp = new ComparisonOperator(mCurrentToken.mLexeme);
+		ComparisonOperator* cmp = new ComparisonOperator(mCurrentToken.mLexeme.str());
 		mCurrentToken = mTokenizer.nextToken(); // consume TOK_COMPARISON_OP
 		return cmp;
 	}
@@ -378,7 +421,7 @@ ExpectedConstant* TestDriver::ParseExpectedConstant()
 StringConstant* TestDriver::ParseStringConstant()
 {
 	if(mCurrentToken == TOK_STRING) {
-		StringConstant* sc = new StringConstant(mCurrentToken.mLexeme);
+		StringConstant* sc = new StringConstant(mCurrentToken.mLexeme.str());
 		mCurrentToken = mTokenizer.nextToken(); // Consume the constant
 		return sc;
 	}
@@ -402,10 +445,10 @@ NumericConstant* TestDriver::ParseNumericConstant()
 		throw UnexpectedToken(mCurrentToken,"numeric constant (int or float)");
 	NumericConstant* nc = nullptr;
 	if (mCurrentToken == TOK_INT)
-		nc = new NumericConstant(atoi(mCurrentToken.mLexeme.c_str()));
+		nc = new NumericConstant(atoi(mCurrentToken.mLexeme.str().c_str()));
 	else
 	if(mCurrentToken == TOK_FLOAT)
-		nc = new NumericConstant((float)atof(mCurrentToken.mLexeme.c_str()));
+		nc = new NumericConstant((float)atof(mCurrentToken.mLexeme.str().c_str()));
 	mCurrentToken = mTokenizer.nextToken(); // Consume the constant
 	return nc;
 }
@@ -427,7 +470,7 @@ Constant* TestDriver::ParseConstant()
 	// This is a workaround for float and double values. Let LLVM do the work
 	// on what type of precision to choose, we will just pass a string representing
 	// the floating point value.
-	C->setString(token.mLexeme);
+	C->setString(token.mLexeme.str());
 
 	return C;
 }
@@ -560,6 +603,13 @@ MockupFunction* TestDriver::ParseMockupFunction()
 		Identifier* id = ParseIdentifier();
 		return new MockupFunction(func, id);
 	}
+	else if(mCurrentToken == '{') {
+		MockupSequence* seq = ParseMockupSequence();
+		return new MockupFunction(func, seq);
+	}
+	else if(mCurrentToken == '@') {
+		return new MockupFunction(func, ParseDataPlaceholder());
+	}
 	else {
 		Constant *expected_const = ParseConstant();
 		return new MockupFunction(func, expected_const);
@@ -567,6 +617,30 @@ MockupFunction* TestDriver::ParseMockupFunction()
 	return nullptr;
 }
 
+MockupSequence* TestDriver::ParseMockupSequence()
+{
+	if (mCurrentToken != '{')
+		throw UnexpectedToken(mCurrentToken,"left curly bracket '{' for mockup sequence");
+	mCurrentToken = mTokenizer.nextToken(); // eat the '{'
+
+	vector<Constant*> values;
+	try {
+		while(true) {
+			values.push_back(ParseConstant());
+			if (mCurrentToken == '}')
+				break;
+			if (mCurrentToken != ',')
+				throw UnexpectedToken(mCurrentToken,"comma ',' or right curly bracket '}' in mockup sequence");
+			mCurrentToken = mTokenizer.nextToken(); // eat the ','
+		}
+	} catch(...) {
+		for(auto*& ptr : values) delete ptr;
+		throw;
+	}
+	mCurrentToken = mTokenizer.nextToken(); // eat the '}'
+	return new MockupSequence(values);
+}
+
 MockupFixture* TestDriver::ParseMockupFixture()
 {
 	vector<MockupFunction*> MockupFunctions;
@@ -625,6 +699,22 @@ TestData* TestDriver::ParseTestData()
 
 	mCurrentToken = mTokenizer.nextToken(); // eat up the {
 
+	if (mCurrentToken == TOK_IDENTIFIER) { // range(); random();
+		vector<DataGenerator*> generators;
+		try {
+			while (mCurrentToken == TOK_IDENTIFIER)
+				generators.push_back(ParseDataGenerator());
+			if (mCurrentToken != '}')
+				throw UnexpectedToken(mCurrentToken,"right curly bracket '}'");
+		} catch (...) {
+			for(DataGenerator* ptr : generators)
+				delete ptr;
+			throw;
+		}
+		mCurrentToken = mTokenizer.nextToken(); // eat up the }
+		return new TestData(generators);
+	}
+
 	unique_ptr<StringConstant> name = unique_ptr<StringConstant>(ParseStringConstant());
 
 	if (mCurrentToken != ';')
@@ -640,15 +730,94 @@ TestData* TestDriver::ParseTestData()
 	return new TestData(move(name));
 }
 
-TestDefinition* TestDriver::ParseTestDefinition()
+DataGenerator* TestDriver::ParseDataGenerator()
+{
+	DataGenerator::Kind kind = DataGenerator::RANGE;
+	if (mCurrentToken == "range")
+		kind = DataGenerator::RANGE;
+	else
+	if (mCurrentToken == "random")
+		kind = DataGenerator::RANDOM;
+	else
+		throw UnexpectedToken(mCurrentToken, "data generator: range() or random()");
+	mCurrentToken = mTokenizer.nextToken(); // eat up the name
+
+	if (mCurrentToken != '(')
+		throw UnexpectedToken(mCurrentToken, "left parenthesis '('");
+	mCurrentToken = mTokenizer.nextToken(); // eat up the (
+
+	vector<string> args;
+	while (mCurrentToken == TOK_INT || mCurrentToken == TOK_FLOAT ||
+		   mCurrentToken == TOK_CHAR) {
+		args.push_back(mCurrentToken.mLexeme.str());
+		mCurrentToken = mTokenizer.nextToken(); // eat up the number
+		if (mCurrentToken != ',')
+			break;
+		mCurrentToken = mTokenizer.nextToken(); // eat up the ,
+	}
+
+	if (mCurrentToken != ')')
+		throw UnexpectedToken(mCurrentToken, "right parenthesis ')'");
+	mCurrentToken = mTokenizer.nextToken(); // eat up the )
+
+	if (mCurrentToken != ';')
+		throw UnexpectedToken(mCurrentToken,"semicolon ';'");
+	mCurrentToken = mTokenizer.nextToken(); // eat up the ;
+
+	return new DataGenerator(kind, args);
+}
+
+TestDefinition* TestDriver::ParseTestProperty()
 {
-	TestData *info = ParseTestData();
-	TestMockup *mockup = ParseTestMockup();
-	TestSetup *setup = ParseTestSetup();
-	TestFunction *testFunction = ParseTestFunction();
-	TestTeardown *teardown = ParseTestTearDown();
+	// 'property' is not a keyword, a function can still be called property()
+	if (!(mCurrentToken == "property") || mTokenizer.peekToken() != '{')
+		return nullptr;
+	mCurrentToken = mTokenizer.nextToken(); // eat up property
+	mCurrentToken = mTokenizer.nextToken(); // eat up the {
+
+	TestMockup *mockup = nullptr;
+	TestSetup *setup = nullptr;
+	TestFunction *testFunction = nullptr;
+	TestTeardown *teardown = nullptr;
+	try {
+		mockup = ParseTestMockup();
+		setup = ParseTestSetup();
+		testFunction = ParseTestFunction();
+		teardown = ParseTestTearDown();
+		if (mCurrentToken != '}')
+			throw UnexpectedToken(mCurrentToken,"right curly bracket '}' for this property");
+	} catch(...) {
+		delete mockup;
+		delete setup;
+		delete testFunction;
+		delete teardown;
+		throw;
+	}
+	mCurrentToken = mTokenizer.nextToken(); // eat up the }
 
-	return new TestDefinition(info, testFunction, setup, teardown, mockup);
+	TestDefinition* TD = new TestDefinition(nullptr, testFunction, setup, teardown, mockup);
+	TD->setProperty(true);
+	return TD;
+}
+
+TestDefinition* TestDriver::ParseTestDefinition()
+{
+	// The position where the test starts, the copies for the rows of its
+	// data file keep it.
+	int line = mCurrentToken.mLine;
+	int column = mCurrentToken.mColumn;
+	TestDefinition* TD = ParseTestProperty();
+	if (TD == nullptr) {
+		TestData *info = ParseTestData();
+		TestMockup *mockup = ParseTestMockup();
+		TestSetup *setup = ParseTestSetup();
+		TestFunction *testFunction = ParseTestFunction();
+		TestTeardown *teardown = ParseTestTearDown();
+		TD = new TestDefinition(info, testFunction, setup, teardown, mockup);
+	}
+	TD->setLine(line);
+	TD->setColumn(column);
+	return TD;
 }
 
 TestGroup* TestDriver::ParseTestGroup(Identifier* name)
@@ -796,42 +965,57 @@ TestExpr* TestDriver::ParseTestExpr()
 
 Identifier* TestDriver::groupNameFactory()
 {
-	static unsigned i = 0;
 	stringstream ss;
-	ss << "group_" << i;
-	i++;
+	ss << "group_" << mGroupCount++;
 	return new Identifier(ss.str());
 }
 
 // Definitions due to conflicts with the forward declarations
 FunctionCall::FunctionCall(Identifier* name, const vector<FunctionArgument*>& arg) :
-mFunctionName(name), mFunctionArguments(arg), mReturnType(nullptr)
+mFunctionName(name), mFunctionArguments(), mReturnType(nullptr)
 {
 	TestExpr::type = TestExpr::FUNC_CALL;
 	unsigned i = 0;
-	for (auto*& arg : mFunctionArguments) {
-		arg->setIndex(i);
+	for (FunctionArgument* ptr : arg) {
+		ptr->setIndex(i);
+		mFunctionArguments.push_back(shared_ptr<FunctionArgument>(ptr));
 		++i;
 	}
 }
 
-FunctionCall::~FunctionCall()
-{
-	for (FunctionArgument*& ptr : mFunctionArguments) {
-		delete ptr;
-		ptr = nullptr;
-	}
-}
-
 void FunctionCall::accept(Visitor *v)
 {
 	v->VisitFunctionCallFirst(this);
-	for (FunctionArgument*& ptr : mFunctionArguments) {
+	for (const shared_ptr<FunctionArgument>& ptr : mFunctionArguments) {
 		ptr->accept(v);
 	}
 	v->VisitFunctionCall(this);
 }
 
+bool TestGroup::hasTestsFrom(const string& source) const
+{
+	for (const TestExpr* ptr : mTests) {
+		if (ptr->getType() == TestExpr::TEST_GROUP &&
+			static_cast<const TestGroup*>(ptr)->hasTestsFrom(source))
+			return true;
+		if (ptr->getType() == TestExpr::TEST_DEFINITION &&
+			static_cast<const TestDefinition*>(ptr)->getSourceFile() == source)
+			return true;
+	}
+	return false;
+}
+
+bool TestGroup::isVisited(const TestExpr* test, const string& source)
+{
+	if (source.empty())
+		return true;
+	if (test->getType() == TestExpr::TEST_GROUP)
+		return static_cast<const TestGroup*>(test)->hasTestsFrom(source);
+	if (test->getType() == TestExpr::TEST_DEFINITION)
+		return static_cast<const TestDefinition*>(test)->getSourceFile() == source;
+	return true;
+}
+
 void InitializerValue::accept(Visitor *v) {
 	if (mNC) mNC->accept(v);
 	if (mStructValue) mStructValue->accept(v);
@@ -846,7 +1030,7 @@ string FunctionCall::getFunctionCalledString() {
 	// print a character and not a number, and when calling a function that
 	// receives a numeric constant or integral type we have to display number.
 	if(mFunctionArguments.size()) {
-		for(FunctionArgument* fa : mFunctionArguments)
+		for(const shared_ptr<FunctionArgument>& fa : mFunctionArguments)
 			called += fa->toString() + ", ";
 		called.pop_back();
 		called.pop_back();
@@ -855,9 +1039,26 @@ string FunctionCall::getFunctionCalledString() {
 	return called;
 }
 
+string FunctionCall::getFunctionCalledString(const vector<string>& values) {
+	string called = mFunctionName->toString() +"(";
+	unsigned i = 0;
+	if(mFunctionArguments.size()) {
+		for(const shared_ptr<FunctionArgument>& fa : mFunctionArguments) {
+			if(fa->isDataPlaceholder() && i < values.size())
+				called += values[i++] + ", ";
+			else
+				called += fa->toString() + ", ";
+		}
+		called.pop_back();
+		called.pop_back();
+	}
+	called += ")";
+	return called;
+}
+
 bool FunctionCall::hasDataPlaceholders() const
 {
-	for(auto a : mFunctionArguments)
+	for(const auto& a : mFunctionArguments)
 		if(a->isDataPlaceholder())
 			return true;
 	return false;
@@ -867,7 +1068,7 @@ vector<unsigned> FunctionCall::getDataPlaceholdersPos() const
 {
 	vector<unsigned> positions;
 	unsigned i = 0;
-	for(auto p : mFunctionArguments) {
+	for(const auto& p : mFunctionArguments) {
 		if(p->isDataPlaceholder())
 			positions.push_back(i);
 		++i;
@@ -875,16 +1076,18 @@ vector<unsigned> FunctionCall::getDataPlaceholdersPos() const
 	return positions;
 }
 
+vector<const DataPlaceholder*> FunctionCall::getDataPlaceholders() const
+{
+	vector<const DataPlaceholder*> placeholders;
+	for(const auto& p : mFunctionArguments)
+		if(p->isDataPlaceholder())
+			placeholders.push_back(p->getDataPlaceholder());
+	return placeholders;
+}
+
 FunctionCall::FunctionCall(const FunctionCall& that)
-: TestExpr(that), mFunctionName(nullptr), mFunctionArguments(),
-  mReturnType(nullptr) {
-	if (that.mFunctionName)
-		mFunctionName = unique_ptr<Identifier>(
-				new Identifier(*that.mFunctionName));
-	for(FunctionArgument* fa : that.mFunctionArguments) {
-		FunctionArgument* copy = new FunctionArgument(*fa);
-		mFunctionArguments.push_back(copy);
-	}
+: TestExpr(that), mFunctionName(that.mFunctionName),
+  mFunctionArguments(that.mFunctionArguments), mReturnType(nullptr) {
 }
 
 bool FunctionCall::replaceDataPlaceholder(unsigned pos, FunctionArgument* new_arg) {
@@ -894,11 +1097,9 @@ bool FunctionCall::replaceDataPlaceholder(unsigned pos, FunctionArgument* new_ar
 	if(mFunctionArguments[pos]->isDataPlaceholder() == false)
 		assert(false && "This is not a DataPlaceholder!");
 
-	FunctionArgument* to_delete = mFunctionArguments[pos];
-	new_arg->setIndex(to_delete->getIndex());
-	mFunctionArguments[pos] = new_arg;
-	delete to_delete;
-	to_delete = nullptr;
+	// Only this copy stops using the DataPlaceholder
+	new_arg->setIndex(mFunctionArguments[pos]->getIndex());
+	mFunctionArguments[pos] = shared_ptr<FunctionArgument>(new_arg);
 	return true;
 }
 
@@ -912,86 +1113,267 @@ InitializerValue::InitializerValue(const InitializerValue& that)
 }
 
 ///////
-// CSVDriver
-CSVDriver::CSVDriver(const string& filename) : TestDriver(), rows(0), columns(0)
-{
-	ifstream csv(filename);
-	if(!csv)
-		throw JCUTException("CSV File: "+filename+" not found!");
-	string line;
-	getline(csv, line);
-	vector<string> items = split(line,',');
-	columns = items.size();
-	mMatrix.push_back(items);
-
-	while(getline(csv, line)) {
-		items = split(line, ',');
-		if(items.empty()) continue;
-		if(items.size() != columns)
-			throw JCUTException("Column mismatch in CSV file: "+filename);
-
-		mMatrix.push_back(items);
+// DataGenerator
+const uint64_t DataGenerator::HashIncrement;
+const uint64_t DataGenerator::HashMultiplier1;
+const uint64_t DataGenerator::HashMultiplier2;
+
+DataGenerator::DataGenerator(Kind kind, const vector<string>& args)
+: mKind(kind), mIsFloat(false), mInts(), mFloats(), mSeed(0), mCount(0), mStr(),
+  mArgs(args)
+{
+	mStr = (kind == RANGE) ? "range(" : "random(";
+	for(unsigned i = 0; i < args.size(); ++i)
+		mStr += (i ? ", " : "") + args[i];
+	mStr += ")";
+
+	vector<string> numbers(args);
+	if(kind == RANGE && args.size() != 2 && args.size() != 3)
+		throw JCUTException("Invalid data generator "+mStr+
+				", use range(first, last) or range(first, last, step)");
+	if(kind == RANDOM) {
+		int64_t seed = 0, count = 0;
+		if(args.size() != 4 || !CSVReader::parseInt(args[0], seed) ||
+		   !CSVReader::parseInt(args[1], count) || count <= 0)
+			throw JCUTException("Invalid data generator "+mStr+
+					", use random(seed, count, min, max)");
+		mSeed = seed;
+		mCount = count;
+		numbers.erase(numbers.begin(), numbers.begin()+2);
 	}
-	rows = mMatrix.size();
-}
-
-vector<string> CSVDriver::split(string line, char split_char)
-{
-	vector<string> splitted;
-	string item;
-	bool struct_init = false;
-	for(auto c : line) {
-		// quick workaround to detect commas inside a struct
-		// initialization and ignore them
-		if(c == '{')
-			struct_init = true;
-		if(c == '}')
-			struct_init = false;
-		if(c == split_char && !struct_init) {
-			if(item.size())
-				splitted.push_back(item);
-			item = "";
-			continue;
+
+	// The values are floating point if any of the numbers is
+	int64_t value = 0;
+	for(const string& number : numbers)
+		if(!CSVReader::parseInt(number, value))
+			mIsFloat = true;
+	mInts[2] = 1;
+	mFloats[2] = 1;
+	for(unsigned i = 0; i < numbers.size(); ++i) {
+		if(mIsFloat) {
+			if(!CSVReader::parseFloat(numbers[i], mFloats[i])) {
+				if(!CSVReader::parseInt(numbers[i], mInts[i]))
+					throw JCUTException("Invalid number "+numbers[i]+" in "+mStr);
+				mFloats[i] = mInts[i];
+			}
+		} else {
+			CSVReader::parseInt(numbers[i], mInts[i]);
+			mFloats[i] = mInts[i];
 		}
-		item += c;
 	}
-	if(item.size())
-		splitted.push_back(item);
-	return splitted;
+
+	if(kind == RANGE) {
+		if(mFloats[2] == 0)
+			throw JCUTException("The step of "+mStr+" can not be 0");
+		if((mFloats[1] - mFloats[0]) / mFloats[2] < 0)
+			throw JCUTException(mStr+" never reaches its last value");
+		if(mIsFloat)
+			// Tolerate the rounding of the step: range(0, 1, 0.1) has 11 values
+			mCount = static_cast<uint64_t>((mFloats[1] - mFloats[0]) / mFloats[2] + 1e-9) + 1;
+		else
+			mCount = static_cast<uint64_t>((mInts[1] - mInts[0]) / mInts[2]) + 1;
+	} else if(mFloats[1] < mFloats[0])
+		throw JCUTException("The minimum value of "+mStr+" is greater than its maximum");
+}
+
+uint64_t DataGenerator::hash(uint64_t seed, uint64_t i)
+{
+	uint64_t z = seed + (i + 1) * HashIncrement;
+	z = (z ^ (z >> 30)) * HashMultiplier1;
+	z = (z ^ (z >> 27)) * HashMultiplier2;
+	return z ^ (z >> 31);
+}
+
+int64_t DataGenerator::getIntAt(uint64_t i) const
+{
+	if(mKind == RANGE)
+		return mInts[0] + static_cast<int64_t>(i) * mInts[2];
+	// 0 when min and max cover all the 64 bits values
+	uint64_t span = static_cast<uint64_t>(mInts[1] - mInts[0]) + 1;
+	uint64_t h = hash(mSeed, i);
+	return mInts[0] + static_cast<int64_t>(span ? h % span : h);
+}
+
+double DataGenerator::getFloatAt(uint64_t i) const
+{
+	if(mKind == RANGE)
+		return static_cast<double>(i) * mFloats[2] + mFloats[0];
+	// The upper 53 bits of the hash as a double in [0, 1)
+	double unit = static_cast<double>(hash(mSeed, i) >> 11) * (1.0 / 9007199254740992.0);
+	return unit * (mFloats[1] - mFloats[0]) + mFloats[0];
+}
+
+string DataGenerator::valueToString(uint64_t i) const
+{
+	stringstream ss;
+	if(mIsFloat)
+		ss << getFloatAt(i);
+	else
+		ss << getIntAt(i);
+	return ss.str();
+}
+
+///////
+// DataTable
+DataTable::DataTable(const string& desc, const vector<DataGenerator*>& generators)
+: mPath(desc), mColumns(generators.size()), mRows(1), mFailedRowCount(0),
+  mFailedRows(), mFile(nullptr), mIsProperty(false)
+{
+	for(unsigned j = generators.size(); j-- > 0; ) {
+		mColumns[j].mGenerator = generators[j];
+		mColumns[j].mStride = mRows;
+		if(generators[j]->count() > MaxGeneratedRows / mRows)
+			throw JCUTException("The data generators "+desc+" produce too many rows");
+		mRows *= generators[j]->count();
+	}
+}
+
+DataTable::DataTable(const vector<string>& names, const vector<unsigned>& placeholder_columns)
+: mPath("property"), mColumns(names.size()), mRows(0), mFailedRowCount(0),
+  mFailedRows(), mFile(nullptr), mPlaceholderColumns(placeholder_columns),
+  mInputs(names.size(), 0), mIsProperty(true)
+{
+	for(unsigned j = 0; j < names.size(); ++j) {
+		mColumns[j].mIsInput = true;
+		mColumns[j].mName = names[j];
+	}
+}
+
+///////
+// CSVDriver
+CSVDriver::CSVDriver(const string& filename) : TestDriver(), mReader(filename),
+	mColumns(0), mRow()
+{
+	// The first row tells how many columns the file has
+	if(mReader.nextRow(mRow))
+		mColumns = mReader.columnCount();
+	rewind();
+}
+
+bool CSVDriver::nextRow()
+{
+	return mReader.nextRow(mRow);
+}
+
+void CSVDriver::rewind()
+{
+	mReader.rewind();
+	mRow.clear();
 }
 
 unsigned CSVDriver::columnCount()
 {
-	return columns;
+	return mColumns;
 }
 
-unsigned CSVDriver::rowCount()
+Constant* CSVDriver::parseConstant(llvm::StringRef cell)
 {
-	return rows;
+	Constant* C = nullptr;
+	char first = cell.front();
+	char c = 0;
+	if(CSVReader::parseChar(cell, c)) {
+		C = new Constant(new CharConstant(c));
+	} else if(isdigit(first) || first == '-' || first == '.') {
+		// The code is generated from the text of the constant, for the
+		// width of the parameter it is passed to. The NumericConstant only
+		// holds an int or a float, like the ones of the test files.
+		int64_t i = 0;
+		double d = 0;
+		if(CSVReader::parseInt(cell, i))
+			C = new Constant(new NumericConstant(static_cast<int>(i)));
+		else if(CSVReader::isInteger(cell)) {
+			stringstream ss;
+			ss << "CSV File: " << mReader.getPath() << ":" << mReader.lineNumber()
+			   << ": The value " << cell.str() << " does not fit in 64 bits";
+			throw JCUTException(ss.str());
+		}
+		else if(CSVReader::parseFloat(cell, d))
+			C = new Constant(new NumericConstant(static_cast<float>(d)));
+	}
+	// Same as TestDriver::ParseConstant(), keep the original text
+	if(C)
+		C->setString(cell.str());
+	return C;
 }
 
-FunctionArgument* CSVDriver::getFunctionArgumentAt(unsigned i, unsigned j)
+void CSVDriver::tokenize(llvm::StringRef cell)
 {
-	string str = mMatrix[i][j];
-	mTokenizer.tokenize(str.c_str());
+	// The cell points inside the mapped CSV file, it outlives the tokens
+	mTokenizer.tokenize(cell.data(), cell.size());
 	mCurrentToken = mTokenizer.nextToken();
 	if(mCurrentToken == '@')
 		assert(false && "DataPlaceholders not supported in CVS file.");
+}
 
+FunctionArgument* CSVDriver::getFunctionArgumentAt(unsigned j)
+{
+	if(Constant* C = parseConstant(mRow[j]))
+		return new FunctionArgument(C);
+	tokenize(mRow[j]);
 	return ParseFunctionArgument();
 }
 
-ExpectedConstant* CSVDriver::getExpectedConstantAt(unsigned i, unsigned j)
+ExpectedConstant* CSVDriver::getExpectedConstantAt(unsigned j)
 {
-	string str = mMatrix[i][j];
-	mTokenizer.tokenize(str.c_str());
-	mCurrentToken = mTokenizer.nextToken();
-	if(mCurrentToken == '@')
-			assert(false && "DataPlaceholders not supported in CVS file.");
+	if(Constant* C = parseConstant(mRow[j]))
+		return new ExpectedConstant(C);
+	tokenize(mRow[j]);
 	return ParseExpectedConstant();
 }
 
+MockupSequence* CSVDriver::getMockupSequenceAt(unsigned j)
+{
+	vector<Constant*> value;
+	if(Constant* C = parseConstant(mRow[j])) {
+		value.push_back(C);
+		return new MockupSequence(value);
+	}
+	tokenize(mRow[j]);
+	if(mCurrentToken == '{')
+		return ParseMockupSequence();
+	value.push_back(ParseConstant());
+	return new MockupSequence(value);
+}
+
 ///////////////////
+void TestResults::reset(tp::TestDefinition* TD)
+{
+	mTD = TD;
+	mSet = 0;
+	// clear() keeps the memory of the strings for the next test
+	for(string& column : mColumns)
+		column.clear();
+}
+
+bool TestResults::isLazy(ColumnName column) const
+{
+	switch(column) {
+		case GROUP_NAME:
+		case TEST_NAME:
+		case FUD:
+		case EXPECTED_RES:
+			return true;
+		case ACTUAL_RESULT:
+			return !using_fork;
+		default:
+			return false;
+	}
+}
+
+bool TestResults::has(ColumnName column) const
+{
+	return (mSet & (1u << column)) || isLazy(column);
+}
+
+const string& TestResults::get(ColumnName column) const
+{
+	if(!(mSet & (1u << column)) && isLazy(column)) {
+		mColumns[column] = getColumnString(column, mTD);
+		mSet |= 1u << column;
+	}
+	return mColumns[column];
+}
+
 void TestResults::saveToDisk() {
 	if(!using_fork)
 		return;
@@ -1000,118 +1382,105 @@ void TestResults::saveToDisk() {
 		throw JCUTException("Invalid pipe for WRITING results!");
 	close(mPipe[PREAD]); // Child writes, never reads
 
-	stringstream ss;
-	for(auto it = mResults.begin(); it != mResults.end(); ++it) {
-		ss << "[" << mColumnNames[it->first] << "]" << endl;
-		ss << it->second << endl;
+	string data = serialize();
+	size_t written = 0;
+	while(written < data.size()) {
+		ssize_t rc = write(mPipe[PWRITE], data.data() + written, data.size() - written);
+		if(rc == -1)
+			throw JCUTException("Error while sending data to the parent process");
+		written += rc;
 	}
-
-	string data = ss.str();
-	data += '\0';
-	int rc = write(mPipe[PWRITE], data.c_str(), static_cast<size_t>(data.size()));
-	if(rc == -1)
-		throw JCUTException("Error while sending data to the parent process");
-	if(rc == 0)
-		cout << "Warning: no data was sent to the parent process";
 	close(mPipe[PWRITE]); /* Reader will see EOF */
 }
 
-ColumnName TestResults::getColumnFromStr(const string& str)
-{
-	ColumnName col = MAX_COLUMN;
-	for(auto it = mColumnNames.begin(); it != mColumnNames.end(); ++it) {
-		if(str == it->second) {
-			col = it->first;
-			break;
-		}
-	}
-	return col;
-}
-
-map<ColumnName, string> TestResults::readFromDisk()
+void TestResults::readFromDisk()
 {
 	if(!using_fork)
-		return mResults;
+		return;
 
 	if(mPipe[PREAD] == 0)
 		throw JCUTException("Invalid pipe for READING results!");
 	close(mPipe[PWRITE]); // Parent reads, never writes
 
-	map<ColumnName, string> results;
-	string line;
-
-	ColumnName current;
-	const int SIZE = 1024;
+	string data;
+	const int SIZE = 4096;
 	char buf[SIZE];
-	int bytes_read = 0;
-	int total = 0;
-	stringstream ss;
-	while((bytes_read = read(mPipe[PREAD],buf, SIZE)) > 0) {
-		ss << buf;
-		memset(buf, 0, SIZE);
-		total += bytes_read;
-	}
+	ssize_t bytes_read = 0;
+	while((bytes_read = read(mPipe[PREAD], buf, SIZE)) > 0)
+		data.append(buf, bytes_read);
+	close(mPipe[PREAD]);
 
-	if (total == 0)
+	if (data.empty())
 		throw JCUTException("The test crashed during execution!");
+	deserialize(data);
+}
 
-	while(!ss.eof()) {
-		std::getline(ss, line);
-		if(line.empty())
-			continue;
-
-		if(line[0] == '[') {
-			string column_name = line.substr(1,line.size()-2);
-			current = getColumnFromStr(column_name);
-			results[current] = "";
+string TestResults::serialize() const
+{
+	// For every column with a value: its number, its size and its text
+	string data;
+	for(unsigned column = 0; column < MAX_COLUMN; ++column) {
+		if(!(mSet & (1u << column)))
 			continue;
-		}
-
-		if(current == WARNING or current == FUD_OUTPUT or current == FAILED_EE)
-			results[current] += "\n"+line;
-		else
-			results[current] += line;
+		uint32_t header[2] = { column, uint32_t(mColumns[column].size()) };
+		data.append(reinterpret_cast<const char*>(header), sizeof(header));
+		data += mColumns[column];
 	}
-
-	close(mPipe[PREAD]);
-	return results;
+	return data;
 }
 
-void TestResults::collectTestResults(tp::TestDefinition* TD)
+void TestResults::deserialize(const string& data)
 {
-	for(auto column : mOrder) {
-		stringstream ss;
-		mResults[column] = "";
-		ss << getColumnString(column, TD);
-		mResults[column] = ss.str();
+	size_t pos = 0;
+	uint32_t header[2];
+	while(pos + sizeof(header) <= data.size()) {
+		memcpy(header, data.data() + pos, sizeof(header));
+		pos += sizeof(header);
+		if(header[0] >= MAX_COLUMN || header[1] > data.size() - pos)
+			throw JCUTException("Invalid results received from the test process");
+		set(static_cast<ColumnName>(header[0]), data.substr(pos, header[1]));
+		pos += header[1];
 	}
+}
+
+void TestResults::collectTestResults()
+{
+	tp::TestDefinition* TD = mTD;
+	set(RESULT, getColumnString(RESULT, TD));
+	// The return value is gone once the child process exits
+	if(using_fork)
+		set(ACTUAL_RESULT, getColumnString(ACTUAL_RESULT, TD));
 	// Save warnings
 	const vector<Warning>& warnings = TD->getWarnings();
 	if(warnings.size()) {
 		stringstream ss;
 		for(auto w : warnings)
 			ss <<  w.what() << endl;
-		mResults[WARNING] = ss.str();
+		set(WARNING, ss.str());
 	}
 	// Save function under test output
-	if(TD->getOutput().size()) {
-		stringstream ss;
-		ss << TD->getOutput();
-		mResults[FUD_OUTPUT] = ss.str();
-	}
+	if(TD->getOutput().size())
+		set(FUD_OUTPUT, TD->getOutput());
 	// Save Failed expected expressions
 	if(TD->testPassed() == false) {
 		const vector<ExpectedExpression*>&
 		ee = TD->getFailedExpectedExpressions();
+		stringstream ss;
 		for(ExpectedExpression* e : ee) {
-			stringstream ss;
 			ss << JCUTException::mExceptionSource << ":" << e->getLine()
 				<< ":" << e->getColumn() << ": ";
 			ss << "Expected expression ["
 				 << e->toString() << "] is false" << endl;
-			mResults[FAILED_EE] += ss.str();
 		}
+		if(ee.size())
+			set(FAILED_EE, ss.str());
 	}
+	// Save the failing rows of a data loop test
+	DataTable* table = TD->getDataTable();
+	if(table && table->getFailedRows().size())
+		set(FAILED_ROWS, table->getFailedRows());
+	if(TD->getBenchmark().size())
+		set(BENCHMARK, TD->getBenchmark());
 }
 
 string TestResults::getColumnString(ColumnName name, tp::TestDefinition *TD)
@@ -1131,6 +1500,19 @@ string TestResults::getColumnString(ColumnName name, tp::TestDefinition *TD)
 			return (passed?"PASSED" : "FAILED");
 		}
 		case ACTUAL_RESULT:
+			if(DataTable* table = TD->getDataTable()) {
+				stringstream ss;
+				if(table->isProperty()) {
+					if(table->getFailedRowCount())
+						ss << "falsified after " << table->rowCount() << " runs";
+					else
+						ss << table->rowCount() << " runs passed";
+					return ss.str();
+				}
+				ss << (table->rowCount() - table->getFailedRowCount()) << "/"
+				   << table->rowCount() << " rows passed";
+				return ss.str();
+			}
 			return getActualResultString(TD);
 		case EXPECTED_RES:
 			return getExpectedResultString(TD);
@@ -1184,19 +1566,17 @@ string TestResults::getActualResultString(TestDefinition *TD)
 string  TestResults::getExpectedResultString(TestDefinition *TD)
 {
 	ExpectedResult* ER = TD->getTestFunction()->getExpectedResult();
+	if (ER && ER->isDataPlaceholder())
+		return ER->getComparisonOperator()->toString() + " " +
+				ER->getExpectedConstant()->toString();
 	if (ER) {
 		stringstream ss;
 		const Constant* C = ER->getExpectedConstant()->getConstant();
 		ss << ER->getComparisonOperator()->toString() << " ";
 		switch(C->getType()){
 			case Constant::Type::NUMERIC:
-			{
-				const NumericConstant* nc = C->getNumericConstant();
-				if(nc->isFloat())
-					ss << nc->getFloat();
-				if(nc->isInt())
-					ss << nc->getInt();
-			}
+				// The text, an int or a float would truncate wider values
+				ss << C->toString();
 				break;
 			case Constant::Type::STRING:
 			{
@@ -34,8 +34,14 @@
 #include <sstream>
 #include <vector>
 #include <iostream>
+#include <cstdint>
+#include <memory>
+#include <atomic>
 
 #include "JCUTScanner.h"
+#include "CSVReader.h"
+#include "JCBFile.h"
+#include "TestArena.h"
 
 #include "Visitor.h"
 
@@ -43,6 +49,7 @@
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/GlobalVariable.h"
 
 using namespace std;
 
@@ -57,29 +64,87 @@ enum ColumnName {
 	WARNING,
 	FUD_OUTPUT,
 	FAILED_EE, // Failed Expected Expressions
+	FAILED_ROWS, // Failed rows of a test run in data loop mode
+	BENCHMARK, // Nanoseconds per call of a test run with --bench
 	MAX_COLUMN
 };
 
 
-struct TestResults {
+/// Result written by the driver function the TestGeneratorVisitor creates for
+/// each test. The driver runs the mockups, the test, its result function and
+/// every ExpectedExpression in a single native call.
+/// @note Keep it in sync with TestGeneratorVisitor::getTestDriverResultType()
+struct TestDriverResult {
+	int8_t passed;
+	uint64_t failed_ee_mask; // Bit i set means ExpectedExpression i failed
+	uint64_t int_value;
+	double fp_value;
+	void* ptr_value;
+	// Only used by tests run in data loop mode (--data-loop)
+	uint64_t row_begin; // First row to be run
+	uint64_t row_end; // One past the last row to be run
+	uint8_t* failed_rows; // One bit per row from row_begin, set when the row fails
+	uint64_t failed_row_count;
+};
+
+/// The results of one test, a string per column. The TestRunnerVisitor uses
+/// the same record for all its tests, the strings keep their memory from one
+/// test to the next.
+///
+/// The columns that do not depend on running the test (group, test name,
+/// function called and expected result) are only formatted when a reporter
+/// asks for them. The actual result too, unless the test ran in a child
+/// process: its return value only exists there.
+class TestResults {
+public:
 	enum { PREAD = 0, PWRITE = 1};
-	vector<ColumnName> mOrder;
 	bool using_fork;
-	map<ColumnName, string> mResults;
-	map<ColumnName, string> mColumnNames;
 	string mTmpFileName;
 	int mPipe[2];
-	TestResults(const vector<ColumnName>& o) : mOrder(o), using_fork(false){
+
+	TestResults() : using_fork(false), mTmpFileName(), mTD(nullptr), mSet(0) {
 		mPipe[PREAD] = 0;
 		mPipe[PWRITE] = 0;
 	}
-	void collectTestResults(tp::TestDefinition* TD);
+	TestResults(const TestResults&) = delete;
+	TestResults& operator=(const TestResults&) = delete;
+
+	/// Starts the record of a new test
+	void reset(tp::TestDefinition* TD);
+	/// Stores the columns known once the test ran
+	void collectTestResults();
+	/// Sends the columns the child process collected to the parent
 	void saveToDisk();
-	map<ColumnName, string> readFromDisk();
-	ColumnName getColumnFromStr(const string& str);
+	/// Receives the columns collected by the child process
+	void readFromDisk();
+	/// The columns with a value, as they are sent to the parent process or
+	/// by a jcut --worker
+	string serialize() const;
+	/// Adds the columns of serialize(), throws a JCUTException when data is
+	/// not valid
+	void deserialize(const string& data);
+
+	/// Whether the column has a value, optional columns like the output of
+	/// the function only have one when it is not empty.
+	bool has(ColumnName column) const;
+	/// The value of the column, an empty string when it has none
+	const string& get(ColumnName column) const;
+
 	static string getColumnString(ColumnName name, tp::TestDefinition *TD);
 	static string getActualResultString(tp::TestDefinition *TD);
 	static string getExpectedResultString(tp::TestDefinition *TD);
+private:
+	tp::TestDefinition* mTD;
+	// Indexed by ColumnName, formatted on demand by get()
+	mutable string mColumns[MAX_COLUMN];
+	// One bit per column with a value
+	mutable uint32_t mSet;
+
+	bool isLazy(ColumnName column) const;
+	void set(ColumnName column, const string& value) {
+		mColumns[column] = value;
+		mSet |= 1u << column;
+	}
 };
 
 class JCUTException : public std::exception {
@@ -99,7 +164,8 @@ public:
         return mMsg.c_str();
     }
 
-    static string mExceptionSource;
+    /// Every thread parsing a test file has its own
+    static thread_local string mExceptionSource;
 protected:
     string mMsg;
 
@@ -164,47 +230,61 @@ namespace tp { // tp stands for test parser
 
 class Token {
 public:
-    Token() : mType(TOK_ERR), mLine(0), mColumn(0), mLexeme("") {}
-    Token(char* lex, int size, int type, unsigned line, unsigned column) :
+    Token() : mType(TOK_ERR), mLine(0), mColumn(0), mLexeme() {}
+    Token(const char* lex, int size, int type, unsigned line, unsigned column) :
     mType(static_cast<TokenType>(type)), mLine(line), mColumn(column), mLexeme(lex,size) {}
-    Token(const Token& that) : mType(that.mType), mLine(that.mLine),
-    		mColumn(that.mColumn), mLexeme(that.mLexeme) {}
 
-    bool operator ==(const string& s) {
+    bool operator ==(llvm::StringRef s) const {
 		return mLexeme == s;
 	}
-    bool operator ==(char c) {
-        string s(1,c);
-        return mLexeme == s;
+    bool operator ==(char c) const {
+        return mLexeme.size() == 1 && mLexeme[0] == c;
     }
-    bool operator !=(char c) {
-        string s(1,c);
-        return mLexeme != s;
+    bool operator !=(char c) const {
+        return !(*this == c);
     }
-    bool operator ==(TokenType type) { return mType == type; }
-    bool operator !=(TokenType type) { return mType != type; }
+    bool operator ==(TokenType type) const { return mType == type; }
+    bool operator !=(TokenType type) const { return mType != type; }
 
     TokenType    mType;
     unsigned mLine, mColumn;
-    string  mLexeme;
+    // Points inside the text given to the Tokenizer, it is valid as long as
+    // the Tokenizer that returned the token.
+    llvm::StringRef  mLexeme;
 };
 
-ostream& operator << (ostream& os, Token& token);
+ostream& operator << (ostream& os, const Token& token);
 
+/// Returns the tokens of a test file one by one as the parser asks for them,
+/// only the next token is kept. The test file is mapped in memory and the
+/// lexemes of the tokens point inside the mapping.
 class Tokenizer {
 public:
-	Tokenizer() : mTokens(), mNextToken(nullptr) {}
-
-    ~Tokenizer() {}
+	Tokenizer() : mScanner(nullptr, 0), mNext(), mText(), mMap(nullptr),
+		mMapSize(0) {}
+	Tokenizer(const Tokenizer&) = delete;
+	Tokenizer& operator=(const Tokenizer&) = delete;
+    ~Tokenizer() { unmap(); }
 
     void tokenize(const string& filename);
+    /// buffer is copied
     void tokenize(const char* buffer);
+    /// buffer is not copied, it has to outlive the tokens
+    void tokenize(const char* buffer, size_t size);
 
     Token nextToken();
-    Token peekToken();
+    const Token& peekToken() const { return mNext; }
 private:
-    vector<Token>   mTokens;
-    vector<Token>::iterator mNextToken;
+    Scanner mScanner;
+    // One token of lookahead
+    Token mNext;
+    // The copy of a buffer given as a C string
+    string mText;
+    const char* mMap;
+    size_t mMapSize;
+
+    Token scan();
+    void unmap();
 };
 
 class TestExpr {
@@ -213,17 +293,24 @@ public:
 		OTHER = 0,
 		FUNC_CALL,
 		VAR_ASSIGN,
-		EXPECT_EXPR
+		EXPECT_EXPR,
+		TEST_DEFINITION,
+		TEST_GROUP
 	};
     TestExpr() : line(0), column(0), type(OTHER) { ++leaks; }
     TestExpr(const TestExpr& that)
-    : line(that.line), column(that.column), type(that.type) {}
+    : line(that.line), column(that.column), type(that.type) { ++leaks; }
+
+    /// Nodes come from the current TestArena, if there is one.
+    static void* operator new(size_t size);
+    /// Does nothing for the nodes of an arena, it frees all of them at once.
+    static void operator delete(void* ptr);
 
     virtual void accept(Visitor *) = 0;
 
     virtual ~TestExpr() {--leaks;}
 
-    static int leaks;
+    static std::atomic<int> leaks;
 
     // The line and column where this expression start.
     // Due to time constraints only a few subclasses will set these values.
@@ -241,10 +328,21 @@ protected:
 };
 
 class DataPlaceholder : public TestExpr {
+private:
+	// Named placeholders (@x) are the inputs of a property, all the
+	// placeholders with the same name get the same value.
+	string mName;
 public:
+	DataPlaceholder() : mName() {}
+	explicit DataPlaceholder(const string& name) : mName(name) {}
+
 	void accept(Visitor *v) {
 		//@ note For the moment we don't need to VisitDataplaceholder
 	}
+
+	bool hasName() const { return !mName.empty(); }
+	const string& getName() const { return mName; }
+	string toString() const { return "@" + mName; }
 };
 
 class ComparisonOperator : public TestExpr {
@@ -380,15 +478,10 @@ public:
     }
     Constant(const Constant& that)
     : TestExpr(that), mNC(nullptr), mSC(nullptr), mCC(nullptr), mType(INVALID) {
-    	if(that.mNC) {
-    		mNC = unique_ptr<NumericConstant>(new NumericConstant(*that.mNC));
-    		stringstream ss;
-    		if(mNC->isInt())
-				ss << mNC->getInt();
-			if(mNC->isFloat())
-				ss << mNC->getFloat();
-			mStr = ss.str();
-    	}
+    	// The text keeps the width and the precision of the constant, the
+    	// code is generated from it.
+    	mStr = that.mStr;
+    	if(that.mNC) mNC = unique_ptr<NumericConstant>(new NumericConstant(*that.mNC));
     	if(that.mSC) mSC = unique_ptr<StringConstant>(new StringConstant(*that.mSC));
     	if(that.mCC) mCC = unique_ptr<CharConstant>(new CharConstant(*that.mCC));
     	mType = that.mType;
@@ -500,8 +593,11 @@ public:
     }
 
     bool isDataPlaceholder() const { return mDP.get() != nullptr; }
+    const DataPlaceholder* getDataPlaceholder() const { return mDP.get(); }
 
     const Constant* getConstant() const { return mC.get(); }
+
+    string toString() const { return mC ? mC->toString() : mDP->toString(); }
 };
 
 class StructInitializer;
@@ -623,8 +719,10 @@ class FunctionArgument;
 
 class FunctionCall : public TestExpr {
 private:
-    unique_ptr<Identifier> mFunctionName;
-    vector<FunctionArgument*> mFunctionArguments;
+    // The arguments are never modified once parsed, the copies made for the
+    // rows of a data file share them and only replace the DataPlaceholders.
+    shared_ptr<Identifier> mFunctionName;
+    vector<shared_ptr<FunctionArgument>> mFunctionArguments;
     // owned by llvm, do not delete
     llvm::Type *mReturnType;
 public:
@@ -634,32 +732,34 @@ public:
     FunctionCall(Identifier* name, const vector<FunctionArgument*>& arg);
     FunctionCall(const FunctionCall& that);
 
-    virtual ~FunctionCall();
-
     void accept(Visitor *v);
 
     string getFunctionCalledString();
+    /// Same as above but the DataPlaceholders are replaced by values, in order.
+    string getFunctionCalledString(const vector<string>& values);
     void setReturnType(llvm::Type *type) { mReturnType = type; }
     llvm::Type* getReturnType() const { return mReturnType; }
 
     bool hasDataPlaceholders() const;
     vector<unsigned> getDataPlaceholdersPos() const;
+    vector<const DataPlaceholder*> getDataPlaceholders() const;
 
     bool replaceDataPlaceholder(unsigned pos, FunctionArgument* new_arg);
     unsigned getArgCount() const { return mFunctionArguments.size(); }
+    const vector<shared_ptr<FunctionArgument>>& getArguments() const {
+    	return mFunctionArguments;
+    }
 };
 
 class ExpectedResult : public TestExpr {
 private:
-    unique_ptr<ComparisonOperator> mCompOp;
+    shared_ptr<ComparisonOperator> mCompOp;
     unique_ptr<ExpectedConstant> mEC;
 public:
     ExpectedResult(ComparisonOperator* cmp, ExpectedConstant* Arg) :
     mCompOp(cmp), mEC(Arg) {}
     ExpectedResult(const ExpectedResult& that) :
-    	TestExpr(that), mCompOp(nullptr), mEC(nullptr){
-    	if(that.mCompOp)
-    		mCompOp = unique_ptr<ComparisonOperator>(new ComparisonOperator(*that.mCompOp));
+    	TestExpr(that), mCompOp(that.mCompOp), mEC(nullptr){
     	if(that.mEC)
     		mEC = unique_ptr<ExpectedConstant>(new ExpectedConstant(*that.mEC));
     }
@@ -770,6 +870,8 @@ public:
     unsigned getBufferSize() const {
         return mIntBuffSize->getInt();
     }
+    const NumericConstant* getSizeConstant() const { return mIntBuffSize.get(); }
+    const NumericConstant* getDefaultValue() const { return mIntDefaultValue.get(); }
     string getBufferSizeAsString() const {
         return mIntBuffSize->toString();
     }
@@ -849,7 +951,7 @@ public:
 
 class MockupVariable : public TestExpr {
 private:
-    unique_ptr<VariableAssignment> mVariableAssignment;
+    shared_ptr<VariableAssignment> mVariableAssignment;
 public:
 
     MockupVariable(VariableAssignment *var) : mVariableAssignment(var) {
@@ -858,50 +960,106 @@ public:
     }
 
     MockupVariable(const MockupVariable& that)
-    : TestExpr(that), mVariableAssignment(nullptr) {
-    	mVariableAssignment = unique_ptr<VariableAssignment>(
-    			new VariableAssignment(*that.mVariableAssignment));
-    }
+    : TestExpr(that), mVariableAssignment(that.mVariableAssignment) { }
 
     void accept(Visitor *v) {
         mVariableAssignment->accept(v);
         v->VisitMockupVariable(this);
     }
+
+    const VariableAssignment* getVariableAssignment() const {
+    	return mVariableAssignment.get();
+    }
+};
+
+/// A list of constants returned one after the other by a mockup function:
+/// f() = {1, 2, 3}; The last value is returned for every subsequent call.
+class MockupSequence : public TestExpr {
+private:
+    vector<Constant*> mValues;
+public:
+    explicit
+    MockupSequence(const vector<Constant*>& values) : mValues(values) {}
+    MockupSequence(const MockupSequence& that) : TestExpr(that), mValues() {
+    	for(Constant* ptr : that.mValues)
+    		mValues.push_back(new Constant(*ptr));
+    }
+    ~MockupSequence() {
+    	for(auto*& ptr : mValues)
+    		delete ptr;
+    }
+
+    void accept(Visitor *v) {
+    	for(auto*& ptr : mValues)
+    		ptr->accept(v);
+    	v->VisitMockupSequence(this);
+    }
+
+    const vector<Constant*>& getValues() const { return mValues; }
 };
 
 class MockupFunction : public TestExpr {
 private:
     unique_ptr<FunctionCall> mFunctionCall;
-    unique_ptr<Constant> mConstant;
-    unique_ptr<Identifier> mVoidId;
+    // The values returned are shared by the copies of the mockup
+    shared_ptr<Constant> mConstant;
+    shared_ptr<Identifier> mVoidId;
+    shared_ptr<MockupSequence> mSequence;
+    unique_ptr<DataPlaceholder> mDataPlaceholder;
     // owned by llvm, do not delete!
     llvm::Function *mOriginalFunction;
     llvm::Function *mMockupFunction;
 public:
     explicit
     MockupFunction(FunctionCall *call, Constant *arg) :
-    mFunctionCall(call), mConstant(arg), mVoidId(nullptr),
-    mOriginalFunction(nullptr), mMockupFunction(nullptr) { }
+    mFunctionCall(call), mConstant(arg), mVoidId(nullptr), mSequence(nullptr),
+    mDataPlaceholder(nullptr), mOriginalFunction(nullptr), mMockupFunction(nullptr) { }
 
     explicit
     MockupFunction(FunctionCall *call, Identifier *arg) :
-        mFunctionCall(call), mConstant(nullptr), mVoidId(arg),
-        mOriginalFunction(nullptr), mMockupFunction(nullptr) { }
+        mFunctionCall(call), mConstant(nullptr), mVoidId(arg), mSequence(nullptr),
+        mDataPlaceholder(nullptr), mOriginalFunction(nullptr), mMockupFunction(nullptr) { }
+
+    explicit
+    MockupFunction(FunctionCall *call, MockupSequence *seq) :
+        mFunctionCall(call), mConstant(nullptr), mVoidId(nullptr), mSequence(seq),
+        mDataPlaceholder(nullptr), mOriginalFunction(nullptr), mMockupFunction(nullptr) { }
+
+    explicit
+    MockupFunction(FunctionCall *call, unique_ptr<DataPlaceholder> pl) :
+        mFunctionCall(call), mConstant(nullptr), mVoidId(nullptr), mSequence(nullptr),
+        mDataPlaceholder(move(pl)), mOriginalFunction(nullptr), mMockupFunction(nullptr) { }
 
     MockupFunction(const MockupFunction& that)
-    : TestExpr(that),  mFunctionCall(nullptr), mConstant(nullptr), mVoidId(nullptr),
+    : TestExpr(that),  mFunctionCall(nullptr), mConstant(that.mConstant),
+      mVoidId(that.mVoidId), mSequence(that.mSequence), mDataPlaceholder(nullptr),
      mOriginalFunction(nullptr), mMockupFunction(nullptr) {
     	mFunctionCall = unique_ptr<FunctionCall>(
     			new FunctionCall(*that.mFunctionCall));
-    	mConstant = unique_ptr<Constant>(
-    	    			new Constant(*that.mConstant));
-    	mVoidId = unique_ptr<Identifier>(
-    			new Identifier(*that.mVoidId));
+    	if(that.mDataPlaceholder)
+    		mDataPlaceholder = unique_ptr<DataPlaceholder>(new DataPlaceholder);
     }
 
     const FunctionCall* getFunctionCall() const { return mFunctionCall.get(); }
     const Constant* getConstant() const { return mConstant.get(); }
+    const MockupSequence* getSequence() const { return mSequence.get(); }
     bool isReturningVoid() { return mVoidId != nullptr; }
+    bool isSequence() const { return mSequence != nullptr; }
+    bool isDataPlaceholder() const { return mDataPlaceholder != nullptr; }
+    const Identifier* getVoidIdentifier() const { return mVoidId.get(); }
+    const DataPlaceholder* getDataPlaceholder() const { return mDataPlaceholder.get(); }
+
+    /// Replaces the '@' in: f() = @; with the values read from a CSV file.
+    /// A single value is stored as a sequence of one element.
+    void replaceDataPlaceholder(MockupSequence* seq) {
+    	assert(isDataPlaceholder() && "Mockup function is not a DataPlaceholder");
+    	mDataPlaceholder.reset();
+    	if(seq->getValues().size() == 1) {
+    		mConstant = shared_ptr<Constant>(new Constant(*seq->getValues()[0]));
+    		delete seq;
+    	} else
+    		mSequence = shared_ptr<MockupSequence>(seq);
+    }
 
     void accept(Visitor *v) {
         v->VisitMockupFunction(this);
@@ -962,6 +1120,16 @@ public:
     }
 
     vector<MockupFunction*> getMockupFunctions() const { return mMockupFunctions; }
+    const vector<MockupVariable*>& getMockupVariables() const { return mMockupVariables; }
+
+    /// Mockup functions whose return value comes from a CSV file: f() = @;
+    vector<MockupFunction*> getDataPlaceholderMockups() const {
+    	vector<MockupFunction*> mockups;
+    	for (MockupFunction* ptr : mMockupFunctions)
+    		if(ptr->isDataPlaceholder())
+    			mockups.push_back(ptr);
+    	return mockups;
+    }
 };
 
 class TestMockup : public TestExpr {
@@ -984,27 +1152,30 @@ public:
 
 class TestFixture : public TestExpr {
 private:
-    vector<TestExpr*> mStmt;
+    vector<shared_ptr<TestExpr>> mStmt;
 public:
 
-    TestFixture(const vector<TestExpr*>& stmnt) : mStmt(stmnt) { }
-    /// @warning @bug Watch for possible bugs here. We may need tod convert
-    /// to that derived type first in order to copy!
+    TestFixture(const vector<TestExpr*>& stmnt) {
+    	for(TestExpr* t : stmnt)
+    		mStmt.push_back(shared_ptr<TestExpr>(t));
+    }
+    /// The variable assignments are shared with the copy, the function calls
+    /// and the expected expressions hold the LLVM code generated for each test
+    /// so they are copied.
     TestFixture(const TestFixture& that) : TestExpr(that) {
-    	for(TestExpr* t : that.mStmt) {
+    	for(const shared_ptr<TestExpr>& t : that.mStmt) {
     		if(t->getType() == TestExpr::FUNC_CALL) {
-    			FunctionCall* fc = static_cast<FunctionCall*>(t);
-    			mStmt.push_back(new FunctionCall(*fc));
+    			FunctionCall* fc = static_cast<FunctionCall*>(t.get());
+    			mStmt.push_back(shared_ptr<TestExpr>(new FunctionCall(*fc)));
     			continue;
     		}
 			if(t->getType() == TestExpr::VAR_ASSIGN) {
-				VariableAssignment* va = static_cast<VariableAssignment*>(t);
-				    			mStmt.push_back(new VariableAssignment(*va));
+				mStmt.push_back(t);
 				continue;
 			}
 			if(t->getType() == TestExpr::EXPECT_EXPR) {
-				ExpectedExpression* ee = static_cast<ExpectedExpression*>(t);
-				    			mStmt.push_back(new ExpectedExpression(*ee));
+				ExpectedExpression* ee = static_cast<ExpectedExpression*>(t.get());
+				mStmt.push_back(shared_ptr<TestExpr>(new ExpectedExpression(*ee)));
 				continue;
 			}
 			if(t->getType() == TestExpr::OTHER)
@@ -1012,16 +1183,13 @@ public:
     	}
     }
 
-    ~TestFixture() {
-        for (auto*& ptr : mStmt)
-            delete ptr;
-    }
-
     void accept(Visitor *v) {
-        for (auto*& ptr : mStmt)
+        for (auto& ptr : mStmt)
             ptr->accept(v);
         v->VisitTestFixture(this);
     }
+
+    const vector<shared_ptr<TestExpr>>& getStatements() const { return mStmt; }
 };
 
 class TestSetup : public TestExpr {
@@ -1040,6 +1208,8 @@ public:
         mTestFixtureExpr->accept(v);
         v->VisitTestSetup(this);
     }
+
+    const TestFixture* getTestFixture() const { return mTestFixtureExpr.get(); }
 };
 
 class TestFunction : public TestExpr {
@@ -1092,32 +1262,253 @@ public:
         mTestFixture->accept(v);
         v->VisitTestTeardown(this);
     }
+
+    const TestFixture* getTestFixture() const { return mTestFixture.get(); }
+};
+
+/// A column of values computed in the test loop instead of being read from a
+/// data file:
+///
+///   range(first, last[, step]);         first, first+step, ... up to last.
+///   random(seed, count, min, max);      count values between min and max.
+///
+/// When any of the numbers is a float the values are floating point.
+/// The random values are a pure function of the seed and the position of the
+/// value (splitmix64), so any row can be computed, and reported, on its own.
+class DataGenerator : public TestExpr {
+public:
+	enum Kind {
+		RANGE,
+		RANDOM,
+	};
+private:
+	Kind mKind;
+	bool mIsFloat;
+	// range: first, last and step. random: min and max
+	int64_t mInts[3];
+	double mFloats[3];
+	uint64_t mSeed;
+	uint64_t mCount;
+	string mStr;
+	// The numbers as written in the test file
+	vector<string> mArgs;
+public:
+	/// Throws a JCUTException when the arguments are not valid
+	DataGenerator(Kind kind, const vector<string>& args);
+	DataGenerator(const DataGenerator& that) = default;
+
+	void accept(Visitor* v) {
+		v->VisitDataGenerator(this);
+	}
+
+	Kind getKind() const { return mKind; }
+	bool isFloat() const { return mIsFloat; }
+	/// Number of values generated
+	uint64_t count() const { return mCount; }
+	uint64_t getSeed() const { return mSeed; }
+	/// First value of a range, minimum value of a random stream
+	int64_t getFirstInt() const { return mInts[0]; }
+	double getFirstFloat() const { return mFloats[0]; }
+	/// Maximum value of a random stream
+	int64_t getMaxInt() const { return mInts[1]; }
+	double getMaxFloat() const { return mFloats[1]; }
+	int64_t getStepInt() const { return mInts[2]; }
+	double getStepFloat() const { return mFloats[2]; }
+
+	/// The i-th value. The generated code computes exactly the same values.
+	int64_t getIntAt(uint64_t i) const;
+	double getFloatAt(uint64_t i) const;
+	string valueToString(uint64_t i) const;
+
+	/// The splitmix64 hash of the i-th value of a random stream
+	static uint64_t hash(uint64_t seed, uint64_t i);
+	static const uint64_t HashIncrement = 0x9E3779B97F4A7C15ULL;
+	static const uint64_t HashMultiplier1 = 0xBF58476D1CE4E5B9ULL;
+	static const uint64_t HashMultiplier2 = 0x94D049BB133111EBULL;
+
+	/// How it was written in the test file
+	const string& toString() const { return mStr; }
+	const vector<string>& getArguments() const { return mArgs; }
 };
 
 class TestData : public TestExpr {
 private:
     unique_ptr<StringConstant> mDataPath;
+    vector<DataGenerator*> mGenerators;
 public:
     TestData(unique_ptr<StringConstant> path) : mDataPath(move(path)) {}
+    TestData(const vector<DataGenerator*>& generators) : mDataPath(nullptr),
+    		mGenerators(generators) {}
     TestData(const TestData& that) : TestExpr(that), mDataPath(nullptr) {
     	if(that.mDataPath.get())
     		mDataPath = unique_ptr<StringConstant>
     					(new StringConstant(*that.mDataPath.get()));
+    	for(DataGenerator* ptr : that.mGenerators)
+    		mGenerators.push_back(new DataGenerator(*ptr));
+    }
+    ~TestData() {
+    	for(auto*& ptr : mGenerators)
+    		delete ptr;
     }
 
     void accept(Visitor* v) {
+    	for(auto*& ptr : mGenerators)
+    		ptr->accept(v);
         v->VisitTestInfo(this);
     }
 
+    bool hasGenerators() const { return !mGenerators.empty(); }
+    const vector<DataGenerator*>& getGenerators() const { return mGenerators; }
+
+    /// The path of the data file, for generators a description of them
     string getDataPath() const {
+    	if(hasGenerators()) {
+    		string desc;
+    		for(DataGenerator* ptr : mGenerators)
+    			desc += (desc.empty() ? "" : " x ") + ptr->toString();
+    		return desc;
+    	}
     	const string& path = mDataPath->getString();
     	return path.substr(1,path.size()-2); // Remove the double quotes
     }
 };
 
+/// The data {} file of a test run in data loop mode (--data-loop). Instead of
+/// cloning the TestDefinition for every row, the values for each of its
+/// DataPlaceholders are stored in typed columns. The TestGeneratorVisitor emits
+/// them as constant arrays and a single LLVM function iterates over the rows.
+class DataTable {
+public:
+	struct Column {
+		bool mIsFloat;
+		vector<int64_t> mInts;
+		vector<double> mFloats;
+		// The columns of a binary data file are not copied, the test loop
+		// reads them from the mapped file through mGlobal.
+		const JCBFile* mFile;
+		unsigned mFileColumn;
+		llvm::GlobalVariable* mGlobal;
+		// The values of a generated column are computed in the test loop:
+		// the value of a row is the number (row / mStride) % count() of the
+		// generator. Owned by the TestData of the test.
+		const DataGenerator* mGenerator;
+		uint64_t mStride;
+		// The inputs of a property are read through mGlobal from a slot of
+		// the table the TestRunnerVisitor fills with random values. Their
+		// type is the type of the first parameter they are passed to.
+		bool mIsInput;
+		llvm::Type* mInputType;
+		string mName;
+
+		Column() : mIsFloat(false), mInts(), mFloats(), mFile(nullptr),
+				mFileColumn(0), mGlobal(nullptr), mGenerator(nullptr), mStride(1),
+				mIsInput(false), mInputType(nullptr), mName() {}
+
+		bool isMapped() const { return mFile != nullptr; }
+		bool isGenerated() const { return mGenerator != nullptr; }
+		bool isInput() const { return mIsInput; }
+
+		void addInt(int64_t value) {
+			if(mIsFloat) mFloats.push_back(value);
+			else mInts.push_back(value);
+		}
+		void addFloat(double value) {
+			if(!mIsFloat) { // Promote the whole column to floating point
+				for(int64_t i : mInts)
+					mFloats.push_back(i);
+				mInts.clear();
+				mIsFloat = true;
+			}
+			mFloats.push_back(value);
+		}
+		size_t size() const { return mIsFloat ? mFloats.size() : mInts.size(); }
+
+		/// Returns all the values converted to type T
+		template<typename T>
+		vector<T> getValues() const {
+			vector<T> values;
+			values.reserve(size());
+			if(mIsFloat)
+				for(double d : mFloats) values.push_back(static_cast<T>(d));
+			else
+				for(int64_t i : mInts) values.push_back(static_cast<T>(i));
+			return values;
+		}
+
+		string toString(uint64_t row) const {
+			if(mFile)
+				return mFile->toString(mFileColumn, row);
+			if(mGenerator)
+				return mGenerator->valueToString((row / mStride) % mGenerator->count());
+			stringstream ss;
+			if(mIsFloat) ss << mFloats[row];
+			else ss << mInts[row];
+			return ss.str();
+		}
+	};
+private:
+	string mPath;
+	// One column per DataPlaceholder: function arguments and expected result.
+	vector<Column> mColumns;
+	uint64_t mRows;
+	uint64_t mFailedRowCount;
+	// Only the failing rows are run again to be reported.
+	string mFailedRows;
+	shared_ptr<JCBFile> mFile;
+	// The column used by every DataPlaceholder, in the order they appear.
+	// Empty when each placeholder uses its own column.
+	vector<unsigned> mPlaceholderColumns;
+	// The current value of the inputs of a property, 8 bytes per column
+	vector<uint64_t> mInputs;
+	bool mIsProperty;
+public:
+	/// The rows of the data generators of a test, more would not end
+	static const uint64_t MaxGeneratedRows = 1ULL << 32;
+
+	DataTable(const string& path, unsigned columns) : mPath(path),
+		mColumns(columns), mRows(0), mFailedRowCount(0), mFailedRows(),
+		mFile(nullptr), mIsProperty(false) {}
+	/// All the columns point inside the binary data file
+	explicit DataTable(shared_ptr<JCBFile> file) : mPath(file->getPath()),
+		mColumns(file->columnCount()), mRows(file->rowCount()),
+		mFailedRowCount(0), mFailedRows(), mFile(file), mIsProperty(false) {
+		for(unsigned j = 0; j < mColumns.size(); ++j) {
+			mColumns[j].mFile = mFile.get();
+			mColumns[j].mFileColumn = j;
+		}
+	}
+	/// One column per generator, the rows are all their combinations. The
+	/// last generator changes faster.
+	DataTable(const string& desc, const vector<DataGenerator*>& generators);
+	/// The inputs of a property, one column per name. placeholder_columns
+	/// has the column of every DataPlaceholder of the test.
+	DataTable(const vector<string>& names, const vector<unsigned>& placeholder_columns);
+
+	bool isProperty() const { return mIsProperty; }
+	/// The column of the i-th DataPlaceholder of the test
+	unsigned getPlaceholderColumn(unsigned i) const {
+		return i < mPlaceholderColumns.size() ? mPlaceholderColumns[i] : i;
+	}
+	/// Where the value of the input in the column j is stored
+	uint64_t* getInput(unsigned j) { return &mInputs[j]; }
+
+	const string& getPath() const { return mPath; }
+	Column& getColumn(unsigned i) { return mColumns[i]; }
+	const Column& getColumn(unsigned i) const { return mColumns[i]; }
+	unsigned columnCount() const { return mColumns.size(); }
+	uint64_t rowCount() const { return mRows; }
+	void setRowCount(uint64_t rows) { mRows = rows; }
+
+	void setFailedRowCount(uint64_t count) { mFailedRowCount = count; }
+	uint64_t getFailedRowCount() const { return mFailedRowCount; }
+	void setFailedRows(const string& report) { mFailedRows = report; }
+	const string& getFailedRows() const { return mFailedRows; }
+};
+
 class TestDefinition : public TestExpr, public LLVMFunctionHolder {
 private:
-    unique_ptr<TestData> mTestData;
+    // The data {} statement is the same for all the copies of a test
+    shared_ptr<TestData> mTestData;
     unique_ptr<TestFunction> mTestFunction;
     unique_ptr<TestSetup> mTestSetup;
     unique_ptr<TestTeardown> mTestTeardown;
@@ -1125,7 +1516,23 @@ private:
     // Do not delete these pointers! They belong to someone else!
 	// We only store ExpectedExpressions that are known to have failed.
 	std::vector<ExpectedExpression*> mFailedEE;
-	std::map<ColumnName,string> mResults;
+	// All the ExpectedExpressions evaluated when this test runs, including
+	// the ones from a before_all/after_all statement that preceded it.
+	std::vector<ExpectedExpression*> mExpExpr;
+	// owned by llvm, do not delete!
+	llvm::Function* mDriverFunction;
+	// owned by llvm, only created with --bench
+	llvm::Function* mBenchFunction;
+	// owned by llvm, only created for the tests run in a data loop
+	llvm::Function* mSaveGlobalsFunction;
+	// Only used in data loop mode, shared by the copies of this test.
+	shared_ptr<DataTable> mDataTable;
+	// property { } tests run with random values for their DataPlaceholders
+	bool mIsProperty;
+	// The C source file where the function under test is defined
+	string mSourceFile;
+	// The nanoseconds per call measured with --bench
+	string mBenchmark;
 public:
 
     TestDefinition(
@@ -1135,14 +1542,19 @@ public:
             TestTeardown *teardown = nullptr,
             TestMockup *mockup = nullptr) :
     mTestData(info), mTestFunction(function), mTestSetup(setup),
-    mTestTeardown(teardown), mTestMockup(mockup), mResults() { }
+    mTestTeardown(teardown), mTestMockup(mockup),
+    mDriverFunction(nullptr), mBenchFunction(nullptr),
+    mSaveGlobalsFunction(nullptr), mDataTable(nullptr), mIsProperty(false),
+    mSourceFile(), mBenchmark() {
+    	type = TestExpr::TEST_DEFINITION;
+    }
 
     TestDefinition(const TestDefinition& that)
-    : TestExpr(that), mTestData(nullptr), mTestFunction(nullptr), mTestSetup(nullptr),
+    : TestExpr(that), mTestData(that.mTestData), mTestFunction(nullptr), mTestSetup(nullptr),
       mTestTeardown(nullptr), mTestMockup(nullptr), mFailedEE(that.mFailedEE),
-      mResults(that.mResults){
-    	if(that.mTestData)
-    		mTestData = unique_ptr<TestData>(new TestData(*that.mTestData));
+      mExpExpr(), mDriverFunction(nullptr), mBenchFunction(nullptr),
+      mSaveGlobalsFunction(nullptr), mDataTable(that.mDataTable),
+      mIsProperty(that.mIsProperty), mSourceFile(that.mSourceFile), mBenchmark() {
     	if(that.mTestFunction)
     		mTestFunction = unique_ptr<TestFunction>(
     						new TestFunction(*that.mTestFunction));
@@ -1160,6 +1572,8 @@ public:
     TestData* getTestData() const { return mTestData.get(); }
     TestFunction * getTestFunction() const {return mTestFunction.get();}
     TestMockup* getTestMockup() const { return mTestMockup.get(); }
+    TestSetup* getTestSetup() const { return mTestSetup.get(); }
+    TestTeardown* getTestTeardown() const { return mTestTeardown.get(); }
 
     bool hasTestMockup() const { return mTestMockup != nullptr; }
 
@@ -1180,15 +1594,40 @@ public:
        const std::vector<ExpectedExpression*>&
        getFailedExpectedExpressions() const { return mFailedEE; }
 
+    void setExpectedExpressions(const std::vector<ExpectedExpression*>& ee) {
+    	mExpExpr = ee;
+    }
+    const std::vector<ExpectedExpression*>&
+    getExpectedExpressions() const { return mExpExpr; }
+
+    void setDriverFunction(llvm::Function* f) { mDriverFunction = f; }
+    llvm::Function* getDriverFunction() const { return mDriverFunction; }
+
+    void setBenchFunction(llvm::Function* f) { mBenchFunction = f; }
+    llvm::Function* getBenchFunction() const { return mBenchFunction; }
+    void setBenchmark(const string& report) { mBenchmark = report; }
+
+    /// Saves the writable globals of the module, the driver of a data loop
+    /// restores them before every row.
+    void setSaveGlobalsFunction(llvm::Function* f) { mSaveGlobalsFunction = f; }
+    llvm::Function* getSaveGlobalsFunction() const { return mSaveGlobalsFunction; }
+    const string& getBenchmark() const { return mBenchmark; }
+
+    void setDataTable(shared_ptr<DataTable> table) { mDataTable = table; }
+    DataTable* getDataTable() const { return mDataTable.get(); }
+
+    void setProperty(bool property) { mIsProperty = property; }
+    bool isProperty() const { return mIsProperty; }
+
+    void setSourceFile(const string& file) { mSourceFile = file; }
+    const string& getSourceFile() const { return mSourceFile; }
+
     bool testPassed() const {
     	bool passed = getPassingValue();
     	if(mFailedEE.size())
     		passed = false;
     	return passed;
     }
-
-    void setTestResults(const std::map<ColumnName,string>& r) { mResults = r; }
-    const std::map<ColumnName,string>& getTestResults() const { return mResults;}
 };
 
 class GlobalMockup : public TestExpr {
@@ -1218,6 +1657,8 @@ public:
         mTestFixture->accept(v);
         v->VisitGroupSetup(this);
     }
+
+    const TestFixture* getTestFixture() const { return mTestFixture.get(); }
 };
 
 class GlobalTeardown : public TestExpr, public LLVMFunctionHolder {
@@ -1232,6 +1673,8 @@ public:
         if (mTestFixture) mTestFixture->accept(v);
         v->VisitGroupTeardown(this);
     }
+
+    const TestFixture* getTestFixture() const { return mTestFixture.get(); }
 };
 
 class TestGroup : public TestExpr, public LLVMFunctionHolder {
@@ -1253,6 +1696,7 @@ public:
     mGlobalMockup(gm), mGlobalSetup(gs), mGlobalTeardown(gt) {
         if (mGlobalSetup) mGlobalSetup->setGroupName(mName->toString());
         if (mGlobalTeardown) mGlobalTeardown->setGroupName(mName->toString());
+        type = TestExpr::TEST_GROUP;
     }
     ~TestGroup() {
         for (auto*& ptr : mTests)
@@ -1265,7 +1709,8 @@ public:
         if (mGlobalMockup) mGlobalMockup->accept(v);
         if (mGlobalSetup) mGlobalSetup->accept(v);
         for (auto*& ptr : mTests) {
-            ptr->accept(v);
+            if (isVisited(ptr, v->getSourceFile()))
+                ptr->accept(v);
         }
         if (mGlobalTeardown) mGlobalTeardown->accept(v);
         v->VisitTestGroup(this);
@@ -1279,6 +1724,13 @@ public:
     void setGlobalTeardown(GlobalTeardown* gt) { mGlobalTeardown.reset(gt); }
     // Use it with wisdom, you can modify the internal object structure.
     vector<TestExpr*>& getTests() { return mTests; }
+
+    /// True when this group, or any group inside it, has a test of the
+    /// function defined in the given C source file.
+    bool hasTestsFrom(const string& source) const;
+    /// Whether a visitor of the tests of source goes into a test or a group,
+    /// all of them are visited when source is empty.
+    static bool isVisited(const TestExpr* test, const string& source);
 };
 
 class TestFile : public TestExpr {
@@ -1290,9 +1742,12 @@ public:
 
     void accept(Visitor *v) {
         v->VisitTestFileFirst(this);
-        mTestGroups->accept(v);
+        if (TestGroup::isVisited(mTestGroups.get(), v->getSourceFile()))
+            mTestGroups->accept(v);
         v->VisitTestFile(this);
     }
+
+    TestGroup* getTestGroup() const { return mTestGroups.get(); }
 };
 
 class FunctionArgument : public TestExpr{
@@ -1321,6 +1776,7 @@ public:
 
     bool isBufferAlloc() const { return argBuffAlloc != nullptr; }
     bool isDataPlaceholder() const { return mDP.get() != nullptr; }
+    const DataPlaceholder* getDataPlaceholder() const { return mDP.get(); }
     TokenType getTokenType() const {
         if(mConstant) return mConstant->getTokenType();
         return TOK_BUFF_ALLOC;
@@ -1330,7 +1786,7 @@ public:
         if(mConstant)
             return mConstant->toString();
         if(mDP.get())
-        	return "@";
+        	return mDP->toString();
         return "BufferAlloc";
     }
     unsigned getIndex() const { return ArgIndx; }
@@ -1355,11 +1811,11 @@ public:
 
 class TestDriver {
 public:
-    TestDriver() {}
+    TestDriver() : mTokenizer(), mCurrentToken(), mGroupCount(0) {}
     TestDriver(const TestDriver&) = delete;
 
     TestDriver(const string& file) : mTokenizer(),
-    mCurrentToken() {
+    mCurrentToken(), mGroupCount(0) {
     	mTokenizer.tokenize(file);
     }
 
@@ -1378,6 +1834,8 @@ public:
 protected:
     Tokenizer mTokenizer;
 	Token mCurrentToken;
+	// Used to name the groups without a name, each file starts from 0
+	unsigned mGroupCount;
 
     /// Generates default names for groups
     Identifier* groupNameFactory();
@@ -1407,9 +1865,12 @@ protected:
     TestFixture* ParseTestFixture();
     MockupVariable* ParseMockupVariable();
     MockupFunction* ParseMockupFunction();
+    MockupSequence* ParseMockupSequence();
     MockupFixture* ParseMockupFixture();
     TestMockup* ParseTestMockup();
     TestData* ParseTestData();
+    TestDefinition* ParseTestProperty();
+    DataGenerator* ParseDataGenerator();
     TestDefinition* ParseTestDefinition();
     // @arg name The name of the group to be parsed
     TestGroup* ParseTestGroup(Identifier* name);
@@ -1423,15 +1884,29 @@ class CSVDriver : public TestDriver{
 public:
 	CSVDriver(const string& filename);
 
+	/// Moves to the next row of the file. Returns false at the end of the file.
+	bool nextRow();
+	/// Starts reading again from the first row.
+	void rewind();
 	unsigned columnCount();
-	unsigned rowCount();
-	FunctionArgument* getFunctionArgumentAt(unsigned i, unsigned j);
-	ExpectedConstant* getExpectedConstantAt(unsigned i, unsigned j);
+	/// Number of rows read so far.
+	unsigned rowCount() const { return mReader.rowCount(); }
+	/// Line of the file where the current row starts.
+	unsigned lineNumber() const { return mReader.lineNumber(); }
+	/// The text of the column j of the current row.
+	llvm::StringRef getFieldAt(unsigned j) const { return mRow[j]; }
+	FunctionArgument* getFunctionArgumentAt(unsigned j);
+	ExpectedConstant* getExpectedConstantAt(unsigned j);
+	MockupSequence* getMockupSequenceAt(unsigned j);
 private:
-	unsigned rows;
-	unsigned columns;
-	vector<string> split(string line, char split_char);
-	vector<vector<string>> mMatrix;
+	CSVReader mReader;
+	unsigned mColumns;
+	// Views inside the mapped file, valid until the next call to nextRow()
+	vector<llvm::StringRef> mRow;
+	/// Numbers and chars are parsed directly without the tokenizer.
+	/// Returns nullptr for any other cell.
+	Constant* parseConstant(llvm::StringRef cell);
+	void tokenize(llvm::StringRef cell);
 };
 
 } // namespace tp
@@ -0,0 +1,327 @@
+//===-- jcut/TestReporter.cpp - Reports of the results ----------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "TestReporter.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+vector<unique_ptr<TestReporter>> TestReporter::create(const string& reports)
+{
+	vector<unique_ptr<TestReporter>> reporters;
+	stringstream ss(reports);
+	string report;
+	while(getline(ss, report, ',')) {
+		if(report.empty())
+			continue;
+		string::size_type colon = report.find(':');
+		string format = report.substr(0, colon);
+		string path = (colon == string::npos) ? "" : report.substr(colon + 1);
+		if(format == "junit")
+			reporters.push_back(unique_ptr<TestReporter>(new JUnitReporter(path)));
+		else if(format == "json")
+			reporters.push_back(unique_ptr<TestReporter>(new JSONReporter(path)));
+		else if(format == "tap")
+			reporters.push_back(unique_ptr<TestReporter>(new TAPReporter(path)));
+		else
+			throw JCUTException("Unknown report "+format+", valid reports are: "
+					"junit, json and tap");
+	}
+	return reporters;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+streambuf* FileReporter::sStdoutBuffer = nullptr;
+unsigned FileReporter::sStdoutReports = 0;
+
+FileReporter::FileReporter(const string& path) : mFile(), mStdout(), mOut(nullptr),
+	mTestCount(0), mTestsFailed(0), mSeconds(0)
+{
+	if(path.empty()) {
+		if(sStdoutReports++ == 0)
+			sStdoutBuffer = cout.rdbuf(cerr.rdbuf());
+		mStdout.reset(new ostream(sStdoutBuffer));
+		mOut = mStdout.get();
+		return;
+	}
+	mFile.rdbuf()->pubsetbuf(mBuffer, sizeof(mBuffer));
+	mFile.open(path.c_str(), ios::out | ios::trunc);
+	if(!mFile)
+		throw JCUTException("Could not open the report "+path+" for writing");
+	mOut = &mFile;
+}
+
+FileReporter::~FileReporter()
+{
+	mOut->flush();
+	if(mStdout && --sStdoutReports == 0)
+		cout.rdbuf(sStdoutBuffer);
+}
+
+bool FileReporter::count(const TestResults& results, double seconds)
+{
+	++mTestCount;
+	mSeconds += seconds;
+	bool passed = results.get(RESULT) == "PASSED";
+	if(!passed)
+		++mTestsFailed;
+	return passed;
+}
+
+string FileReporter::getColumn(const TestResults& results, ColumnName column)
+{
+	if(!results.has(column))
+		return "";
+	const string& value = results.get(column);
+	// Multi line columns start with a new line
+	string::size_type begin = value.find_first_not_of('\n');
+	string::size_type end = value.find_last_not_of('\n');
+	if(begin == string::npos)
+		return "";
+	return value.substr(begin, end - begin + 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+string JUnitReporter::escape(const string& str)
+{
+	string escaped;
+	escaped.reserve(str.size());
+	for(char c : str) {
+		switch(c) {
+		case '<': escaped += "&lt;"; break;
+		case '>': escaped += "&gt;"; break;
+		case '&': escaped += "&amp;"; break;
+		case '"': escaped += "&quot;"; break;
+		case '\'': escaped += "&apos;"; break;
+		default:
+			// Control characters other than tab and new line are not valid XML
+			if(static_cast<unsigned char>(c) < 0x20 && c != '\t' && c != '\n' && c != '\r')
+				escaped += '?';
+			else
+				escaped += c;
+		}
+	}
+	return escaped;
+}
+
+void JUnitReporter::writeCounters()
+{
+	stringstream ss;
+	ss << "tests=\"" << mTestCount << "\" failures=\"" << mTestsFailed
+	   << "\" time=\"" << fixed << setprecision(6) << mSeconds << "\"";
+	// Always as wide, so the final values are written over the same bytes
+	*mOut << left << setw(CountersWidth) << ss.str() << right;
+}
+
+void JUnitReporter::begin()
+{
+	*mOut << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	*mOut << "<testsuites>\n";
+	*mOut << "  <testsuite name=\"jcut\" ";
+	// The counters are only known at the end, they can be written over
+	// their place in a file. On standard output they are written at the end
+	// in a second testsuite without tests.
+	if(isFile()) {
+		mCounters = getFile().tellp();
+		writeCounters();
+	}
+	*mOut << ">\n";
+}
+
+void JUnitReporter::testFinished(TestDefinition* TD,
+		const TestResults& results, double seconds)
+{
+	bool passed = count(results, seconds);
+	*mOut << "    <testcase classname=\"" << escape(getColumn(results, GROUP_NAME))
+		  << "\" name=\"" << escape(getColumn(results, TEST_NAME))
+		  << "\" time=\"" << fixed << setprecision(6) << seconds << "\">\n";
+	mOut->unsetf(ios::floatfield);
+	*mOut << "      <properties>\n"
+		  << "        <property name=\"function\" value=\"" << escape(getColumn(results, FUD)) << "\"/>\n"
+		  << "        <property name=\"actual\" value=\"" << escape(getColumn(results, ACTUAL_RESULT)) << "\"/>\n"
+		  << "        <property name=\"expected\" value=\"" << escape(getColumn(results, EXPECTED_RES)) << "\"/>\n";
+	if(getColumn(results, BENCHMARK).size())
+		*mOut << "        <property name=\"benchmark\" value=\"" << escape(getColumn(results, BENCHMARK)) << "\"/>\n";
+	*mOut << "      </properties>\n";
+	if(!passed) {
+		string message = getColumn(results, FUD) + " returned " +
+				getColumn(results, ACTUAL_RESULT);
+		if(getColumn(results, EXPECTED_RES).size())
+			message += ", expected " + getColumn(results, EXPECTED_RES);
+		*mOut << "      <failure message=\"" << escape(message) << "\">"
+			  << escape(getColumn(results, FAILED_EE));
+		if(getColumn(results, FAILED_ROWS).size())
+			*mOut << escape(getColumn(results, FAILED_ROWS));
+		*mOut << "</failure>\n";
+	}
+	if(getColumn(results, FUD_OUTPUT).size())
+		*mOut << "      <system-out>" << escape(getColumn(results, FUD_OUTPUT))
+			  << "</system-out>\n";
+	if(getColumn(results, WARNING).size())
+		*mOut << "      <system-err>" << escape(getColumn(results, WARNING))
+			  << "</system-err>\n";
+	*mOut << "    </testcase>\n";
+}
+
+void JUnitReporter::end()
+{
+	*mOut << "  </testsuite>\n";
+	if(!isFile()) {
+		*mOut << "  <testsuite name=\"jcut-summary\" ";
+		writeCounters();
+		*mOut << "/>\n";
+	}
+	*mOut << "</testsuites>\n";
+	if(isFile()) {
+		ofstream& file = getFile();
+		file.seekp(mCounters);
+		writeCounters();
+		file.seekp(0, ios::end);
+	}
+	mOut->flush();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+string JSONReporter::escape(const string& str)
+{
+	stringstream ss;
+	ss << '"';
+	for(char c : str) {
+		switch(c) {
+		case '"': ss << "\\\""; break;
+		case '\\': ss << "\\\\"; break;
+		case '\n': ss << "\\n"; break;
+		case '\r': ss << "\\r"; break;
+		case '\t': ss << "\\t"; break;
+		default:
+			if(static_cast<unsigned char>(c) < 0x20)
+				ss << "\\u" << hex << setw(4) << setfill('0') << int(c)
+				   << dec << setfill(' ');
+			else
+				ss << c;
+		}
+	}
+	ss << '"';
+	return ss.str();
+}
+
+void JSONReporter::begin()
+{
+	*mOut << "{\n\"tests\": [";
+}
+
+void JSONReporter::testFinished(TestDefinition* TD,
+		const TestResults& results, double seconds)
+{
+	count(results, seconds);
+	*mOut << (mTestCount > 1 ? ",\n" : "\n");
+	*mOut << "{\"group\": " << escape(getColumn(results, GROUP_NAME))
+		  << ", \"name\": " << escape(getColumn(results, TEST_NAME))
+		  << ", \"function\": " << escape(getColumn(results, FUD))
+		  << ", \"result\": " << escape(getColumn(results, RESULT))
+		  << ", \"actual\": " << escape(getColumn(results, ACTUAL_RESULT))
+		  << ", \"expected\": " << escape(getColumn(results, EXPECTED_RES))
+		  << ", \"output\": " << escape(getColumn(results, FUD_OUTPUT))
+		  << ", \"warnings\": " << escape(getColumn(results, WARNING))
+		  << ", \"failed_expressions\": " << escape(getColumn(results, FAILED_EE))
+		  << ", \"failed_rows\": " << escape(getColumn(results, FAILED_ROWS))
+		  << ", \"benchmark\": " << escape(getColumn(results, BENCHMARK))
+		  << ", \"time\": " << fixed << setprecision(6) << seconds << "}";
+	mOut->unsetf(ios::floatfield);
+}
+
+void JSONReporter::end()
+{
+	*mOut << "\n],\n\"summary\": {\"tests\": " << mTestCount
+		  << ", \"passed\": " << (mTestCount - mTestsFailed)
+		  << ", \"failed\": " << mTestsFailed
+		  << ", \"time\": " << fixed << setprecision(6) << mSeconds << "}\n}\n";
+	mOut->unsetf(ios::floatfield);
+	mOut->flush();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+/// Every line of a TAP diagnostic is indented
+string indent(const string& str, const string& prefix)
+{
+	stringstream in(str);
+	string line, indented;
+	while(getline(in, line))
+		indented += prefix + line + "\n";
+	return indented;
+}
+
+} // anonymous namespace
+
+void TAPReporter::begin()
+{
+	*mOut << "TAP version 13\n";
+}
+
+void TAPReporter::testFinished(TestDefinition* TD,
+		const TestResults& results, double seconds)
+{
+	bool passed = count(results, seconds);
+	*mOut << (passed ? "ok " : "not ok ") << mTestCount << " - "
+		  << getColumn(results, GROUP_NAME) << "." << getColumn(results, TEST_NAME)
+		  << " " << getColumn(results, FUD) << "\n";
+	// A YAML block with the details
+	*mOut << "  ---\n"
+		  << "  duration_ms: " << fixed << setprecision(3) << seconds * 1000 << "\n";
+	mOut->unsetf(ios::floatfield);
+	if(!passed) {
+		*mOut << "  actual: |\n" << indent(getColumn(results, ACTUAL_RESULT), "    ");
+		*mOut << "  expected: |\n" << indent(getColumn(results, EXPECTED_RES), "    ");
+		if(getColumn(results, FAILED_EE).size())
+			*mOut << "  failed_expressions: |\n"
+				  << indent(getColumn(results, FAILED_EE), "    ");
+		if(getColumn(results, FAILED_ROWS).size())
+			*mOut << "  failed_rows: |\n"
+				  << indent(getColumn(results, FAILED_ROWS), "    ");
+	}
+	if(getColumn(results, FUD_OUTPUT).size())
+		*mOut << "  output: |\n" << indent(getColumn(results, FUD_OUTPUT), "    ");
+	if(getColumn(results, WARNING).size())
+		*mOut << "  warnings: |\n" << indent(getColumn(results, WARNING), "    ");
+	if(getColumn(results, BENCHMARK).size())
+		*mOut << "  benchmark: |\n" << indent(getColumn(results, BENCHMARK), "    ");
+	*mOut << "  ...\n";
+}
+
+void TAPReporter::end()
+{
+	*mOut << "1.." << mTestCount << "\n";
+	mOut->flush();
+}
@@ -0,0 +1,148 @@
+//===-- jcut/TestReporter.h - Reports of the results ------------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Reporters of the results of the tests.
+///
+/// The TestRunnerVisitor gives every reporter the results of each test as
+/// soon as it ran, a reporter writes them right away and forgets them. The
+/// reports selected with --report are written for the whole run, the tests
+/// of all the source files go into the same report:
+///
+///   --report=junit:results.xml,json:results.json,tap
+///
+/// A report without a file name is written to standard output, the table of
+/// the tests and the other messages jcut writes to cout then go to standard
+/// error so that the report can be read as is.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TESTREPORTER_H_
+#define TESTREPORTER_H_
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Visitor.h"
+#include "TestParser.h"
+
+using namespace std;
+using namespace tp;
+
+class TestReporter : public Visitor {
+public:
+	virtual ~TestReporter() {}
+
+	/// Called before the first test runs
+	virtual void begin() {}
+	/// The results of a test that just ran and how long it took
+	virtual void testFinished(TestDefinition* TD,
+			const TestResults& results, double seconds) = 0;
+	/// Called after the last test ran
+	virtual void end() {}
+	/// Writes what is still buffered, called before a test is forked so
+	/// that the test process does not write it a second time.
+	virtual void flush() {}
+
+	/// The reporters of a --report option. Throws a JCUTException when a
+	/// report is unknown or its file can not be written.
+	static vector<unique_ptr<TestReporter>> create(const string& reports);
+};
+
+/// Base of the reports written to a file, or to standard output when the
+/// file name is empty.
+class FileReporter : public TestReporter {
+private:
+	ofstream mFile;
+	// Written in big chunks, not test by test
+	char mBuffer[64*1024];
+	// Over the buffer of standard output, when there is no file
+	unique_ptr<ostream> mStdout;
+	// The buffer cout had before the first report to standard output took
+	// it, it is given back when the last one ends.
+	static streambuf* sStdoutBuffer;
+	static unsigned sStdoutReports;
+protected:
+	ostream* mOut;
+	unsigned mTestCount;
+	unsigned mTestsFailed;
+	double mSeconds;
+
+	/// Counts the test, returns whether it passed
+	bool count(const TestResults& results, double seconds);
+	bool isFile() const { return mFile.is_open(); }
+	ofstream& getFile() { return mFile; }
+public:
+	explicit FileReporter(const string& path);
+	virtual ~FileReporter();
+
+	void flush() { mOut->flush(); }
+
+	static string getColumn(const TestResults& results, ColumnName column);
+};
+
+/// JUnit XML, one testsuite per run and one testcase per test
+class JUnitReporter : public FileReporter {
+private:
+	// Where the counters of the testsuite are written at the end
+	streampos mCounters;
+	static const unsigned CountersWidth = 80;
+
+	static string escape(const string& str);
+	void writeCounters();
+public:
+	explicit JUnitReporter(const string& path) : FileReporter(path), mCounters(-1) {}
+
+	void begin();
+	void testFinished(TestDefinition* TD, const TestResults& results,
+			double seconds);
+	void end();
+};
+
+/// A JSON object with the array of the tests and a summary
+class JSONReporter : public FileReporter {
+private:
+	static string escape(const string& str);
+public:
+	explicit JSONReporter(const string& path) : FileReporter(path) {}
+
+	void begin();
+	void testFinished(TestDefinition* TD, const TestResults& results,
+			double seconds);
+	void end();
+};
+
+/// Test Anything Protocol version 13, the plan is written at the end
+class TAPReporter : public FileReporter {
+public:
+	explicit TAPReporter(const string& path) : FileReporter(path) {}
+
+	void begin();
+	void testFinished(TestDefinition* TD, const TestResults& results,
+			double seconds);
+	void end();
+};
+
+#endif /* TESTREPORTER_H_ */
@@ -26,6 +26,8 @@
 ///
 //===----------------------------------------------------------------------===//
 #include "TestRunnerVisitor.h"
+#include "TimeReport.h"
+#include "llvm/ExecutionEngine/JITEventListener.h"
 
 // Headers needed to fork!
 #ifdef __MINGW32__
@@ -34,10 +36,208 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #endif
+#include <fcntl.h>
 ///////
 
 #include "llvm/Support/CommandLine.h"
 extern llvm::cl::opt<bool> NoForkOpt;
+extern llvm::cl::opt<unsigned> PropertyRunsOpt;
+extern llvm::cl::opt<unsigned> PropertySeedOpt;
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <limits>
+
+namespace {
+
+// The value of a property input. Integers are kept sign extended to 64 bits.
+struct InputValue {
+	int64_t mInt;
+	double mFloat;
+};
+
+bool isFloatInput(const DataTable::Column& column)
+{
+	assert(column.mInputType && "The input is not used by the test");
+	return column.mInputType->isFloatingPointTy();
+}
+
+// Keeps the low bits of value and sign extends them, bools are 0 or 1.
+int64_t truncateInt(uint64_t value, unsigned bits)
+{
+	if(bits >= 64)
+		return value;
+	if(bits == 1)
+		return value & 1;
+	uint64_t mask = (1ULL << bits) - 1;
+	value &= mask;
+	if(value >> (bits - 1))
+		value |= ~mask;
+	return value;
+}
+
+// Edge values, small values and values from the whole range of the type are
+// mixed, most bugs are found with the first two.
+InputValue randomInput(const DataTable::Column& column, uint64_t seed, uint64_t& counter)
+{
+	uint64_t kind = DataGenerator::hash(seed, counter++);
+	uint64_t r = DataGenerator::hash(seed, counter++);
+	InputValue input = {0, 0};
+	if(isFloatInput(column)) {
+		static const double edges[] = {0.0, 1.0, -1.0, 0.5, -0.5, 1e10, -1e10};
+		// 53 random bits in [0, 1)
+		double unit = (r >> 11) * (1.0 / (1ULL << 53));
+		switch(kind % 4) {
+		case 0: input.mFloat = edges[r % (sizeof(edges)/sizeof(edges[0]))]; break;
+		case 1:
+		case 2: input.mFloat = unit * 200 - 100; break;
+		default: input.mFloat = unit * 2e6 - 1e6; break;
+		}
+		if(column.mInputType->isFloatTy())
+			input.mFloat = static_cast<float>(input.mFloat);
+		return input;
+	}
+	unsigned bits = column.mInputType->getIntegerBitWidth();
+	uint64_t max = bits >= 64 ? numeric_limits<int64_t>::max() : (1ULL << (bits-1)) - 1;
+	static const int64_t edges[] = {0, 1, -1};
+	switch(kind % 4) {
+	case 0:
+		if(r % 5 < 3)
+			input.mInt = truncateInt(edges[r % 5], bits);
+		else // The largest and smallest values of the type
+			input.mInt = truncateInt(r % 5 == 3 ? max : max + 1, bits);
+		break;
+	case 1:
+	case 2: input.mInt = truncateInt(r % 201 - 100, bits); break;
+	default: input.mInt = truncateInt(r, bits); break;
+	}
+	return input;
+}
+
+// The values tried when shrinking an input, simplest first.
+vector<InputValue> shrinkInput(const DataTable::Column& column, const InputValue& input)
+{
+	vector<InputValue> candidates;
+	InputValue candidate = input;
+	if(isFloatInput(column)) {
+		double v = input.mFloat;
+		if(v == 0)
+			return candidates;
+		candidate.mFloat = 0;
+		candidates.push_back(candidate);
+		if(std::isfinite(v) && std::trunc(v) != v) {
+			candidate.mFloat = std::trunc(v);
+			candidates.push_back(candidate);
+		}
+		if(std::isfinite(v) && v/2 != v) {
+			candidate.mFloat = v/2;
+			candidates.push_back(candidate);
+		}
+		if(v < 0) {
+			candidate.mFloat = -v;
+			candidates.push_back(candidate);
+		}
+		return candidates;
+	}
+	int64_t x = input.mInt;
+	if(x == 0)
+		return candidates;
+	candidate.mInt = 0;
+	candidates.push_back(candidate);
+	if(x < 0 && x != numeric_limits<int64_t>::min() &&
+	   truncateInt(-x, column.mInputType->getIntegerBitWidth()) == -x) {
+		candidate.mInt = -x;
+		candidates.push_back(candidate);
+	}
+	// x - x/2, x - x/4, ... x - 1: closer to x every time
+	for(int64_t d = x/2; d != 0; d /= 2) {
+		candidate.mInt = x - d;
+		candidates.push_back(candidate);
+	}
+	return candidates;
+}
+
+// Writes the value the generated code reads through the global of the input.
+// The host is little endian: an integer narrower than 64 bits is read from
+// the first bytes of the slot.
+void storeInput(DataTable* table, unsigned j, const InputValue& input)
+{
+	const DataTable::Column& column = table->getColumn(j);
+	uint64_t* slot = table->getInput(j);
+	*slot = 0;
+	if(column.mInputType->isFloatTy()) {
+		float f = input.mFloat;
+		memcpy(slot, &f, sizeof(f));
+	} else if(column.mInputType->isDoubleTy())
+		memcpy(slot, &input.mFloat, sizeof(input.mFloat));
+	else
+		memcpy(slot, &input.mInt, sizeof(input.mInt));
+}
+
+string inputToString(const DataTable::Column& column, const InputValue& input)
+{
+	stringstream ss;
+	if(isFloatInput(column))
+		ss << input.mFloat;
+	else
+		ss << input.mInt;
+	return ss.str();
+}
+
+// The function called with the given inputs and the expected result
+string getPropertyString(TestDefinition* TD, const vector<InputValue>& inputs)
+{
+	DataTable* table = TD->getDataTable();
+	FunctionCall* FC = TD->getTestFunction()->getFunctionCall();
+	ExpectedResult* ER = TD->getTestFunction()->getExpectedResult();
+	unsigned arg_count = FC->getDataPlaceholdersPos().size();
+	vector<string> values;
+	for(unsigned i = 0; i < arg_count; ++i) {
+		unsigned j = table->getPlaceholderColumn(i);
+		values.push_back(inputToString(table->getColumn(j), inputs[j]));
+	}
+	string str = FC->getFunctionCalledString(values);
+	if(ER) {
+		str += " " + ER->getComparisonOperator()->toString() + " ";
+		if(ER->isDataPlaceholder()) {
+			unsigned j = table->getPlaceholderColumn(arg_count);
+			str += inputToString(table->getColumn(j), inputs[j]);
+		} else
+			str += ER->getExpectedConstant()->getConstant()->toString();
+	}
+	return str;
+}
+
+} // anonymous namespace
+
+namespace {
+
+/// Every function the JIT compiles is an event in the trace, in the process
+/// that compiled it.
+class TraceJITListener : public llvm::JITEventListener {
+public:
+	void NotifyFunctionEmitted(const llvm::Function& F, void* code, size_t size,
+			const EmittedFunctionDetails& details) {
+		stringstream ss;
+		ss << "{\"bytes\": " << size << "}";
+		jcut::Trace::instant("jit", F.getName().str(), ss.str());
+	}
+};
+
+TraceJITListener TraceListener;
+
+} // anonymous namespace
+
+TestRunnerVisitor::TestRunnerVisitor(llvm::ExecutionEngine *EE, bool dump_func,
+		llvm::Module* mM) : mEE(EE), mDumpFunctions(dump_func), mModule(mM),
+		mResults(), mReporters() {
+	if(mEE && jcut::Trace::isEnabled())
+		mEE->RegisterJITEventListener(&TraceListener);
+}
 
 void TestRunnerVisitor::runFunction(LLVMFunctionHolder* FW) {
 	llvm::Function* f = FW->getLLVMFunction();
@@ -56,6 +256,11 @@ void TestRunnerVisitor::runFunction(LLVMFunctionHolder* FW) {
 	}
 }
 
+void TestRunnerVisitor::switchMockup(llvm::Function* F) {
+	jcut::Trace::Span span("mockup", F->getName().str());
+	mEE->runFunction(F, mArgs);
+}
+
 /// Executes the MockupFunctions stored in our stack, they are not discarded.
 void TestRunnerVisitor::executeMockupFunctionsOnTopOfStack() {
 	std::stack<llvm::Function*> backup;
@@ -63,7 +268,7 @@ void TestRunnerVisitor::executeMockupFunctionsOnTopOfStack() {
 	while(!mMockupRevert.empty() && mMockupRevert.top() != nullptr) {
 		llvm::Function* previous_group_mockup = mMockupRevert.top();
 		assert(previous_group_mockup && "Invalid group mockup function");
-		mEE->runFunction(previous_group_mockup,mArgs);
+		switchMockup(previous_group_mockup);
 		backup.push(previous_group_mockup);
 		mMockupRevert.pop();
 	}
@@ -81,13 +286,19 @@ void TestRunnerVisitor::VisitGroupMockup(GlobalMockup *GM) {
 	for(MockupFunction* m : mockups) {
 		llvm::Function* change_to_mockup = m->getMockupFunction();
 		assert(change_to_mockup && "Invalid group mockup function");
-			mEE->runFunction(change_to_mockup,mArgs);
+			switchMockup(change_to_mockup);
 			mMockupRevert.push(change_to_mockup);
 	}
 }
 
+void TestRunnerVisitor::VisitTestGroupFirst(TestGroup *TG) {
+	jcut::Trace::begin("group", TG->getGroupName());
+}
+
 void TestRunnerVisitor::VisitTestGroup(TestGroup *TG) {
 	runFunction(TG);
+	for(TestReporter* reporter : mReporters)
+		reporter->VisitTestGroup(TG);
 	const GlobalMockup *GM = TG->getGlobalMockup();
 	if(GM) {
 		while(mMockupRevert.top() != nullptr)
@@ -104,21 +315,496 @@ void TestRunnerVisitor::VisitTestGroup(TestGroup *TG) {
 			for(MockupFunction* m : mockups) {
 				llvm::Function* change_to_original = m->getOriginalFunction();
 				assert(change_to_original && "Invalid group mockup function");
-				mEE->runFunction(change_to_original,mArgs);
+				switchMockup(change_to_original);
 			}
 		}
 	}
+	jcut::Trace::end("group", TG->getGroupName());
+}
+
+
+
+llvm::GenericValue TestRunnerVisitor::getReturnValue(TestDefinition *TD,
+		const TestDriverResult& result) {
+	llvm::GenericValue rval;
+	llvm::Type* type = TD->getLLVMFunction()->getReturnType();
+	switch(type->getTypeID()) {
+		case llvm::Type::IntegerTyID:
+			rval.IntVal = llvm::APInt(type->getIntegerBitWidth(), result.int_value);
+			break;
+		case llvm::Type::FloatTyID:
+			rval.FloatVal = (float) result.fp_value;
+			break;
+		case llvm::Type::DoubleTyID:
+			rval.DoubleVal = result.fp_value;
+			break;
+		case llvm::Type::PointerTyID:
+			rval.PointerVal = result.ptr_value;
+			break;
+		default:
+			break;
+	}
+	return rval;
+}
+
+void TestRunnerVisitor::runTestDriver(TestDefinition *TD) {
+	llvm::Function* driver = TD->getDriverFunction();
+	if (mDumpFunctions) {
+		TD->getLLVMFunction()->dump();
+		driver->dump();
+	}
+	typedef void (*TestDriverFunction)(TestDriverResult*);
+	TestDriverFunction run_test =
+			(TestDriverFunction) mEE->getPointerToFunction(driver);
+	TestDriverResult result = {};
+
+	if(!StdCapture::BeginCapture())
+		cerr << "** There was a problem capturing test output!" << endl;
+	run_test(&result);
+	if(!StdCapture::EndCapture())
+		cerr << "** There was a problem finishing the test output capture!" << endl;
+	TD->setOutput(StdCapture::GetCapture());
+
+	TD->setReturnValue(getReturnValue(TD, result));
+	TD->setPassingValue(result.passed);
+
+	std::vector<ExpectedExpression*> failing;
+	const std::vector<ExpectedExpression*>& EEs = TD->getExpectedExpressions();
+	for(unsigned i = 0; i < EEs.size(); ++i)
+		if(result.failed_ee_mask & (1ULL << i))
+			failing.push_back(EEs[i]);
+	// Include failing ExpectedExpressions from before and after statements.
+	if(!failing.empty())
+		TD->setFailedExpectedExpressions(failing);
+}
+
+void TestRunnerVisitor::runBenchmark(TestDefinition *TD) {
+	llvm::Function* bench = TD->getBenchFunction();
+	if (mDumpFunctions)
+		bench->dump();
+	jcut::Trace::Span span("bench", bench->getName().str());
+	typedef void (*BenchFunction)(uint64_t);
+	BenchFunction run_bench = (BenchFunction) mEE->getPointerToFunction(bench);
+
+	// Millions of calls may print, nobody reads it
+	fflush(stdout);
+	fflush(stderr);
+	int null_fd = open("/dev/null", O_WRONLY);
+	int old_stdout = dup(fileno(stdout));
+	int old_stderr = dup(fileno(stderr));
+	if(null_fd != -1) {
+		dup2(null_fd, fileno(stdout));
+		dup2(null_fd, fileno(stderr));
+	}
+
+	// The calls of a batch take BenchBatchNanoseconds at least, the
+	// calibration is the first part of the warmup.
+	chrono::steady_clock::time_point bench_start = chrono::steady_clock::now();
+	auto isOverTime = [&bench_start]() {
+		return uint64_t(chrono::duration_cast<chrono::nanoseconds>(
+				chrono::steady_clock::now() - bench_start).count()) >= BenchMaxNanoseconds;
+	};
+	uint64_t calls = 1;
+	uint64_t nanoseconds = 0;
+	while(true) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		run_bench(calls);
+		nanoseconds = chrono::duration_cast<chrono::nanoseconds>(
+				chrono::steady_clock::now() - start).count();
+		if(nanoseconds >= BenchBatchNanoseconds || calls >= (1ULL << 40))
+			break;
+		calls *= 2;
+	}
+	for(unsigned i = 0; i < BenchWarmupBatches && !isOverTime(); ++i)
+		run_bench(calls);
+
+	vector<double> samples;
+	for(unsigned i = 0; i < BenchSamples && (i == 0 || !isOverTime()); ++i) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		run_bench(calls);
+		nanoseconds = chrono::duration_cast<chrono::nanoseconds>(
+				chrono::steady_clock::now() - start).count();
+		samples.push_back(double(nanoseconds) / calls);
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+	if(null_fd != -1) {
+		dup2(old_stdout, fileno(stdout));
+		dup2(old_stderr, fileno(stderr));
+		close(null_fd);
+	}
+	close(old_stdout);
+	close(old_stderr);
+
+	sort(samples.begin(), samples.end());
+	// The sample at the given percent of the sorted samples
+	auto percentile = [&samples](unsigned percent) {
+		unsigned i = (percent * samples.size() + 99) / 100;
+		return samples[i ? i - 1 : 0];
+	};
+	// With too few samples the percentile is the slowest sample
+	auto hasPercentile = [&samples](unsigned percent) {
+		return (percent * samples.size() + 99) / 100 < samples.size();
+	};
+	double mean = 0;
+	for(double sample : samples)
+		mean += sample;
+	mean /= samples.size();
+	double variance = 0;
+	for(double sample : samples)
+		variance += (sample - mean) * (sample - mean);
+	double stddev = sqrt(variance / samples.size());
+	// Outside the Tukey fences, 1.5 times the interquartile range
+	double q1 = percentile(25);
+	double q3 = percentile(75);
+	double iqr = q3 - q1;
+	unsigned outliers = 0;
+	for(double sample : samples)
+		if(sample < q1 - 1.5 * iqr || sample > q3 + 1.5 * iqr)
+			++outliers;
+
+	stringstream ss;
+	ss << fixed << setprecision(2);
+	ss << "[bench] " << TD->getTestFunction()->getFunctionCall()->getFunctionCalledString()
+	   << ": median " << percentile(50) << " ns/op";
+	if(hasPercentile(90))
+		ss << ", p90 " << percentile(90);
+	if(hasPercentile(99))
+		ss << ", p99 " << percentile(99);
+	else
+		ss << ", max " << samples.back();
+	ss << ", stddev " << stddev << ", " << outliers << " outliers in "
+	   << samples.size() << " samples of " << calls << " calls";
+	TD->setBenchmark(ss.str());
+}
+
+void TestRunnerVisitor::mapDataColumns(DataTable* table) {
+	for(unsigned j = 0; j < table->columnCount(); ++j) {
+		const DataTable::Column& column = table->getColumn(j);
+		if(column.mGlobal == nullptr)
+			continue;
+		// The columns of a binary data file are used straight from the mapping
+		if(column.isMapped())
+			mEE->addGlobalMapping(column.mGlobal,
+					const_cast<void*>(column.mFile->getColumnData(column.mFileColumn)));
+		else if(column.isInput())
+			mEE->addGlobalMapping(column.mGlobal, table->getInput(j));
+	}
+}
+
+void TestRunnerVisitor::saveGlobals(TestDefinition *TD) {
+	llvm::Function* save = TD->getSaveGlobalsFunction();
+	assert(save && "Data loop tests always save the globals of the module");
+	typedef void (*SaveGlobalsFunction)();
+	SaveGlobalsFunction save_globals =
+			(SaveGlobalsFunction) mEE->getPointerToFunction(save);
+	save_globals();
+}
+
+void TestRunnerVisitor::runDataLoop(TestDefinition *TD) {
+	DataTable* table = TD->getDataTable();
+	llvm::Function* driver = TD->getDriverFunction();
+	assert(driver && "Data loop tests always have a driver function");
+	if (mDumpFunctions) {
+		TD->getLLVMFunction()->dump();
+		driver->dump();
+	}
+	mapDataColumns(table);
+	typedef void (*TestDriverFunction)(TestDriverResult*);
+	TestDriverFunction run_test =
+			(TestDriverFunction) mEE->getPointerToFunction(driver);
+
+	saveGlobals(TD);
+
+	uint64_t rows = table->rowCount();
+	// The rows run in chunks, the bitmap of a chunk is reused by the next
+	// one. Only the first failing rows are kept to be reported.
+	std::vector<uint8_t> failed_rows(DataLoopChunkRows/8);
+	std::vector<uint64_t> reported_rows;
+	TestDriverResult result = {};
+	result.passed = 1;
+
+	// The output of the whole loop is discarded, a large data file would fill
+	// up the capture pipe. Only the output of the failing rows is reported.
+	fflush(stdout);
+	fflush(stderr);
+	int old_stdout = dup(fileno(stdout));
+	int old_stderr = dup(fileno(stderr));
+	int dev_null = open("/dev/null", O_WRONLY);
+	if(dev_null != -1) {
+		dup2(dev_null, fileno(stdout));
+		dup2(dev_null, fileno(stderr));
+	}
+	for(uint64_t begin = 0; begin < rows; begin += DataLoopChunkRows) {
+		TestDriverResult chunk = {};
+		chunk.row_begin = begin;
+		chunk.row_end = min(rows, begin + DataLoopChunkRows);
+		fill(failed_rows.begin(), failed_rows.end(), 0);
+		chunk.failed_rows = failed_rows.data();
+		run_test(&chunk);
+		result.passed = result.passed && chunk.passed;
+		result.failed_ee_mask |= chunk.failed_ee_mask;
+		result.failed_row_count += chunk.failed_row_count;
+		for(uint64_t row = begin; row < chunk.row_end &&
+				reported_rows.size() < MaxReportedRows; ++row)
+			if(failed_rows[(row-begin)/8] & (1 << (row-begin)%8))
+				reported_rows.push_back(row);
+	}
+	fflush(stdout);
+	fflush(stderr);
+	if(dev_null != -1) {
+		dup2(old_stdout, fileno(stdout));
+		dup2(old_stderr, fileno(stderr));
+		close(dev_null);
+	}
+	close(old_stdout);
+	close(old_stderr);
+
+	table->setFailedRowCount(result.failed_row_count);
+	TD->setPassingValue(result.passed);
+
+	std::vector<ExpectedExpression*> failing;
+	const std::vector<ExpectedExpression*>& EEs = TD->getExpectedExpressions();
+	for(unsigned i = 0; i < EEs.size(); ++i)
+		if(result.failed_ee_mask & (1ULL << i))
+			failing.push_back(EEs[i]);
+	if(!failing.empty())
+		TD->setFailedExpectedExpressions(failing);
+
+	// Run every failing row again to report it, it starts from the saved
+	// globals as it did in the loop.
+	FunctionCall* FC = TD->getTestFunction()->getFunctionCall();
+	ExpectedResult* ER = TD->getTestFunction()->getExpectedResult();
+	unsigned arg_columns = FC->getDataPlaceholdersPos().size();
+	stringstream ss;
+	for(uint64_t row : reported_rows) {
+		uint8_t failed_row = 0;
+		TestDriverResult row_result = {};
+		row_result.row_begin = row;
+		row_result.row_end = row+1;
+		row_result.failed_rows = &failed_row;
+		if(!StdCapture::BeginCapture())
+			cerr << "** There was a problem capturing test output!" << endl;
+		run_test(&row_result);
+		if(!StdCapture::EndCapture())
+			cerr << "** There was a problem finishing the test output capture!" << endl;
+		TD->setReturnValue(getReturnValue(TD, row_result));
+
+		vector<string> values;
+		for(unsigned j = 0; j < table->columnCount(); ++j)
+			values.push_back(table->getColumn(j).toString(row));
+		ss << "row " << row+1 << ": " << FC->getFunctionCalledString(values);
+		if(ER) {
+			ss << " " << ER->getComparisonOperator()->toString() << " ";
+			if(ER->isDataPlaceholder())
+				ss << values[arg_columns];
+			else
+				ss << ER->getExpectedConstant()->getConstant()->toString();
+		}
+		ss << " returned " << TestResults::getActualResultString(TD) << endl;
+		string output = StdCapture::GetCapture();
+		if(output.size())
+			ss << output << endl;
+	}
+	if(result.failed_row_count > reported_rows.size())
+		ss << "... " << (result.failed_row_count - reported_rows.size())
+		   << " more rows failed" << endl;
+	table->setFailedRows(ss.str());
 }
 
+void TestRunnerVisitor::runProperty(TestDefinition *TD) {
+	DataTable* table = TD->getDataTable();
+	llvm::Function* driver = TD->getDriverFunction();
+	assert(driver && "Properties always have a driver function");
+	if (mDumpFunctions) {
+		TD->getLLVMFunction()->dump();
+		driver->dump();
+	}
+	mapDataColumns(table);
+	typedef void (*TestDriverFunction)(TestDriverResult*);
+	TestDriverFunction run_test =
+			(TestDriverFunction) mEE->getPointerToFunction(driver);
+
+	// Every run is a data loop of a single row, the inputs are read from
+	// the slots of the table. The runs all start from the same globals.
+	saveGlobals(TD);
+	uint8_t failed_row = 0;
+	TestDriverResult result = {};
+	auto run = [&](const vector<InputValue>& inputs) -> bool {
+		for(unsigned j = 0; j < inputs.size(); ++j)
+			storeInput(table, j, inputs[j]);
+		failed_row = 0;
+		result = TestDriverResult();
+		result.row_begin = 0;
+		result.row_end = 1;
+		result.failed_rows = &failed_row;
+		run_test(&result);
+		return result.failed_row_count == 0;
+	};
+
+	uint64_t seed = PropertySeedOpt.getValue();
+	if(seed == 0)
+		seed = time(nullptr);
+	uint64_t counter = 0;
+	unsigned runs = 0;
+	unsigned max_runs = PropertyRunsOpt.getValue();
+	vector<InputValue> inputs(table->columnCount());
+	vector<InputValue> original;
+	unsigned shrinks = 0;
+
+	// The output of the search is discarded, only the output of the
+	// counterexample is reported.
+	fflush(stdout);
+	fflush(stderr);
+	int old_stdout = dup(fileno(stdout));
+	int old_stderr = dup(fileno(stderr));
+	int dev_null = open("/dev/null", O_WRONLY);
+	if(dev_null != -1) {
+		dup2(dev_null, fileno(stdout));
+		dup2(dev_null, fileno(stderr));
+	}
+	bool passed = true;
+	while(passed && runs < max_runs) {
+		for(unsigned j = 0; j < inputs.size(); ++j)
+			inputs[j] = randomInput(table->getColumn(j), seed, counter);
+		++runs;
+		passed = run(inputs);
+	}
+	if(!passed) {
+		original = inputs;
+		// Shrink one input at a time while the property keeps failing
+		unsigned shrink_runs = 0;
+		bool shrunk = true;
+		while(shrunk && shrink_runs < MaxShrinkRuns) {
+			shrunk = false;
+			for(unsigned j = 0; j < inputs.size() && !shrunk; ++j)
+				for(const InputValue& candidate : shrinkInput(table->getColumn(j), inputs[j])) {
+					if(shrink_runs == MaxShrinkRuns)
+						break;
+					vector<InputValue> tried = inputs;
+					tried[j] = candidate;
+					++shrink_runs;
+					if(!run(tried)) {
+						inputs = tried;
+						++shrinks;
+						shrunk = true;
+						break;
+					}
+				}
+		}
+	}
+	fflush(stdout);
+	fflush(stderr);
+	if(dev_null != -1) {
+		dup2(old_stdout, fileno(stdout));
+		dup2(old_stderr, fileno(stderr));
+		close(dev_null);
+	}
+	close(old_stdout);
+	close(old_stderr);
+
+	table->setRowCount(runs);
+	table->setFailedRowCount(passed ? 0 : 1);
+	TD->setPassingValue(passed);
+	if(passed)
+		return;
+
+	// Run the counterexample again to report its result and output
+	if(!StdCapture::BeginCapture())
+		cerr << "** There was a problem capturing test output!" << endl;
+	run(inputs);
+	if(!StdCapture::EndCapture())
+		cerr << "** There was a problem finishing the test output capture!" << endl;
+	TD->setReturnValue(getReturnValue(TD, result));
 
+	std::vector<ExpectedExpression*> failing;
+	const std::vector<ExpectedExpression*>& EEs = TD->getExpectedExpressions();
+	for(unsigned i = 0; i < EEs.size(); ++i)
+		if(result.failed_ee_mask & (1ULL << i))
+			failing.push_back(EEs[i]);
+	if(!failing.empty())
+		TD->setFailedExpectedExpressions(failing);
+
+	stringstream ss;
+	ss << "falsified after " << runs << " runs (--property-seed=" << seed << "): "
+	   << getPropertyString(TD, inputs)
+	   << " returned " << TestResults::getActualResultString(TD) << endl;
+	if(shrinks)
+		ss << "shrunk " << shrinks << " times from " << getPropertyString(TD, original) << endl;
+	string output = StdCapture::GetCapture();
+	if(output.size())
+		ss << output << endl;
+	table->setFailedRows(ss.str());
+}
+
+void TestRunnerVisitor::runTestFunctions(TestDefinition *TD) {
+	if(TD->hasTestMockup()) {
+		vector<MockupFunction*> mockups=
+			TD->getTestMockup()->getMockupFixture()->getMockupFunctions();
+
+		for(MockupFunction* m : mockups) {
+			llvm::Function* change_to_mockup = m->getMockupFunction();
+			switchMockup(change_to_mockup);
+		}
+	}
+
+	runFunction(TD);
+
+	llvm::Function* func = TD->getLLVMResultFunction();
+	if(!func)
+		assert(false && "Function test result not found!");
+	llvm::GenericValue ret = mEE->runFunction(func, mArgs);
+	TD->setPassingValue(ret.IntVal.getBoolValue());
+
+	std::vector<ExpectedExpression*> failing;
+	for(ExpectedExpression* ptr : TD->getExpectedExpressions()) {
+		llvm::Function* ee_func = ptr->getLLVMResultFunction();
+		if(!ee_func)
+			assert(false && "Function expected result result not found!");
+		llvm::GenericValue ee_ret = mEE->runFunction(ee_func, mArgs);
+		bool passed = ee_ret.IntVal.getBoolValue();
+		if(passed == false)
+			failing.push_back(ptr);
+	}
+
+	// Do the opposite steps for the Mockups
+	if(TD->hasTestMockup()) {
+		vector<MockupFunction*> mockups =
+			TD->getTestMockup()->getMockupFixture()->getMockupFunctions();
+		for(MockupFunction* m : mockups) {
+			llvm::Function* change_to_original = m->getOriginalFunction();
+			switchMockup(change_to_original);
+		}
+
+		////////////////////////////////////////////////
+		// Point to the mockup functions for the current group
+		executeMockupFunctionsOnTopOfStack();
+	}
+
+	// Include failing ExpectedExpressions from before and after statements.
+	if(!failing.empty())
+		TD->setFailedExpectedExpressions(failing);
+}
 
 // The test definition
 void TestRunnerVisitor::VisitTestDefinition(TestDefinition *TD) {
-	TestResults results(mOrder);
-	results.mColumnNames = mColumnNames;
+	TestResults& results = mResults;
+	results.reset(TD);
 	results.using_fork = !NoForkOpt.getValue();
 	string test_name = TestResults::getColumnString(TEST_NAME, TD);
 	results.mTmpFileName = test_name + "-tmp.txt";
+	// Compiled before the fork so the report tells it from running the
+	// test, the functions it calls are still compiled on their first call.
+	if((jcut::TimeReport::isEnabled() || jcut::Trace::isEnabled()) &&
+			TD->getDriverFunction()) {
+		jcut::TimeReport::Timer timer(jcut::TimeReport::JIT, getSourceFile());
+		jcut::Trace::Span span("jit", TD->getDriverFunction()->getName().str());
+		mEE->getPointerToFunction(TD->getDriverFunction());
+	}
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	jcut::TimeReport::Timer timer(jcut::TimeReport::TEST_RUN, getSourceFile());
+	jcut::Trace::Span span("test", test_name);
 	pid_t pid;
 
 	if(NoForkOpt.getValue() == false) {
@@ -129,6 +815,15 @@ void TestRunnerVisitor::VisitTestDefinition(TestDefinition *TD) {
 		if(pipe(results.mPipe) == -1)
 			throw JCUTException("Could not create pipes for communication with the test "+test_name);
 
+		// The test process gets a copy of every buffer, what is still
+		// buffered would be written by both processes.
+		for(TestReporter* reporter : mReporters)
+			reporter->flush();
+		cout.flush();
+		cerr.flush();
+		llvm::outs().flush();
+		fflush(stdout);
+		fflush(stderr);
 		pid = fork();
 #endif
 		if(pid == -1)
@@ -138,60 +833,27 @@ void TestRunnerVisitor::VisitTestDefinition(TestDefinition *TD) {
 		pid = 0;
 
 	if(pid == 0) { // Child process will execute the test
-		if(TD->hasTestMockup()) {
-			vector<MockupFunction*> mockups=
-				TD->getTestMockup()->getMockupFixture()->getMockupFunctions();
-
-			for(MockupFunction* m : mockups) {
-				llvm::Function* change_to_mockup = m->getMockupFunction();
-				mEE->runFunction(change_to_mockup,mArgs);
-			}
-		}
-
-		runFunction(TD);
-
-		llvm::Function* func = TD->getLLVMResultFunction();
-		if(!func)
-			assert(false && "Function test result not found!");
-		llvm::GenericValue ret = mEE->runFunction(func, mArgs);
-		TD->setPassingValue(ret.IntVal.getBoolValue());
-
-		std::vector<ExpectedExpression*> failing;
-		// @bug @todo Debug ExpectedExpressions: Try all possible combinations.
-		// When the test does not have an expected result and the expected expression
-		// should fail, it always passess.
-		for(ExpectedExpression* ptr : mExpExpr) {
-			llvm::Function* ee_func = ptr->getLLVMResultFunction();
-			if(!ee_func)
-				assert(false && "Function expected result result not found!");
-			llvm::GenericValue ee_ret = mEE->runFunction(ee_func, mArgs);
-			bool passed = ee_ret.IntVal.getBoolValue();
-			if(passed == false)
-				failing.push_back(ptr);
-			TD->setPassingValue(passed);
-		}
-		mExpExpr.clear();
-
-		// Do the opposite steps for the Mockups
-		if(TD->hasTestMockup()) {
-			vector<MockupFunction*> mockups =
-				TD->getTestMockup()->getMockupFixture()->getMockupFunctions();
-			for(MockupFunction* m : mockups) {
-				llvm::Function* change_to_original = m->getOriginalFunction();
-				mEE->runFunction(change_to_original,mArgs);
-			}
-
-			////////////////////////////////////////////////
-			// Point to the mockup functions for the current group
-			executeMockupFunctionsOnTopOfStack();
-		}
-
-		// Include failing ExpectedExpressions from before and after statements.
-		if(!failing.empty())
-			TD->setFailedExpectedExpressions(failing);
+		// A test process gets its own track in the trace
+		if(NoForkOpt.getValue() == false)
+			jcut::Trace::setProcessName("test "+test_name);
+		jcut::Trace::Span child_span("run test", test_name);
+		if(TD->getDataTable() && TD->getDataTable()->isProperty())
+			runProperty(TD);
+		else if(TD->getDataTable())
+			runDataLoop(TD);
+		else if(TD->getDriverFunction())
+			runTestDriver(TD);
+		else
+			runTestFunctions(TD);
+		// A failed test is not timed, its calls do not do what they should
+		if(TD->getBenchFunction() &&
+		   TestResults::getColumnString(RESULT, TD) == "PASSED")
+			runBenchmark(TD);
 
-		results.collectTestResults(TD);
+		results.collectTestResults();
 		results.saveToDisk();
+		// _Exit does not end it
+		child_span.end();
 
 		if(NoForkOpt.getValue() == false)
 #ifdef __MINGW32__
@@ -225,8 +887,12 @@ void TestRunnerVisitor::VisitTestDefinition(TestDefinition *TD) {
 #endif
 	}
 
-	results.mResults = results.readFromDisk();
-	TD->setTestResults(results.mResults);
+	timer.next(jcut::TimeReport::RESULT_TRANSFER);
+	results.readFromDisk();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	timer.next(jcut::TimeReport::REPORTING);
+	for(TestReporter* reporter : mReporters)
+		reporter->testFinished(TD, results, seconds);
 }
 
 
@@ -34,6 +34,7 @@
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/Support/raw_ostream.h"
 #include "OSRedirect.h"
+#include "TestReporter.h"
 #include <cstdlib>
 
 
@@ -45,52 +46,111 @@ private:
     std::vector<llvm::GenericValue> mArgs;//Dummy arguments
     bool mDumpFunctions;
     llvm::Module* mModule;
-    // Temp vector to hold failed expected expressions
-    std::vector<ExpectedExpression*> mExpExpr;
     /// Used to properly revert the mockup replacements for nested groups.
     /// Every time we enter in a group we store all of its MoclupFunctions
     /// in the stack. This used by individual tests and when returning to a
     /// different group.
     std::stack<llvm::Function*> mMockupRevert;
-    // The order in which we will store the results.
-    vector<ColumnName> mOrder;
-    map<ColumnName,string> mColumnNames;
+    /// The results of the test that ran last, reused by every test.
+    TestResults mResults;
+    /// Get the results of every test as soon as it ran, they are not kept.
+    vector<TestReporter*> mReporters;
 
     void runFunction(LLVMFunctionHolder* FW);
 
+    /// Runs the test with a single call to the driver function created by the
+    /// TestGeneratorVisitor.
+    void runTestDriver(TestDefinition* TD);
+
+    /// Runs the mockups, the test and each of its result functions one by
+    /// one. Used when the test has no driver function.
+    void runTestFunctions(TestDefinition* TD);
+
+    /// Runs all the rows of a test in data loop mode with a single call to its
+    /// driver function. Then every failing row is run again on its own to
+    /// report its actual result and output. Every row starts from the globals
+    /// of the module as they were before the loop.
+    void runDataLoop(TestDefinition* TD);
+
+    /// Runs a property with random inputs until it fails or --property-runs
+    /// runs passed. The inputs of the first failing run are shrunk to the
+    /// simplest values that still fail, those are reported.
+    void runProperty(TestDefinition* TD);
+
+    /// Calls the benchmark function of --bench in batches of a calibrated
+    /// number of calls and stores the nanoseconds per call of the samples in
+    /// the test. The output of the calls is discarded. Only called in the
+    /// process of a test that passed, --bench is refused with --no-fork.
+    void runBenchmark(TestDefinition* TD);
+
+    /// Saves the writable globals of the module, the driver of a data loop
+    /// test restores them before every row.
+    void saveGlobals(TestDefinition* TD);
+
+    /// Maps the columns read from memory by the driver of a data loop test
+    /// to the place their values are stored.
+    void mapDataColumns(DataTable* table);
+
+    /// Builds the value runFunction() would have returned for the test.
+    llvm::GenericValue getReturnValue(TestDefinition* TD, const TestDriverResult& result);
+
+    /// Maximum number of failing rows reported for a data loop test.
+    static const unsigned MaxReportedRows = 100;
+
+    /// Rows of a data loop test run by each call to its driver function,
+    /// the bitmap of the failing rows is this size in bits.
+    static const uint64_t DataLoopChunkRows = 1 << 16;
+
+    /// Maximum number of runs spent shrinking the inputs of a failing property.
+    static const unsigned MaxShrinkRuns = 10000;
+
+    /// A batch of --bench calls is timed once it takes this many nanoseconds.
+    static const uint64_t BenchBatchNanoseconds = 5000000;
+
+    /// Untimed batches run before the samples of --bench.
+    static const unsigned BenchWarmupBatches = 3;
+
+    /// Number of batches timed by --bench.
+    static const unsigned BenchSamples = 31;
+
+    /// The warmup and the samples of --bench stop after this many
+    /// nanoseconds, with at least one sample.
+    static const uint64_t BenchMaxNanoseconds = 2000000000;
+
     /// Executes the MockupFunctions stored in our stack, they are not discarded.
     void executeMockupFunctionsOnTopOfStack();
 
+    /// Runs the function that points the callers of a function to its
+    /// mockup, or back to the original.
+    void switchMockup(llvm::Function* F);
+
 public:
     TestRunnerVisitor() = delete;
     TestRunnerVisitor(const TestRunnerVisitor& orig) = delete;
     TestRunnerVisitor(llvm::ExecutionEngine *EE, bool dump_func = false,
-    		llvm::Module* mM=nullptr) : mEE(EE),
-    		mDumpFunctions(dump_func), mModule(mM) {}
+    		llvm::Module* mM=nullptr);
     virtual ~TestRunnerVisitor() { delete mEE; }
 
     bool isValidExecutionEngine() const { return mEE != nullptr; }
-    void setColumnOrder(const vector<ColumnName>& order) { mOrder = order;}
-    void setColumnNames(const map<ColumnName,string>& names) { mColumnNames = names;}
+    void addReporter(TestReporter* reporter) { mReporters.push_back(reporter); }
     void VisitGroupMockup(GlobalMockup *GM);
 
     void VisitGroupSetup(GlobalSetup *GS) {
         runFunction(GS);
+        for(TestReporter* reporter : mReporters)
+            reporter->VisitGroupSetup(GS);
     }
 
     void VisitGroupTeardown(GlobalTeardown *GT) {
         runFunction(GT);
+        for(TestReporter* reporter : mReporters)
+            reporter->VisitGroupTeardown(GT);
     }
 
     // The cleanup
+    void VisitTestGroupFirst(TestGroup *TG);
     void VisitTestGroup(TestGroup *TG);
 
-    // ExpectedExpressions can be located either in any of after/before or
-    // after_all/before_all statements
-    void VisitExpectedExpression(ExpectedExpression* EE) {
-    	mExpExpr.push_back(EE);
-    }
-
     // The test definition
     void VisitTestDefinition(TestDefinition *TD);
 };
@@ -0,0 +1,238 @@
+//===-- jcut/TimeReport.cpp - Time taken by each phase of a run -*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "TimeReport.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+#include "TestParser.h"
+
+namespace jcut {
+
+bool TimeReport::mEnabled = false;
+mutex TimeReport::mMutex;
+map<pair<TimeReport::Phase, string>, TimeReport::Entry> TimeReport::mEntries;
+
+namespace {
+
+string escape(const string& str)
+{
+	stringstream ss;
+	ss << '"';
+	for(char c : str) {
+		if(c == '"' || c == '\\')
+			ss << '\\' << c;
+		else if(static_cast<unsigned char>(c) < 0x20)
+			ss << "\\u" << hex << setw(4) << setfill('0') << int(c)
+			   << dec << setfill(' ');
+		else
+			ss << c;
+	}
+	ss << '"';
+	return ss.str();
+}
+
+} // anonymous namespace
+
+const char* TimeReport::getPhaseName(Phase phase)
+{
+	switch(phase) {
+		case SYNTAX_CHECK: return "clang syntax check";
+		case COMPILE: return "clang and LLVM IR";
+		case PLAN_CACHE: return "plan cache";
+		case TOKENIZE: return "tokenize tests";
+		case PARSE: return "parse tests";
+		case DATA_EXPANSION: return "data files";
+		case IR_GENERATION: return "generate tests IR";
+		case JIT: return "JIT";
+		case TEST_RUN: return "run tests";
+		case RESULT_TRANSFER: return "transfer results";
+		case REPORTING: return "report results";
+		default: return "unknown";
+	}
+}
+
+void TimeReport::add(Phase phase, const string& file, double seconds)
+{
+	lock_guard<mutex> lock(mMutex);
+	Entry& entry = mEntries[make_pair(phase, file)];
+	++entry.mCount;
+	entry.mTotal += seconds;
+	if(seconds > entry.mMax)
+		entry.mMax = seconds;
+}
+
+void TimeReport::print(ostream& out)
+{
+	lock_guard<mutex> lock(mMutex);
+	double total = 0;
+	out << "Time report\n";
+	out << left << setw(20) << "Phase" << right << setw(8) << "Count"
+		<< setw(12) << "Total ms" << setw(10) << "Max ms" << "  File\n";
+	out << fixed << setprecision(3);
+	for(const auto& it : mEntries) {
+		const Entry& entry = it.second;
+		total += entry.mTotal;
+		out << left << setw(20) << getPhaseName(it.first.first) << right
+			<< setw(8) << entry.mCount << setw(12) << entry.mTotal * 1000
+			<< setw(10) << entry.mMax * 1000 << "  " << it.first.second << "\n";
+	}
+	out << left << setw(28) << "Total" << right << setw(12) << total * 1000 << "\n";
+	out.unsetf(ios::floatfield);
+	out.flush();
+}
+
+void TimeReport::writeJSON(const string& path)
+{
+	ofstream out(path.c_str(), ios::out | ios::trunc);
+	if(!out)
+		throw JCUTException("Could not open the time report "+path+" for writing");
+	lock_guard<mutex> lock(mMutex);
+	out << "{\"phases\": [";
+	out << fixed << setprecision(6);
+	bool first = true;
+	for(const auto& it : mEntries) {
+		const Entry& entry = it.second;
+		out << (first ? "\n" : ",\n");
+		first = false;
+		out << "{\"phase\": " << escape(getPhaseName(it.first.first))
+			<< ", \"file\": " << escape(it.first.second)
+			<< ", \"count\": " << entry.mCount
+			<< ", \"total_ms\": " << entry.mTotal * 1000
+			<< ", \"max_ms\": " << entry.mMax * 1000 << "}";
+	}
+	out << "\n]}\n";
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int Trace::mFd = -1;
+
+uint64_t Trace::now()
+{
+	return chrono::duration_cast<chrono::microseconds>(
+			chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::write(const string& event)
+{
+	if(mFd == -1)
+		return;
+	// One write, the events of the processes are not mixed
+	string line = ",\n" + event;
+	if(::write(mFd, line.data(), line.size()) != ssize_t(line.size()))
+		cerr << "The trace could not be written: " << strerror(errno) << endl;
+}
+
+void Trace::open(const string& path)
+{
+	mFd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0666);
+	if(mFd == -1)
+		throw JCUTException("Could not open the trace "+path+" for writing");
+	// The first event has no comma before it
+	stringstream ss;
+	ss << "[\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << getpid()
+	   << ", \"tid\": " << getpid() << ", \"args\": {\"name\": \"jcut\"}}";
+	string first = ss.str();
+	if(::write(mFd, first.data(), first.size()) != ssize_t(first.size()))
+		throw JCUTException("Could not write the trace "+path);
+}
+
+void Trace::close()
+{
+	if(mFd == -1)
+		return;
+	const char end[] = "\n]\n";
+	if(::write(mFd, end, sizeof(end) - 1) != sizeof(end) - 1)
+		cerr << "The trace could not be written: " << strerror(errno) << endl;
+	::close(mFd);
+	mFd = -1;
+}
+
+void Trace::complete(const char* category, const string& name,
+		uint64_t start, uint64_t duration)
+{
+	stringstream ss;
+	ss << "{\"name\": " << escape(name) << ", \"cat\": \"" << category
+	   << "\", \"ph\": \"X\", \"ts\": " << start << ", \"dur\": " << duration
+	   << ", \"pid\": " << getpid() << ", \"tid\": " << getpid() << "}";
+	write(ss.str());
+}
+
+void Trace::begin(const char* category, const string& name)
+{
+	if(mFd == -1)
+		return;
+	stringstream ss;
+	ss << "{\"name\": " << escape(name) << ", \"cat\": \"" << category
+	   << "\", \"ph\": \"B\", \"ts\": " << now() << ", \"pid\": " << getpid()
+	   << ", \"tid\": " << getpid() << "}";
+	write(ss.str());
+}
+
+void Trace::end(const char* category, const string& name)
+{
+	if(mFd == -1)
+		return;
+	stringstream ss;
+	ss << "{\"name\": " << escape(name) << ", \"cat\": \"" << category
+	   << "\", \"ph\": \"E\", \"ts\": " << now() << ", \"pid\": " << getpid()
+	   << ", \"tid\": " << getpid() << "}";
+	write(ss.str());
+}
+
+void Trace::instant(const char* category, const string& name, const string& args)
+{
+	if(mFd == -1)
+		return;
+	stringstream ss;
+	ss << "{\"name\": " << escape(name) << ", \"cat\": \"" << category
+	   << "\", \"ph\": \"i\", \"s\": \"t\", \"ts\": " << now()
+	   << ", \"pid\": " << getpid() << ", \"tid\": " << getpid()
+	   << ", \"args\": " << args << "}";
+	write(ss.str());
+}
+
+void Trace::setProcessName(const string& name)
+{
+	if(mFd == -1)
+		return;
+	stringstream ss;
+	ss << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << getpid()
+	   << ", \"tid\": " << getpid() << ", \"args\": {\"name\": " << escape(name) << "}}";
+	write(ss.str());
+}
+
+} /* namespace jcut */
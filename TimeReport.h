@@ -0,0 +1,187 @@
+//===-- jcut/TimeReport.h - Time taken by each phase of a run ---*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief The times of --time-report and the trace of --trace.
+///
+/// Every phase is measured for each file it works on: the C source files
+/// for clang, the LLVM IR of the tests and running them, the test files for
+/// the tokenizer, the parser and the copies made for the rows of the data
+/// files. Without --time-report a Timer only checks a flag.
+///
+/// --trace=file writes the events of the run in the trace event format of
+/// chrome://tracing and Perfetto. Every event is written as it ends, with a
+/// single write to a file opened for appending, so the process of a test
+/// writes its own events to the same file, in the track of its pid.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TIMEREPORT_H_
+#define TIMEREPORT_H_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+namespace jcut {
+
+class TimeReport {
+public:
+	enum Phase {
+		SYNTAX_CHECK,	///< clang on a source file, without the LLVM IR
+		COMPILE,		///< clang on a source file, with the LLVM IR
+		PLAN_CACHE,		///< Reading and writing the --plan-cache
+		TOKENIZE,
+		PARSE,
+		DATA_EXPANSION,	///< The copies and the tables of the data files
+		IR_GENERATION,	///< The LLVM IR of the tests
+		JIT,			///< The execution engine and the code of the tests
+		TEST_RUN,		///< fork, the test and waiting for it
+		RESULT_TRANSFER,///< The results sent by the test process
+		REPORTING,		///< The reporters and the reports of --report
+		MAX_PHASE
+	};
+
+	/// Adds the time from its construction to its destruction to a phase
+	class Timer {
+	private:
+		Phase mPhase;
+		string mFile;
+		chrono::steady_clock::time_point mStart;
+		bool mRunning;
+	public:
+		Timer(Phase phase, const string& file) : mPhase(phase), mFile(),
+				mStart(), mRunning(mEnabled) {
+			if(mRunning) {
+				mFile = file;
+				mStart = chrono::steady_clock::now();
+			}
+		}
+		~Timer() { stop(); }
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+
+		/// Ends the current phase and starts the next one on the same file
+		void next(Phase phase) {
+			if(mRunning == false)
+				return;
+			stop();
+			mPhase = phase;
+			mRunning = true;
+			mStart = chrono::steady_clock::now();
+		}
+		void stop() {
+			if(mRunning == false)
+				return;
+			mRunning = false;
+			add(mPhase, mFile, chrono::duration<double>(
+					chrono::steady_clock::now() - mStart).count());
+		}
+	};
+
+	static void enable() { mEnabled = true; }
+	static bool isEnabled() { return mEnabled; }
+
+	static void add(Phase phase, const string& file, double seconds);
+	/// A table with the phases in the order they run
+	static void print(ostream& out);
+	/// Throws a JCUTException when the file can not be written
+	static void writeJSON(const string& path);
+private:
+	struct Entry {
+		unsigned mCount;
+		double mTotal;
+		double mMax;
+	};
+
+	static bool mEnabled;
+	// The test files are parsed by several threads
+	static mutex mMutex;
+	static map<pair<Phase, string>, Entry> mEntries;
+
+	static const char* getPhaseName(Phase phase);
+};
+
+class Trace {
+public:
+	/// A complete event from its construction to end()
+	class Span {
+	private:
+		const char* mCategory;
+		string mName;
+		uint64_t mStart;
+		bool mRunning;
+	public:
+		Span(const char* category, const string& name) : mCategory(category),
+				mName(), mStart(0), mRunning(isEnabled()) {
+			if(mRunning) {
+				mName = name;
+				mStart = now();
+			}
+		}
+		~Span() { end(); }
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+
+		/// Called by a test process before it exits without unwinding
+		void end() {
+			if(mRunning == false)
+				return;
+			mRunning = false;
+			complete(mCategory, mName, mStart, now() - mStart);
+		}
+	};
+
+	/// Truncates the file and writes the first event, throws a
+	/// JCUTException when it can not be written.
+	static void open(const string& path);
+	/// Closes the array of events, the processes of the tests are gone
+	static void close();
+	static bool isEnabled() { return mFd != -1; }
+
+	/// The start and the end of an event that does not fit in a scope
+	static void begin(const char* category, const string& name);
+	static void end(const char* category, const string& name);
+	/// An event without duration, args is a JSON object
+	static void instant(const char* category, const string& name,
+			const string& args = "{}");
+	/// Names the track of this process
+	static void setProcessName(const string& name);
+private:
+	static int mFd;
+
+	/// Microseconds of the monotonic clock, the same in every process
+	static uint64_t now();
+	static void complete(const char* category, const string& name,
+			uint64_t start, uint64_t duration);
+	static void write(const string& event);
+};
+
+} /* namespace jcut */
+
+#endif /* TIMEREPORT_H_ */
@@ -29,6 +29,8 @@
 #ifndef VISITOR_H
 #define	VISITOR_H
 
+#include <string>
+
 namespace tp { // tp stands for test parser
 
 // Forward declarations
@@ -52,11 +54,13 @@ class CharConstant;
 class ComparisonOperator;
 class Operand;
 class TestData;
+class DataGenerator;
 class TestTeardown;
 class TestFunction;
 class TestSetup;
 class TestFixture;
 class MockupVariable;
+class MockupSequence;
 class MockupFunction;
 class MockupFixture;
 class TestMockup;
@@ -68,11 +72,18 @@ class GlobalTeardown;
 class TestFile;
 
 class Visitor {
+private:
+    /// When set only the tests of the functions defined in this C source
+    /// file, and the groups containing them, are visited.
+    std::string mSourceFile;
 public:
 
     Visitor() {}
     Visitor(const Visitor& orig) = delete;
 
+    void setSourceFile(const std::string& file) { mSourceFile = file; }
+    const std::string& getSourceFile() const { return mSourceFile; }
+
     /*
      * The following methods visit each node in the object structure in a
      * post-order fashion, meaning that all the children of a given node are
@@ -101,8 +112,10 @@ public:
     virtual void VisitTestSetup(TestSetup *) {}
     virtual void VisitTestFixture(TestFixture *) {}
     virtual void VisitMockupVariable(MockupVariable *) {}
+    virtual void VisitMockupSequence(MockupSequence *) {}
     virtual void VisitMockupFunction(MockupFunction *) {}
     virtual void VisitMockupFixture(MockupFixture *) {}
+    virtual void VisitDataGenerator(DataGenerator* ) {}
     virtual void VisitTestInfo(TestData* ) {}
     virtual void VisitTestMockup(TestMockup *) {}
     virtual void VisitTestDefinition(TestDefinition *) {}
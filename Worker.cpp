@@ -0,0 +1,769 @@
+//===-- jcut/Worker.cpp - jcut --workers and jcut --worker ------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+#include "Worker.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "TestParser.h"
+#include "TestArena.h"
+#include "PlanCache.h"
+#include "TestGeneratorVisitor.h"
+#include "TestRunnerVisitor.h"
+#include "TimeReport.h"
+
+// Sent to the workers, the options of their own command line are not used
+extern llvm::cl::opt<bool> NoForkOpt;
+extern llvm::cl::opt<unsigned> PropertyRunsOpt;
+extern llvm::cl::opt<unsigned> PropertySeedOpt;
+
+namespace jcut {
+
+namespace {
+
+/// Writes the data of a frame
+class FrameWriter {
+private:
+	string mData;
+public:
+	const string& getData() const { return mData; }
+
+	void u8(uint8_t value) { mData.append(reinterpret_cast<const char*>(&value), 1); }
+	void u32(uint32_t value) { mData.append(reinterpret_cast<const char*>(&value), 4); }
+	void f64(double value) { mData.append(reinterpret_cast<const char*>(&value), 8); }
+	void str(const string& s) {
+		u32(s.size());
+		mData += s;
+	}
+	void tests(const vector<uint32_t>& indexes) {
+		u32(indexes.size());
+		for(uint32_t index : indexes)
+			u32(index);
+	}
+};
+
+/// Reads the data of a frame, throws a JCUTException when it is too short
+class FrameReader {
+private:
+	const string& mData;
+	size_t mPos;
+
+	void read(void* value, size_t size) {
+		if(mData.size() - mPos < size)
+			throw JCUTException("A message of jcut --workers is truncated");
+		memcpy(value, mData.data() + mPos, size);
+		mPos += size;
+	}
+public:
+	explicit FrameReader(const string& data) : mData(data), mPos(0) {}
+
+	uint8_t u8() { uint8_t value; read(&value, 1); return value; }
+	uint32_t u32() { uint32_t value; read(&value, 4); return value; }
+	double f64() { double value; read(&value, 8); return value; }
+	string str() {
+		uint32_t size = u32();
+		if(mData.size() - mPos < size)
+			throw JCUTException("A message of jcut --workers is truncated");
+		string s(mData, mPos, size);
+		mPos += size;
+		return s;
+	}
+	/// A count of elements of at least a byte
+	uint32_t count() {
+		uint32_t n = u32();
+		if(mData.size() - mPos < n)
+			throw JCUTException("A message of jcut --workers is truncated");
+		return n;
+	}
+	vector<uint32_t> tests() {
+		uint32_t count = u32();
+		if((mData.size() - mPos) / 4 < count)
+			throw JCUTException("A message of jcut --workers is truncated");
+		vector<uint32_t> indexes(count);
+		for(uint32_t& index : indexes)
+			index = u32();
+		return indexes;
+	}
+};
+
+const size_t FrameHeaderSize = 5;
+
+bool sendFrame(int fd, char type, const string& data)
+{
+	string frame(1, type);
+	uint32_t size = data.size();
+	frame.append(reinterpret_cast<const char*>(&size), 4);
+	frame += data;
+	size_t written = 0;
+	while(written < frame.size()) {
+		// A peer that went away is an error, not a SIGPIPE
+		ssize_t rc = send(fd, frame.data() + written, frame.size() - written,
+				MSG_NOSIGNAL);
+		if(rc == -1 && errno == EINTR)
+			continue;
+		if(rc <= 0)
+			return false;
+		written += rc;
+	}
+	return true;
+}
+
+/// Takes the first frame out of buffer, false when it is not complete yet
+bool takeFrame(string& buffer, char& type, string& data)
+{
+	if(buffer.size() < FrameHeaderSize)
+		return false;
+	uint32_t size;
+	memcpy(&size, buffer.data() + 1, 4);
+	if(buffer.size() - FrameHeaderSize < size)
+		return false;
+	type = buffer[0];
+	data.assign(buffer, FrameHeaderSize, size);
+	buffer.erase(0, FrameHeaderSize + size);
+	return true;
+}
+
+/// Waits for the next frame, false when the connection was closed or the
+/// frame is bigger than max_size
+bool readFrame(int fd, string& buffer, char& type, string& data,
+		uint32_t max_size = UINT32_MAX)
+{
+	char buf[64*1024];
+	while(takeFrame(buffer, type, data) == false) {
+		if(buffer.size() >= FrameHeaderSize) {
+			uint32_t size;
+			memcpy(&size, buffer.data() + 1, 4);
+			if(size > max_size)
+				return false;
+		}
+		ssize_t rc = read(fd, buf, sizeof(buf));
+		if(rc == -1 && errno == EINTR)
+			continue;
+		if(rc <= 0)
+			return false;
+		buffer.append(buf, rc);
+	}
+	return true;
+}
+
+/// The shared secret of --worker-token, the whole file but the whitespace
+/// that ends it
+string readToken(const string& path)
+{
+	if(path.empty())
+		throw JCUTException("jcut --worker runs the code it is sent, --worker "
+				"and --workers need the file of a shared secret with --worker-token");
+	ifstream file(path.c_str(), ios::binary);
+	if(!file)
+		throw JCUTException("Could not read the token file "+path);
+	string token((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	while(token.size() && isspace(static_cast<unsigned char>(token.back())))
+		token.erase(token.size() - 1);
+	if(token.empty())
+		throw JCUTException("The token file "+path+" is empty");
+	return token;
+}
+
+string md5(const string& data)
+{
+	llvm::MD5 hash;
+	hash.update(llvm::StringRef(data));
+	llvm::MD5::MD5Result result;
+	hash.final(result);
+	return string(reinterpret_cast<const char*>(&result[0]), 16);
+}
+
+/// HMAC-MD5 of the challenge of a worker with the token, the token itself
+/// never goes through the network
+string answerChallenge(const string& token, const string& challenge)
+{
+	const size_t BlockSize = 64;
+	string key = token.size() > BlockSize ? md5(token) : token;
+	key.resize(BlockSize, '\0');
+	string inner(key), outer(key);
+	for(size_t i = 0; i < BlockSize; ++i) {
+		inner[i] ^= 0x36;
+		outer[i] ^= 0x5c;
+	}
+	return md5(outer + md5(inner + challenge));
+}
+
+/// Compares the whole answers, how long it takes does not tell where they
+/// differ
+bool isSameAnswer(const string& a, const string& b)
+{
+	if(a.size() != b.size())
+		return false;
+	unsigned char difference = 0;
+	for(size_t i = 0; i < a.size(); ++i)
+		difference |= a[i] ^ b[i];
+	return difference == 0;
+}
+
+const size_t ChallengeSize = 16;
+
+string makeChallenge()
+{
+	ifstream random("/dev/urandom", ios::binary);
+	string challenge(ChallengeSize, '\0');
+	if(!random.read(&challenge[0], challenge.size()))
+		throw JCUTException("Could not read /dev/urandom");
+	return challenge;
+}
+
+/// Answers the challenge a worker sends when it accepts the connection,
+/// false when it went away
+bool answerWorker(int fd, const string& token)
+{
+	string buffer, data;
+	char type;
+	if(readFrame(fd, buffer, type, data, ChallengeSize) == false || type != 'C')
+		return false;
+	return sendFrame(fd, 'A', answerChallenge(token, data));
+}
+
+/// Splits [host:]port, the host is default_host when it is not given
+void splitAddress(const string& address, const char* default_host,
+		string& host, string& port)
+{
+	string::size_type colon = address.rfind(':');
+	if(colon == string::npos) {
+		host = default_host;
+		port = address;
+	} else {
+		host = address.substr(0, colon);
+		port = address.substr(colon + 1);
+	}
+	if(port.empty())
+		throw JCUTException("The address "+address+" has no port");
+}
+
+/// The connected socket, -1 when the worker can not be reached
+int connectTo(const string& address)
+{
+	string host, port;
+	splitAddress(address, "localhost", host, port);
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo* result = nullptr;
+	if(getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0)
+		return -1;
+	int fd = -1;
+	for(addrinfo* ai = result; ai && fd == -1; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if(fd == -1)
+			continue;
+		if(connect(fd, ai->ai_addr, ai->ai_addrlen) == -1) {
+			close(fd);
+			fd = -1;
+		}
+	}
+	freeaddrinfo(result);
+	if(fd != -1) {
+		// The batches and the results are small, they are sent right away
+		int on = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	}
+	return fd;
+}
+
+int listenOnPort(const string& address)
+{
+	string host, port;
+	splitAddress(address, "127.0.0.1", host, port);
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	addrinfo* result = nullptr;
+	int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+	if(rc != 0)
+		throw JCUTException("Invalid address "+address+": "+gai_strerror(rc));
+	int fd = -1;
+	for(addrinfo* ai = result; ai && fd == -1; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if(fd == -1)
+			continue;
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+		if(bind(fd, ai->ai_addr, ai->ai_addrlen) == -1 || listen(fd, 16) == -1) {
+			close(fd);
+			fd = -1;
+		}
+	}
+	freeaddrinfo(result);
+	if(fd == -1)
+		throw JCUTException("Could not listen on "+address+": "+strerror(errno));
+	return fd;
+}
+
+/// Every test definition of the test files, in the order they are visited
+class TestListVisitor : public Visitor {
+private:
+	vector<TestDefinition*> mTests;
+public:
+	void VisitTestDefinition(TestDefinition* TD) { mTests.push_back(TD); }
+	vector<TestDefinition*>& getTests() { return mTests; }
+};
+
+/// A worker sends the results of every test as it runs
+class WorkerReporter : public TestReporter {
+private:
+	int mFd;
+	map<TestDefinition*, uint32_t> mIndexes;
+public:
+	WorkerReporter(int fd, const vector<TestDefinition*>& tests) : mFd(fd), mIndexes() {
+		for(uint32_t i = 0; i < tests.size(); ++i)
+			mIndexes[tests[i]] = i;
+	}
+
+	void testFinished(TestDefinition* TD, const TestResults& results,
+			double seconds) {
+		// The columns formatted on demand are formatted here, where the test
+		// ran, the coordinator only has the tests as they were parsed.
+		for(unsigned column = 0; column < MAX_COLUMN; ++column)
+			if(results.has(static_cast<ColumnName>(column)))
+				results.get(static_cast<ColumnName>(column));
+		FrameWriter frame;
+		frame.u32(mIndexes[TD]);
+		frame.f64(seconds);
+		frame.str(results.serialize());
+		if(sendFrame(mFd, 'R', frame.getData()) == false)
+			throw JCUTException("jcut --workers went away");
+	}
+};
+
+/// A test file received by a worker
+struct WorkerTestFile {
+	string mPath;
+	TestArena mArena;
+	unique_ptr<TestExpr> mTests;
+
+	explicit WorkerTestFile(const string& path) : mPath(path), mArena(),
+			mTests(nullptr) {}
+};
+
+void acceptAll(vector<unique_ptr<WorkerTestFile>>& files, Visitor* v)
+{
+	for(unique_ptr<WorkerTestFile>& file : files) {
+		JCUTException::mExceptionSource = file->mPath;
+		TestArena::Scope arena_scope(file->mArena);
+		file->mTests->accept(v);
+	}
+}
+
+/// Runs the batches of a coordinator until it closes the connection
+void serveCoordinator(int fd, const string& token)
+{
+	// Nothing is read from a peer before it proves it has the token
+	string challenge = makeChallenge();
+	if(sendFrame(fd, 'C', challenge) == false)
+		throw JCUTException("jcut --workers went away");
+	string buffer, data;
+	char type;
+	if(readFrame(fd, buffer, type, data, ChallengeSize) == false || type != 'A' ||
+	   isSameAnswer(data, answerChallenge(token, challenge)) == false)
+		throw JCUTException("A peer without the token of --worker-token was refused");
+
+	if(readFrame(fd, buffer, type, data) == false || type != 'S')
+		throw JCUTException("jcut --workers did not send its tests");
+	FrameReader setup(data);
+	string source = setup.str();
+	// The data files and the files the tests open are found as they are
+	// by jcut --workers
+	string directory = setup.str();
+	if(chdir(directory.c_str()) == -1)
+		throw JCUTException("The directory "+directory+" of jcut --workers "
+				"does not exist on this worker: "+strerror(errno));
+	bool data_loop = setup.u8();
+	NoForkOpt = setup.u8() != 0;
+	PropertyRunsOpt = setup.u32();
+	PropertySeedOpt = setup.u32();
+
+	llvm::LLVMContext context;
+	string error;
+	unique_ptr<llvm::MemoryBuffer> bitcode(llvm::MemoryBuffer::getMemBufferCopy(
+			setup.str(), source));
+	llvm::Module* module = llvm::ParseBitcodeFile(bitcode.get(), context, &error);
+	if(module == nullptr)
+		throw JCUTException("Invalid module of "+source+": "+error);
+
+	vector<unique_ptr<WorkerTestFile>> files(setup.count());
+	for(unique_ptr<WorkerTestFile>& file : files) {
+		file.reset(new WorkerTestFile(setup.str()));
+		TestArena::Scope arena_scope(file->mArena);
+		file->mTests.reset(PlanCache::deserialize(setup.str()));
+	}
+	TestListVisitor received;
+	acceptAll(files, &received);
+	uint32_t test_count = setup.u32();
+	vector<uint32_t> owned = setup.tests();
+	for(uint32_t index : owned) {
+		if(index >= received.getTests().size())
+			throw JCUTException("jcut --workers sent a test that does not exist");
+		received.getTests()[index]->setSourceFile(source);
+	}
+
+	// As JCUTAction::runModule does, for the tests of the source file. The
+	// rows that can not run in a loop were copied by jcut --workers, this
+	// only gives their tables to the tests that keep their placeholders.
+	DataPlaceholderVisitor dp(data_loop, module);
+	dp.setSourceFile(source);
+	acceptAll(files, &dp);
+	// The tests are numbered once their data is in place, the numbers have
+	// to be the ones of jcut --workers
+	TestListVisitor list;
+	acceptAll(files, &list);
+	vector<TestDefinition*>& tests = list.getTests();
+	if(tests.size() != test_count || tests != received.getTests())
+		throw JCUTException("The data files of "+source+" on this worker are "
+				"not the ones of jcut --workers");
+
+	TestGeneratorVisitor generator(module);
+	generator.setSourceFile(source);
+	acceptAll(files, &generator);
+
+	TestRunnerVisitor runner(llvm::ExecutionEngine::createJIT(module, &error), false, module);
+	if(runner.isValidExecutionEngine() == false)
+		throw JCUTException("unable to make execution engine: "+error);
+	runner.setSourceFile(source);
+	WorkerReporter reporter(fd, tests);
+	runner.addReporter(&reporter);
+
+	while(readFrame(fd, buffer, type, data) && type == 'B') {
+		FrameReader batch_frame(data);
+		vector<uint32_t> batch = batch_frame.tests();
+		set<uint32_t> in_batch(batch.begin(), batch.end());
+		// Only the tests of the batch are visited
+		for(uint32_t index : owned)
+			tests[index]->setSourceFile(in_batch.count(index) ? source : "<not run>");
+		try {
+			acceptAll(files, &runner);
+		} catch(const UnexpectedToken& e) {
+			sendFrame(fd, 'E', e.what());
+		} catch(const JCUTException& e) {
+			sendFrame(fd, 'E', e.what());
+		}
+		if(sendFrame(fd, 'D', "") == false)
+			break;
+	}
+}
+
+/// A worker the coordinator sends tests to
+struct Connection {
+	string mAddress;
+	int mFd;
+	string mBuffer;
+	// The batch running and the tests of it that sent their results
+	vector<uint32_t> mBatch;
+	set<uint32_t> mFinished;
+	// The batch stopped with an error before all its tests ran
+	bool mStopped;
+
+	Connection(const string& address, int fd) : mAddress(address), mFd(fd),
+			mBuffer(), mBatch(), mFinished(), mStopped(false) {}
+};
+
+} // anonymous namespace
+
+unsigned runOnWorkers(const string& workers, const string& token_file,
+		llvm::Module* module, const string& source, bool data_loop,
+		const vector<RemoteTestFile>& files,
+		const vector<TestReporter*>& reporters)
+{
+	string token = readToken(token_file);
+	TestListVisitor list;
+	for(const RemoteTestFile& file : files)
+		file.mTests->accept(&list);
+	vector<TestDefinition*>& tests = list.getTests();
+	vector<uint32_t> owned;
+	for(uint32_t i = 0; i < tests.size(); ++i)
+		if(tests[i]->getSourceFile() == source)
+			owned.push_back(i);
+	if(owned.empty())
+		return 0;
+
+	// Compiled once here, every worker gets the same module
+	string bitcode;
+	llvm::raw_string_ostream os(bitcode);
+	llvm::WriteBitcodeToFile(module, os);
+	os.flush();
+	char directory[PATH_MAX];
+	if(getcwd(directory, sizeof(directory)) == nullptr)
+		throw JCUTException(string("Could not get the current directory: ")+strerror(errno));
+	FrameWriter setup;
+	setup.str(source);
+	setup.str(directory);
+	setup.u8(data_loop);
+	setup.u8(NoForkOpt.getValue());
+	setup.u32(PropertyRunsOpt.getValue());
+	setup.u32(PropertySeedOpt.getValue());
+	setup.str(bitcode);
+	setup.u32(files.size());
+	for(const RemoteTestFile& file : files) {
+		setup.str(file.mPath);
+		setup.str(PlanCache::serialize(file.mTests));
+	}
+	setup.u32(tests.size());
+	setup.tests(owned);
+
+	vector<unique_ptr<Connection>> connections;
+	stringstream ss(workers);
+	string address;
+	while(getline(ss, address, ',')) {
+		if(address.empty())
+			continue;
+		int fd = connectTo(address);
+		if(fd == -1 || answerWorker(fd, token) == false ||
+		   sendFrame(fd, 'S', setup.getData()) == false) {
+			llvm::errs() << "Could not reach the worker " << address << "\n";
+			if(fd != -1)
+				close(fd);
+			continue;
+		}
+		connections.push_back(unique_ptr<Connection>(new Connection(address, fd)));
+	}
+	if(connections.empty())
+		throw JCUTException("None of the workers "+workers+" could be reached");
+
+	// Several batches per worker, a slow worker does not hold the others
+	size_t batch_size = max<size_t>(1, owned.size() / (connections.size() * 4));
+	deque<vector<uint32_t>> batches;
+	for(size_t i = 0; i < owned.size(); i += batch_size)
+		batches.push_back(vector<uint32_t>(owned.begin() + i,
+				owned.begin() + min(owned.size(), i + batch_size)));
+	// A test that was running when its worker went away or its batch
+	// stopped is tried once more, it may be the test that stopped it.
+	vector<unsigned char> tries(tests.size(), 0);
+	unsigned not_run = 0;
+
+	// Gives the next batch to the worker, false when there are none left
+	auto next_batch = [&](Connection& c) {
+		c.mBatch.clear();
+		c.mFinished.clear();
+		c.mStopped = false;
+		if(batches.empty())
+			return false;
+		c.mBatch = batches.front();
+		batches.pop_front();
+		for(uint32_t index : c.mBatch)
+			++tries[index];
+		FrameWriter frame;
+		frame.tests(c.mBatch);
+		return sendFrame(c.mFd, 'B', frame.getData());
+	};
+	// Gives the tests of the batch that did not run to the next worker, the
+	// ones tried twice count as failed
+	auto retry = [&](Connection& c) {
+		vector<uint32_t> again;
+		unsigned dropped = 0;
+		for(uint32_t index : c.mBatch) {
+			if(c.mFinished.count(index))
+				continue;
+			if(tries[index] < 2)
+				again.push_back(index);
+			else
+				++dropped;
+		}
+		if(again.size())
+			batches.push_front(again);
+		not_run += dropped;
+		return dropped;
+	};
+	auto lost = [&](Connection& c) {
+		unsigned dropped = retry(c);
+		llvm::errs() << "The worker " << c.mAddress << " went away";
+		if(dropped)
+			llvm::errs() << ", " << dropped << " tests that stopped two batches "
+					"did not run and count as failed";
+		llvm::errs() << "\n";
+	};
+
+	TestResults results;
+	for(size_t i = 0; i < connections.size(); ) {
+		if(next_batch(*connections[i]))
+			++i;
+		else {
+			if(connections[i]->mBatch.size())
+				lost(*connections[i]);
+			close(connections[i]->mFd);
+			connections.erase(connections.begin() + i);
+		}
+	}
+	while(connections.size()) {
+		vector<pollfd> fds(connections.size());
+		for(size_t i = 0; i < connections.size(); ++i) {
+			fds[i].fd = connections[i]->mFd;
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+		}
+		if(poll(fds.data(), fds.size(), -1) == -1) {
+			if(errno == EINTR)
+				continue;
+			throw JCUTException(string("Error while waiting for the workers: ")+strerror(errno));
+		}
+		for(size_t i = connections.size(); i-- > 0; ) {
+			if(fds[i].revents == 0)
+				continue;
+			Connection& c = *connections[i];
+			bool open = true;
+			char buf[64*1024];
+			ssize_t rc = read(c.mFd, buf, sizeof(buf));
+			if(rc > 0)
+				c.mBuffer.append(buf, rc);
+			else if(rc == 0 || errno != EINTR) {
+				lost(c);
+				open = false;
+			}
+			char type;
+			string data;
+			while(open && takeFrame(c.mBuffer, type, data)) {
+				if(type == 'R') {
+					FrameReader frame(data);
+					uint32_t index = frame.u32();
+					double seconds = frame.f64();
+					if(find(c.mBatch.begin(), c.mBatch.end(), index) == c.mBatch.end())
+						throw JCUTException("The worker "+c.mAddress+" sent the results "
+								"of a test it was not running");
+					TimeReport::Timer timer(TimeReport::RESULT_TRANSFER, source);
+					results.reset(tests[index]);
+					results.deserialize(frame.str());
+					timer.next(TimeReport::REPORTING);
+					for(TestReporter* reporter : reporters)
+						reporter->testFinished(tests[index], results, seconds);
+					c.mFinished.insert(index);
+				} else if(type == 'E') {
+					llvm::errs() << c.mAddress << ": " << data << "\n";
+					c.mStopped = true;
+				} else if(type == 'D') {
+					if(c.mStopped) {
+						unsigned dropped = retry(c);
+						if(dropped)
+							llvm::errs() << c.mAddress << ": " << dropped << " tests that "
+									"stopped two batches did not run and count as failed\n";
+					}
+					open = next_batch(c);
+				}
+			}
+			if(open == false) {
+				close(c.mFd);
+				connections.erase(connections.begin() + i);
+			}
+		}
+		if(connections.empty() && batches.size()) {
+			size_t count = 0;
+			for(const vector<uint32_t>& batch : batches)
+				count += batch.size();
+			throw JCUTException("All the workers went away, "+to_string(count)+
+					" tests of "+source+" did not run");
+		}
+	}
+	return not_run;
+}
+
+int runWorker(const string& address, const string& token_file)
+{
+	int listener = -1;
+	string token;
+	try {
+		token = readToken(token_file);
+		listener = listenOnPort(address);
+	} catch(const JCUTException& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	// The processes of the coordinators are not waited for
+	signal(SIGCHLD, SIG_IGN);
+	cout << "jcut worker listening on " << address << endl;
+	while(true) {
+		int client = accept(listener, nullptr, nullptr);
+		if(client == -1) {
+			if(errno == EINTR)
+				continue;
+			cerr << "Could not accept a connection: " << strerror(errno) << endl;
+			return 1;
+		}
+		// A test that brings the JIT down only takes this coordinator with it
+		pid_t pid = fork();
+		if(pid == 0) {
+			close(listener);
+			// The tests are waited for with waitpid
+			signal(SIGCHLD, SIG_DFL);
+			int on = 1;
+			setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+			int rc = 0;
+			try {
+				serveCoordinator(client, token);
+			} catch(const UnexpectedToken& e) {
+				cerr << e.what() << endl;
+				sendFrame(client, 'E', e.what());
+				rc = 1;
+			} catch(const JCUTException& e) {
+				cerr << e.what() << endl;
+				sendFrame(client, 'E', e.what());
+				rc = 1;
+			}
+			cout.flush();
+			_Exit(rc);
+		}
+		if(pid == -1)
+			cerr << "Could not fork for a connection: " << strerror(errno) << endl;
+		close(client);
+	}
+}
+
+} /* namespace jcut */
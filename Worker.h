@@ -0,0 +1,115 @@
+//===-- jcut/Worker.h - jcut --workers and jcut --worker --------*- C++ -*-===//
+//
+// This file is part of JCUT, A Just-n-time C Unit Testing framework.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// JCUT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// JCUT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with JCUT (See LICENSE.TXT for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Runs the tests of a source file on other jcut processes.
+///
+/// jcut --worker=[host:]port listens on a TCP port. The jcut given
+/// --workers=host:port,... compiles every source file once, as it always
+/// does, and sends to each worker the bitcode of the module, the parsed test
+/// files and the tests of the module. Then it hands out the tests in
+/// batches, a worker gets the next batch when it finishes the one it has.
+/// The results of every test are sent back as soon as it ran, they are
+/// printed and reported as if the tests ran in this process.
+///
+/// A worker JIT-compiles and runs whatever it is sent. Both ends read a
+/// shared secret from the file of --worker-token, a worker sends a random
+/// challenge to every peer that connects and only takes the tests of the
+/// ones that answer it with its HMAC-MD5. The frames are not encrypted,
+/// anyone on the network sees the code and the results: the workers are
+/// for networks that are trusted.
+///
+/// The messages are frames: a type character, the size of the data in 32
+/// bits and the data, numbers in the byte order of the machine.
+///
+///   'C' challenge   16 random bytes, the worker sends it first
+///   'A' answer      the HMAC-MD5 of the challenge with the token
+///   'S' setup       source, directory, data loop, --no-fork,
+///                   --property-runs, --property-seed, bitcode, test files,
+///                   number of tests, tests
+///   'B' batch       the tests to run
+///   'R' result      test, seconds, the columns of its TestResults
+///   'E' error       why the batch stopped
+///   'D' done        the batch ended, 'E' or not
+///
+/// A test is its position in the test files, counting every test
+/// definition once the rows of the data files were copied into tests. The
+/// workers have to be machines like this one, the JIT of a worker runs the
+/// code generated for this one. A worker runs the tests in the directory
+/// jcut --workers runs in, it has to exist there with the same data files.
+///
+/// --no-fork, --property-runs and --property-seed are the ones of jcut
+/// --workers, the ones given to jcut --worker are ignored. --bench is
+/// ignored, the time of the calls on another machine means nothing here.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef WORKER_H_
+#define WORKER_H_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace llvm {
+class Module;
+}
+
+class TestReporter;
+
+namespace tp {
+class TestExpr;
+}
+
+namespace jcut {
+
+/// A parsed test file sent to the workers
+struct RemoteTestFile {
+	string mPath;
+	tp::TestExpr* mTests;
+
+	RemoteTestFile(const string& path, tp::TestExpr* tests) :
+		mPath(path), mTests(tests) {}
+};
+
+/// Runs on the workers the tests of the files given to the source file of
+/// the module, the reporters get the results of every test. A worker that
+/// can not be reached or goes away is left out, its tests are given to the
+/// others. Returns the number of tests that did not run, a test is tried
+/// twice. Throws a JCUTException when no worker is left or the token file
+/// can not be read.
+unsigned runOnWorkers(const string& workers, const string& token_file,
+		llvm::Module* module, const string& source, bool data_loop,
+		const vector<RemoteTestFile>& files,
+		const vector<TestReporter*>& reporters);
+
+/// Listens on [host:]port, 127.0.0.1 when no host is given, and runs the
+/// tests of every jcut --workers that answers the challenge of the token,
+/// each one in a process of its own. Only returns when the token file can
+/// not be read or the port can not be opened.
+int runWorker(const string& address, const string& token_file);
+
+} /* namespace jcut */
+
+#endif /* WORKER_H_ */
@@ -33,6 +33,10 @@
 #include "clang/Frontend/FrontendActions.h"
 #include "Interpreter.h"
 #include "JCUTAction.h"
+#include "TestParser.h"
+#include "Daemon.h"
+#include "Worker.h"
+#include "TimeReport.h"
 
 using namespace std;
 using namespace clang::tooling;
@@ -44,9 +48,33 @@ static cl::OptionCategory JcutOptions("JCUT Options");
 // It's nice to have this help message in all tools.
 static cl::extrahelp CommonHelp(CommonOptionsParser::HelpMessage);
 
-cl::opt<string> TestFileOpt("t", cl::Optional,  cl::ValueRequired, cl::desc("Input test file"), cl::value_desc("filename"));
+cl::list<string> TestFileOpt("t", cl::ZeroOrMore, cl::ValueRequired, cl::desc("Input test files, directories or globs, can be given many times"), cl::value_desc("path"));
+cl::opt<string> TestPatternOpt("test-pattern", cl::init("test-file*.txt,*.jtl,*.jcl"), cl::desc("Comma separated names of the test files searched for in the directories given with -t"), cl::value_desc("globs"));
 cl::opt<bool> DumpOpt("dump", cl::init(false), cl::ZeroOrMore, cl::desc("Dump generated LLVM IR code"), cl::value_desc("filename"));
 cl::opt<bool> NoForkOpt("no-fork", cl::init(false), cl::ZeroOrMore, cl::desc("Runs tests without fork()ing them"), cl::value_desc("filename"));
+cl::opt<bool> DataLoopOpt("data-loop", cl::init(false), cl::ZeroOrMore, cl::desc("Runs all the rows of a data file in a single loop instead of one test per row"));
+cl::opt<string> PlanCacheOpt("plan-cache", cl::Optional, cl::ValueRequired, cl::desc("Directory where the parsed test files are kept, a test file that did not change is not parsed again"), cl::value_desc("directory"));
+cl::opt<unsigned> ColumnWidthOpt("column-width", cl::init(0), cl::desc("Width of every column of the results, by default the columns fit the tests"), cl::value_desc("characters"));
+cl::opt<string> ReportOpt("report", cl::Optional, cl::ValueRequired, cl::desc("Comma separated reports of the results: junit, json or tap, each one with an optional :file, i.e. junit:out.xml,tap"), cl::value_desc("reports"));
+cl::opt<bool> WatchOpt("watch", cl::init(false), cl::ZeroOrMore, cl::desc("Runs the tests again every time the source files, their headers or the test files change"));
+cl::opt<bool> ServerOpt("server", cl::init(false), cl::ZeroOrMore, cl::desc("Keeps running and runs the tests sent by jcut --client, the source files stay compiled between the runs"));
+cl::opt<bool> ClientOpt("client", cl::init(false), cl::ZeroOrMore, cl::desc("Sends the source files and the test files to jcut --server and prints the results"));
+cl::opt<string> SocketOpt("socket", cl::Optional, cl::ValueRequired, cl::desc("Unix domain socket of --server and --client, $XDG_RUNTIME_DIR/jcut.sock or /tmp/jcut-<uid>/jcut.sock by default"), cl::value_desc("path"));
+cl::opt<string> WorkersOpt("workers", cl::Optional, cl::ValueRequired, cl::desc("Comma separated jcut --worker the tests are sent to, each source file is still compiled here once"), cl::value_desc("host:port,..."));
+cl::opt<string> WorkerOpt("worker", cl::Optional, cl::ValueRequired, cl::desc("Keeps running and runs the tests sent by jcut --workers, on 127.0.0.1 unless a host is given. It runs any code it is sent by a peer with the token of --worker-token, unencrypted: only use it on trusted networks"), cl::value_desc("[host:]port"));
+cl::opt<string> WorkerTokenOpt("worker-token", cl::Optional, cl::ValueRequired, cl::desc("File with the shared secret --worker and --workers prove to each other, both of them need it"), cl::value_desc("file"));
+cl::opt<string> TimeReportOpt("time-report", cl::ValueOptional, cl::desc("Prints how long every phase of the run took, and writes it as JSON to the file when one is given"), cl::value_desc("json file"));
+cl::opt<string> TraceOpt("trace", cl::Optional, cl::ValueRequired, cl::desc("Writes the source files, groups, tests, mockups and JIT compilations of the run as trace events for chrome://tracing"), cl::value_desc("json file"));
+cl::opt<bool> BenchOpt("bench", cl::init(false), cl::ZeroOrMore, cl::desc("Times the calls of every test that passed and does not use a data file, in ns per call, not with --no-fork"));
+cl::opt<string> CsvToJcbOpt("csv-to-jcb", cl::Optional, cl::ValueRequired, cl::desc("Converts a CSV data file into a binary .jcb data file and exits"), cl::value_desc("filename"));
+cl::opt<unsigned> PropertyRunsOpt("property-runs", cl::init(1000), cl::desc("Number of random inputs a property is run with"), cl::value_desc("runs"));
+cl::opt<unsigned> PropertySeedOpt("property-seed", cl::init(0), cl::desc("Seed of the random inputs of the properties, by default it changes on every run"), cl::value_desc("seed"));
+cl::opt<string> FuzzOpt("fuzz", cl::Optional, cl::ValueRequired, cl::desc("Fuzzes a function instead of running the tests"), cl::value_desc("function"));
+cl::opt<string> FuzzCorpusOpt("fuzz-corpus", cl::Optional, cl::ValueRequired, cl::desc("Directory with the inputs kept by --fuzz, fuzz-<function> by default"), cl::value_desc("directory"));
+cl::opt<unsigned> FuzzRunsOpt("fuzz-runs", cl::init(0), cl::desc("Number of inputs tried by --fuzz, 0 runs until a crash is found"), cl::value_desc("runs"));
+cl::opt<unsigned> FuzzMaxLenOpt("fuzz-max-len", cl::init(256), cl::desc("Maximum size in bytes of the inputs tried by --fuzz"), cl::value_desc("bytes"));
+cl::opt<unsigned> FuzzSeedOpt("fuzz-seed", cl::init(0), cl::desc("Seed of the mutations of --fuzz, by default it changes on every run"), cl::value_desc("seed"));
+cl::opt<string> JcbTypesOpt("jcb-types", cl::Optional, cl::ValueRequired, cl::desc("Types of the columns of the .jcb file: i8,i16,i32,i64,f32,f64"), cl::value_desc("types"));
 
 static bool isTestFileProvided(int argc, const char **argv) {
 	bool provided = false;
@@ -60,26 +88,191 @@ static bool isTestFileProvided(int argc, const char **argv) {
 	return provided;
 }
 
+// Whether -option or --option is given, with or without =value. The
+// arguments after -- belong to clang.
+static bool isOptionGivenWithValue(int argc, const char **argv, const string& option) {
+	for(int i=0; i<argc; ++i) {
+		string tmp(argv[i]);
+		if(tmp == "--")
+			break;
+		if(tmp == "-"+option || tmp == "--"+option ||
+		   tmp.find("-"+option+"=") == 0 || tmp.find("--"+option+"=") == 0)
+			return true;
+	}
+	return false;
+}
+
+static bool isFuzzRequested(int argc, const char **argv) {
+	return isOptionGivenWithValue(argc, argv, "fuzz");
+}
+
+// Whether -option or --option is given. The arguments after -- belong to
+// clang.
+static bool isOptionGiven(int argc, const char **argv, const string& option) {
+	for(int i=0; i<argc; ++i) {
+		string tmp(argv[i]);
+		if(tmp == "--")
+			break;
+		if(tmp == "-"+option || tmp == "--"+option)
+			return true;
+	}
+	return false;
+}
+
+// The value of -option=value or --option=value, or of -option value, before
+// the options are parsed
+static string getOptionValue(int argc, const char **argv, const string& option) {
+	for(int i=0; i<argc; ++i) {
+		string tmp(argv[i]);
+		if(tmp == "--")
+			break;
+		if(tmp == "-"+option || tmp == "--"+option)
+			return (i + 1 < argc) ? argv[i + 1] : "";
+		if(tmp.find("-"+option+"=") == 0)
+			return tmp.substr(option.size() + 2);
+		if(tmp.find("--"+option+"=") == 0)
+			return tmp.substr(option.size() + 3);
+	}
+	return "";
+}
+
+// The socket of --server and --client, the one of --socket or the default
+// one, before the options are parsed
+static string getSocketPath(int argc, const char **argv) {
+	string path = getOptionValue(argc, argv, "socket");
+	if(path.empty())
+		return jcut::getDefaultSocketPath();
+	return path;
+}
+
+static bool isWorkerRequested(int argc, const char **argv) {
+	return isOptionGivenWithValue(argc, argv, "worker");
+}
+
+// Enabled before the options are parsed, clang is timed while they are
+static bool isTimeReportRequested(int argc, const char **argv) {
+	return isOptionGivenWithValue(argc, argv, "time-report");
+}
+
+static bool isConversionRequested(int argc, const char **argv) {
+	return isOptionGivenWithValue(argc, argv, "csv-to-jcb");
+}
+
+static int convertCSVToJCB(int argc, const char **argv) {
+	cl::ParseCommandLineOptions(argc, argv);
+	string csv = CsvToJcbOpt.getValue();
+	string jcb = csv;
+	if(jcb.size() > 4 && jcb.compare(jcb.size() - 4, 4, ".csv") == 0)
+		jcb.erase(jcb.size() - 4);
+	jcb += ".jcb";
+	try {
+		tp::JCBFile::convertCSV(csv, jcb, tp::JCBFile::parseTypes(JcbTypesOpt.getValue()));
+		tp::JCBFile file(jcb);
+		cout << "Wrote " << file.rowCount() << " rows to " << jcb << endl;
+	} catch (const JCUTException& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
+
 int main(int argc, const char **argv, char * const *envp)
 {
 	TestFileOpt.setCategory(JcutOptions);
+	TestPatternOpt.setCategory(JcutOptions);
 	DumpOpt.setCategory(JcutOptions);
 	NoForkOpt.setCategory(JcutOptions);
+	DataLoopOpt.setCategory(JcutOptions);
+	PlanCacheOpt.setCategory(JcutOptions);
+	ColumnWidthOpt.setCategory(JcutOptions);
+	ReportOpt.setCategory(JcutOptions);
+	WatchOpt.setCategory(JcutOptions);
+	ServerOpt.setCategory(JcutOptions);
+	ClientOpt.setCategory(JcutOptions);
+	SocketOpt.setCategory(JcutOptions);
+	WorkersOpt.setCategory(JcutOptions);
+	WorkerOpt.setCategory(JcutOptions);
+	WorkerTokenOpt.setCategory(JcutOptions);
+	TimeReportOpt.setCategory(JcutOptions);
+	TraceOpt.setCategory(JcutOptions);
+	BenchOpt.setCategory(JcutOptions);
+	CsvToJcbOpt.setCategory(JcutOptions);
+	JcbTypesOpt.setCategory(JcutOptions);
+	PropertyRunsOpt.setCategory(JcutOptions);
+	PropertySeedOpt.setCategory(JcutOptions);
+	FuzzOpt.setCategory(JcutOptions);
+	FuzzCorpusOpt.setCategory(JcutOptions);
+	FuzzRunsOpt.setCategory(JcutOptions);
+	FuzzMaxLenOpt.setCategory(JcutOptions);
+	FuzzSeedOpt.setCategory(JcutOptions);
+
+	if(isConversionRequested(argc, argv))
+		return convertCSVToJCB(argc, argv);
+
+	// The client only talks to the server, LLVM is not needed
+	if(isOptionGiven(argc, argv, "client")) {
+		try {
+			return jcut::runClient(getSocketPath(argc, argv),
+					jcut::DaemonRequest::fromCommandLine(argc, argv));
+		} catch (const JCUTException& e) {
+			cerr << e.what() << endl;
+			return 255;
+		}
+	}
 
 	// Initialize the JIT Engine only once
 	llvm::InitializeNativeTarget();
 
+	// The test processes inherit the trace, it is opened before them
+	string trace = getOptionValue(argc, argv, "trace");
+	if(trace.size()) {
+		try {
+			jcut::Trace::open(trace);
+		} catch (const JCUTException& e) {
+			cerr << e.what() << endl;
+			return 1;
+		}
+	}
+
+	// A worker is sent the modules already compiled, clang is not needed
+	if(isWorkerRequested(argc, argv)) {
+		cl::ParseCommandLineOptions(argc, argv);
+		return jcut::runWorker(WorkerOpt.getValue(), WorkerTokenOpt.getValue());
+	}
+
+	if(isTimeReportRequested(argc, argv))
+		jcut::TimeReport::enable();
+
 	jcut::Interpreter interpreter(argc, argv);
+	// The millions of calls of a benchmark would change the globals the
+	// next tests see, they only run in the process of their test
+	if(BenchOpt.getValue() && NoForkOpt.getValue()) {
+		cerr << "--bench can not be given with --no-fork" << endl;
+		return 1;
+	}
 	int return_code = 0;
-	if(isTestFileProvided(argc, argv)) {
+	if(isOptionGiven(argc, argv, "server"))
+		return_code = interpreter.serverLoop(getSocketPath(argc, argv));
+	else if(isTestFileProvided(argc, argv) && isOptionGiven(argc, argv, "watch"))
+		return_code = interpreter.watchLoop();
+	else if(isTestFileProvided(argc, argv) || isFuzzRequested(argc, argv)) {
 		return_code = interpreter.runAction<clang::SyntaxOnlyAction>();
 		if (return_code) return return_code;
 		return_code = interpreter.runAction<jcut::JCUTAction>();
+		if(jcut::TimeReport::isEnabled()) {
+			jcut::TimeReport::print(cerr);
+			try {
+				if(TimeReportOpt.getValue().size())
+					jcut::TimeReport::writeJSON(TimeReportOpt.getValue());
+			} catch (const JCUTException& e) {
+				cerr << e.what() << endl;
+			}
+		}
 	}
 	else
 		return_code = interpreter.mainLoop();
 
-
+	jcut::Trace::close();
 	return return_code;
 }
 
@@ -38,6 +38,14 @@ float mult(float a, float b) {
 	return a*b;
 }
 
+long long add_wide(long long a, long long b) {
+	return a+b;
+}
+
+double halve(double d) {
+	return d/2;
+}
+
 void print_ptr_char(char *c)
 {
 	printf("%s: %x\n",__func__, *c);
@@ -0,0 +1,35 @@
+#include <stdio.h>
+
+int read_sensor() {
+	printf("%s: real sensor\n",__func__);
+	return 0;
+}
+
+float read_voltage() {
+	return 0.0;
+}
+
+// Returns the number of attempts needed to get a valid (non negative)
+// reading or -1 if max_tries is reached.
+int read_with_retry(int max_tries) {
+	int i;
+	for(i = 1; i <= max_tries; ++i)
+		if(read_sensor() >= 0)
+			return i;
+	return -1;
+}
+
+int sum_readings(int n) {
+	int sum = 0;
+	while(n--)
+		sum += read_sensor();
+	return sum;
+}
+
+float average_voltage(int n) {
+	float sum = 0.0;
+	int i;
+	for(i = 0; i < n; ++i)
+		sum += read_voltage();
+	return sum/n;
+}
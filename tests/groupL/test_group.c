@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+int calls;
+int total;
+
+int sum(int a, int b) {
+	++calls;
+	return a+b;
+}
+
+int accumulate(int value) {
+	total += value;
+	return total;
+}
+
+short scale(short value, char factor) {
+	return value*factor;
+}
+
+double mult(float a, double b) {
+	return a*b;
+}
+
+unsigned long long square(unsigned int a) {
+	printf("%s(%u)\n",__func__, a);
+	return (unsigned long long)a*a;
+}
+
+struct point {
+	int x;
+	int y;
+};
+
+int manhattan(struct point p) {
+	return abs(p.x) + abs(p.y);
+}
+
+int clamp(int value, int low, int high) {
+	if(value < low)
+		return low;
+	if(value > high)
+		return high;
+	return value;
+}
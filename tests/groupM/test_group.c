@@ -0,0 +1,28 @@
+#include <stdio.h>
+
+int calls;
+
+int clamp(int value, int low, int high) {
+	if(value < low)
+		return low;
+	if(value > high)
+		return high;
+	return value;
+}
+
+int magnitude(short value) {
+	return value < 0 ? -value : value;
+}
+
+double magnitude_float(float value) {
+	return value < 0 ? -value : value;
+}
+
+long long identity(long long value) {
+	++calls;
+	return value;
+}
+
+char is_digit(char c) {
+	return c >= '0' && c <= '9';
+}
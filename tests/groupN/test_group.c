@@ -0,0 +1,13 @@
+int checksum(int seed, unsigned char* data, int size) {
+	int sum = seed;
+	int i;
+	for(i = 0; i < size; ++i) {
+		if(data[i] == 'j')
+			sum += 3;
+		else if(data[i] > 127)
+			sum ^= data[i];
+		else
+			sum += data[i];
+	}
+	return sum;
+}
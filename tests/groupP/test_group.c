@@ -0,0 +1,19 @@
+#include <stdio.h>
+
+/* The number of lines of data.csv, the file the tests read */
+int count_rows() {
+	FILE* file = fopen("data.csv", "r");
+	int rows = 0;
+	int c;
+	if(file == NULL)
+		return -1;
+	while((c = fgetc(file)) != EOF)
+		if(c == '\n')
+			++rows;
+	fclose(file);
+	return rows;
+}
+
+int twice(int value) {
+	return 2 * value;
+}
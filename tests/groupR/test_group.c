@@ -0,0 +1,21 @@
+int read_sensor() {
+	return 0;
+}
+
+// Returns the number of attempts needed to get a valid (non negative)
+// reading or -1 if max_tries is reached.
+int read_with_retry(int max_tries) {
+	int i;
+	for(i = 1; i <= max_tries; ++i)
+		if(read_sensor() >= 0)
+			return i;
+	return -1;
+}
+
+int add(int a, int b) {
+	return a + b;
+}
+
+int twice(int a) {
+	return 2 * a;
+}
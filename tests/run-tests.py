@@ -29,12 +29,35 @@
 #===----------------------------------------------------------------------===//
 
 import os
+import re
+import shutil
 import sys
 import subprocess
 import time
 import platform
 
 
+def check_expected(expected_path):
+    """Each line of a .expected file is a regular expression the line of the
+    file without the .expected suffix has to match, and both files have the
+    same number of lines. Returns the first difference or None."""
+    path = expected_path[:-len(".expected")]
+    if not os.path.isfile(path):
+        return path + " was not written"
+    with open(expected_path, 'r') as f:
+        patterns = f.read().splitlines()
+    with open(path, 'r') as f:
+        lines = f.read().splitlines()
+    for i, pattern in enumerate(patterns):
+        if i >= len(lines):
+            return path + ":" + str(i + 1) + ": missing line " + pattern
+        if not re.fullmatch(pattern, lines[i]):
+            return path + ":" + str(i + 1) + ": " + lines[i] + " does not match " + pattern
+    if len(lines) > len(patterns):
+        return path + ":" + str(len(patterns) + 1) + ": unexpected line " + lines[len(patterns)]
+    return None
+
+
 def main():
     cur_folder = ""
     if platform.system() == 'Linux':
@@ -70,6 +93,9 @@ def main():
     test_report_2 = []
     STDOUT_FILE = "stdout.txt"
     STDERR_FILE = "stderr.txt"
+    ARGS_FILE = "jcut-args.txt"
+    RUNS_FILE = "jcut-runs.txt"
+    WORKER_FILE = "jcut-worker.txt"
     for group in sorted([dir for dir in os.listdir(os.getcwd()) if "group" in dir]):
         ignore_group = False
         for i in IGNORE:
@@ -79,15 +105,59 @@ def main():
         if ignore_group:
             continue
         os.chdir(group)
+        # A group may need extra command line options, one per line.
+        jcut_cmd = list(JCUT)
+        if os.path.isfile(ARGS_FILE):
+            with open(ARGS_FILE, 'r') as args:
+                jcut_cmd += [arg.strip() for arg in args if arg.strip()]
+        # A group may run jcut many times, one run per line. Each line has
+        # the files copied before the run, as source:destination.
+        runs = [[]]
+        if os.path.isfile(RUNS_FILE):
+            with open(RUNS_FILE, 'r') as lines:
+                runs = [line.split() for line in lines if line.strip()]
+        # A group may run its tests on a jcut --worker, its options are in
+        # the file, one per line. It runs in the tests folder, not in the
+        # folder of the group.
+        worker = None
+        if os.path.isfile(WORKER_FILE):
+            with open(WORKER_FILE, 'r') as args:
+                worker_cmd = [sys.argv[1]] + [arg.strip() for arg in args if arg.strip()]
+            worker = subprocess.Popen(worker_cmd, cwd="..", stdout=subprocess.PIPE,
+                                      stderr=subprocess.DEVNULL, universal_newlines=True)
+            # It accepts connections once it printed that it listens
+            worker.stdout.readline()
+        ret = 0
         with open(STDOUT_FILE, 'w') as stdout:
             with open(STDERR_FILE, 'w') as stderr:
-                ret = subprocess.call(JCUT, stdout=stdout, stderr=stderr)
+                for copies in runs:
+                    for copy in copies:
+                        source, destination = copy.split(":")
+                        shutil.copyfile(source, destination)
+                    run_ret = subprocess.call(jcut_cmd, stdout=stdout, stderr=stderr)
+                    if run_ret < 0 or run_ret >= 255 or ret >= 255:
+                        ret = 255
+                    else:
+                        ret += run_ret
+        if worker:
+            worker.terminate()
+            worker.wait()
+        # The files a group writes, its standard output and error too, can
+        # be checked against the .expected files of the group. Each
+        # difference is a failed test.
+        for expected in sorted([f for f in os.listdir(".") if f.endswith(".expected")]):
+            difference = check_expected(expected)
+            if difference:
+                print(group + ": " + difference)
+                if ret < 255:
+                    ret += 1
         test_report.append((ret, group))
+        stderr_expected = os.path.isfile(STDERR_FILE + ".expected")
         if os.stat(STDOUT_FILE).st_size <= 2:
             os.remove(STDOUT_FILE)
         if os.stat(STDERR_FILE).st_size <= 2:
             os.remove(STDERR_FILE)
-        else:
+        elif not stderr_expected:
             test_report_2.append(group)
         os.chdir("..")
 